@@ -0,0 +1,30 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Tabulate elements on simplices at points given by their barycentric
+# coordinates, either by converting them to reference Cartesian coordinates
+# first, or by passing them to FiniteElement.tabulate directly with
+# Coordinates.barycentric.
+#
+# Usage: python3 bench_barycentric.py [npoints]
+
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+print(f"{'element':>28} {'nderiv':>6} {'convert':>9} {'direct':>9} {'speedup':>8}")
+for cell in ["interval", "triangle", "tetrahedron"]:
+    for degree in [1, 3, 6]:
+        element = libtab.create_element("Lagrange", cell, degree)
+        tdim = len(libtab.geometry(element.cell_type)[0])
+        lam = np.random.rand(npoints, tdim + 1)
+        lam /= np.sum(lam, axis=1, keepdims=True)
+        for nd in (0, 1):
+            t0 = best_time(lambda: element.tabulate(nd, np.ascontiguousarray(lam[:, 1:])))
+            t1 = best_time(lambda: element.tabulate(nd, lam, coordinates=libtab.Coordinates.barycentric))
+            print(f"{'Lagrange ' + cell + ' ' + str(degree):>28} {nd:6} {t0:8.4f}s {t1:8.4f}s {t0 / t1:7.2f}x")
@@ -0,0 +1,39 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Tabulate an element at a small set of points on each of many cells, with
+# one FiniteElement.tabulate call per cell and with one
+# FiniteElement.tabulate_batch call for all cells, both for point sets of
+# the same size (a batch axis) and for point sets of varying size (ragged,
+# with offsets).
+#
+# Usage: python3 bench_batch.py [ncells]
+
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+ncells = int(sys.argv[1]) if len(sys.argv) > 1 else 10000
+print(f"{'element':>32} {'points':>7} {'loop':>9} {'batch':>9} {'ragged':>9} {'speedup':>8}")
+for family, cell, degree in [("Lagrange", "triangle", 1), ("Lagrange", "triangle", 3),
+                             ("Lagrange", "tetrahedron", 2), ("Nedelec 1st kind H(curl)", "tetrahedron", 1)]:
+    element = libtab.create_element(family, cell, degree)
+    tdim = len(libtab.geometry(element.cell_type)[0])
+    for npts in (1, 4, 16):
+        pts = np.random.rand(ncells, npts, tdim) / tdim
+
+        # Ragged: between 1 and 2 * npts - 1 points per cell
+        sizes = np.random.randint(1, 2 * npts, ncells) if npts > 1 else np.ones(ncells, dtype=int)
+        offsets = np.concatenate([[0], np.cumsum(sizes)])
+        rpts = np.random.rand(offsets[-1], tdim) / tdim
+
+        t0 = best_time(lambda: [element.tabulate(1, p) for p in pts])
+        t1 = best_time(lambda: element.tabulate_batch(1, pts))
+        t2 = best_time(lambda: element.tabulate_batch(1, rpts, offsets))
+
+        name = f"{family} {cell} {degree}"
+        print(f"{name:>32} {npts:7} {t0:8.4f}s {t1:8.4f}s {t2:8.4f}s {t0 / t1:7.1f}x")
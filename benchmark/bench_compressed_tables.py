@@ -0,0 +1,46 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Accuracy and speed of reference tables stored with 16 bits per value.
+# For each element and degree, the tables of the basis functions and their
+# first derivatives at the quadrature points are compressed in each
+# format. The largest error of a value (relative to the largest value of
+# the table) and of the values of random functions on a batch of cells is
+# reported, together with the memory saved and the time to evaluate the
+# functions compared with the tables in double precision.
+#
+# Usage: python3 bench_compressed_tables.py [ncells]
+
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+ncells = int(sys.argv[1]) if len(sys.argv) > 1 else 1000
+cases = [("Lagrange", "triangle", d) for d in (1, 2, 4, 6, 8)] \
+    + [("Lagrange", "tetrahedron", d) for d in (1, 2, 3, 4, 5)] \
+    + [("Nedelec 1st kind H(curl)", "tetrahedron", d) for d in (1, 2, 3)] \
+    + [("Lagrange", "hexahedron", d) for d in (1, 2, 3)]
+formats = [libtab.CompressedTable.Format.float16, libtab.CompressedTable.Format.bfloat16,
+           libtab.CompressedTable.Format.scaled_int16]
+
+print(f"{'element':>32} {'format':>13} {'table error':>12} {'value error':>12} {'memory':>7} {'time':>8}")
+for family, cell, degree in cases:
+    element = libtab.create_element(family, cell, degree)
+    pts, wts = libtab.make_quadrature(element.cell_type, degree + 2)
+    tables = element.tabulate(1, pts)
+    u = np.random.rand(element.dim, ncells)
+
+    exact = [t @ u for t in tables]
+    t0 = best_time(lambda: [t @ u for t in tables])
+    name = f"{family} {cell} {degree}"
+    for format in formats:
+        compressed = [libtab.CompressedTable(t, format) for t in tables]
+        table_error = max(np.max(np.abs(c.expand() - t)) / np.max(np.abs(t)) for c, t in zip(compressed, tables))
+        value_error = max(np.max(np.abs(c.contract(u) - e)) / np.max(np.abs(e)) for c, e in zip(compressed, exact))
+        memory = sum(c.memory_usage for c in compressed) / sum(t.nbytes for t in tables)
+        t1 = best_time(lambda: [c.contract(u) for c in compressed])
+        print(f"{name:>32} {format.name:>13} {table_error:12.2e} {value_error:12.2e} {memory:6.2f}x {t1 / t0:7.2f}x")
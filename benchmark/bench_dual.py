@@ -0,0 +1,61 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# First derivatives of the basis functions with respect to the point
+# coordinates, by forward-mode automatic differentiation with dual numbers
+# (FiniteElement.tabulate_dual, one pass) and by central finite differences
+# (2 * tdim + 1 calls to FiniteElement.tabulate with nderiv = 0). The time
+# of each, relative to the analytic derivatives of tabulate(1, points), and
+# the largest error of the derivatives are reported.
+#
+# The dual numbers are computed from tabulate(1, points) by the chain rule,
+# so they are not faster than the finite differences. Their derivatives are
+# exact to rounding (with respect to whatever the points are seeded with),
+# whereas the finite differences carry a truncation error.
+#
+# Usage: python3 bench_dual.py [npoints]
+
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+def finite_differences(element, pts, h=1e-6):
+    tables = [element.tabulate(0, pts)[0]]
+    for k in range(pts.shape[1]):
+        dx = np.zeros(pts.shape[1])
+        dx[k] = h
+        plus = element.tabulate(0, pts + dx)[0]
+        minus = element.tabulate(0, pts - dx)[0]
+        tables.append((plus - minus) / (2 * h))
+    return tables
+
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 1000
+cases = [("Lagrange", "triangle", d) for d in (1, 2, 4, 6)] \
+    + [("Lagrange", "tetrahedron", d) for d in (1, 2, 3, 4)] \
+    + [("Nedelec 1st kind H(curl)", "tetrahedron", d) for d in (1, 2, 3)] \
+    + [("Lagrange", "hexahedron", d) for d in (1, 2, 3)]
+
+print(f"{'element':>32} {'exact':>9} {'dual':>8} {'fd':>8} {'dual error':>11} {'fd error':>9}")
+for family, cell, degree in cases:
+    element = libtab.create_element(family, cell, degree)
+    tdim = len(libtab.geometry(element.cell_type)[0])
+    # Points in the interior, so that the finite differences stay inside
+    # the cell
+    pts = 0.1 + 0.8 * np.random.rand(npoints, tdim) / tdim
+
+    exact = element.tabulate(1, pts)
+    t0 = best_time(lambda: element.tabulate(1, pts))
+    t1 = best_time(lambda: element.tabulate_dual(pts))
+    t2 = best_time(lambda: finite_differences(element, pts))
+
+    scale = max(np.max(np.abs(e)) for e in exact[1:])
+    dual_error = max(np.max(np.abs(d - e)) for d, e in zip(element.tabulate_dual(pts)[1:], exact[1:])) / scale
+    fd_error = max(np.max(np.abs(d - e)) for d, e in zip(finite_differences(element, pts)[1:], exact[1:])) / scale
+
+    name = f"{family} {cell} {degree}"
+    print(f"{name:>32} {t0:8.4f}s {t1 / t0:7.2f}x {t2 / t0:7.2f}x {dual_error:11.2e} {fd_error:9.2e}")
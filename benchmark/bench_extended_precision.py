@@ -0,0 +1,37 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Construction of high degree elements with the expansion coefficients
+# computed in double precision and in double-double arithmetic. The time of
+# each, and the largest difference between the two sets of coefficients
+# relative to their size, are reported. The double-double coefficients are
+# correctly rounded, so the difference is the error of the construction in
+# double precision.
+#
+# Usage: python3 bench_extended_precision.py
+
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+cases = [("Lagrange", "triangle", d) for d in (5, 10, 15, 20, 25)] \
+    + [("Lagrange", "tetrahedron", d) for d in (5, 10, 15)] \
+    + [("Raviart-Thomas", "triangle", d) for d in (5, 10, 15, 20)] \
+    + [("Nedelec 1st kind H(curl)", "triangle", d) for d in (5, 10, 15, 20)] \
+    + [("Nedelec 1st kind H(curl)", "tetrahedron", d) for d in (2, 5, 8)]
+
+dd = libtab.Precision.double_double
+print(f"{'element':>36} {'dofs':>5} {'double':>9} {'dd':>9} {'ratio':>7} {'coeff error':>12}")
+for family, cell, degree in cases:
+    t0 = best_time(lambda: libtab.create_element(family, cell, degree))
+    t1 = best_time(lambda: libtab.create_element(family, cell, degree, dd))
+
+    c0 = libtab.create_element(family, cell, degree).coefficients
+    c1 = libtab.create_element(family, cell, degree, dd).coefficients
+    error = np.max(np.abs(c0 - c1)) / np.max(np.abs(c1))
+
+    name = f"{family} {cell} {degree}"
+    print(f"{name:>36} {c1.shape[0]:5} {t0:8.4f}s {t1:8.4f}s {t1 / t0:6.1f}x {error:12.2e}")
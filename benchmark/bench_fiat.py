@@ -0,0 +1,96 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Compare libtab with FIAT, for the families that both provide on simplices:
+# the time to construct each element, and the throughput (points per
+# second) of tabulating the basis functions and their derivatives at the
+# same points. Both use the reference simplex with vertices at 0 and the
+# unit vectors. The results are printed and written as JSON.
+#
+# This is skipped when FIAT is not installed.
+#
+# Usage: python3 bench_fiat.py [npoints] [output.json]
+
+import json
+import platform
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+try:
+    import FIAT
+except ImportError:
+    print("FIAT is not installed: skipping")
+    sys.exit(0)
+
+
+# libtab family name and the FIAT element with the same space and dofs
+fiat_families = {
+    "Lagrange": lambda cell, degree: FIAT.Lagrange(cell, degree),
+    "Discontinuous Lagrange": lambda cell, degree: FIAT.DiscontinuousLagrange(cell, degree),
+    "Raviart-Thomas": lambda cell, degree: FIAT.RaviartThomas(cell, degree, variant="integral"),
+    "Nedelec 1st kind H(curl)": lambda cell, degree: FIAT.Nedelec(cell, degree, variant="integral"),
+    "Regge": lambda cell, degree: FIAT.Regge(cell, degree),
+}
+tdims = {"interval": 1, "triangle": 2, "tetrahedron": 3}
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 10000
+output = sys.argv[2] if len(sys.argv) > 2 else "bench_fiat.json"
+
+cases = [("Lagrange", cell, d) for cell in ("interval", "triangle", "tetrahedron") for d in (1, 2, 3, 4, 5)] \
+    + [("Discontinuous Lagrange", "triangle", d) for d in (1, 3, 5)] \
+    + [("Raviart-Thomas", cell, d) for cell in ("triangle", "tetrahedron") for d in (1, 2, 3)] \
+    + [("Nedelec 1st kind H(curl)", cell, d) for cell in ("triangle", "tetrahedron") for d in (1, 2, 3)] \
+    + [("Regge", "triangle", d) for d in (0, 1, 2)]
+
+results = []
+print(f"{'element':>40} {'construct':>10} {'fiat':>9} {'nd':>3} {'pts/s':>10} {'fiat':>10} {'speedup':>8}")
+for family, cell, degree in cases:
+    tdim = tdims[cell]
+    fiat_cell = FIAT.ufc_simplex(tdim)
+    try:
+        fiat_element = fiat_families[family](fiat_cell, degree)
+    except Exception as e:
+        # Some versions of FIAT do not have every family or variant
+        print(f"{family} {cell} {degree}: not available in FIAT ({e})")
+        continue
+    element = libtab.create_element(family, cell, degree)
+    if element.dim != fiat_element.space_dimension():
+        print(f"{family} {cell} {degree}: dimensions differ, skipping")
+        continue
+
+    # Random points in the reference simplex
+    pts = np.random.rand(npoints, tdim)
+    pts = pts[np.sum(pts, axis=1) <= 1.0]
+    while pts.shape[0] < npoints:
+        p = np.random.rand(npoints, tdim)
+        pts = np.vstack([pts, p[np.sum(p, axis=1) <= 1.0]])
+    pts = np.ascontiguousarray(pts[:npoints])
+
+    record = {"family": family, "cell": cell, "degree": degree, "dim": element.dim,
+              "npoints": npoints,
+              "construct": best_time(lambda: libtab.create_element(family, cell, degree)),
+              "construct_fiat": best_time(lambda: fiat_families[family](fiat_cell, degree)),
+              "tabulate": []}
+    for nd in (0, 1):
+        t = best_time(lambda: element.tabulate(nd, pts))
+        tf = best_time(lambda: fiat_element.tabulate(nd, pts))
+        record["tabulate"].append({"nderivs": nd, "time": t, "time_fiat": tf,
+                                   "points_per_second": npoints / t,
+                                   "points_per_second_fiat": npoints / tf})
+    results.append(record)
+
+    name = f"{family} {cell} {degree}"
+    for i, r in enumerate(record["tabulate"]):
+        construct = f"{record['construct']:9.5f}s {record['construct_fiat']:8.5f}s" if i == 0 else " " * 20
+        print(f"{name if i == 0 else '':>40} {construct} {r['nderivs']:3} {r['points_per_second']:10.3g} "
+              f"{r['points_per_second_fiat']:10.3g} {r['time_fiat'] / r['time']:7.1f}x")
+
+with open(output, "w") as f:
+    json.dump({"fiat": getattr(FIAT, "__version__", "unknown"),
+               "python": platform.python_version(), "machine": platform.machine(),
+               "processor": platform.processor(), "results": results}, f, indent=2)
+print(f"Results written to {output}")
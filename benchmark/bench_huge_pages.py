@@ -0,0 +1,68 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Measure the effect of huge pages on large tabulation outputs. For each
+# huge page policy, the time to tabulate into a new output (including the
+# page faults when it is first written) and the time to read all the dofs
+# at random points are measured. In the default layout, the values at one
+# point are a whole table apart, so each read touches a different page and
+# the reads are limited by TLB misses when normal (4 kB) pages are used.
+#
+# The policy can also be set with the environment variable
+# LIBTAB_HUGE_PAGES. The hugetlb policy needs huge pages reserved in
+# /proc/sys/vm/nr_hugepages.
+#
+# Usage: python3 bench_huge_pages.py [npoints]
+
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+def huge_page_fraction(a):
+    # Fraction of the mapping containing the middle of an array which is
+    # backed by huge pages, from /proc/self/smaps
+    address = a.ctypes.data + a.nbytes // 2
+    try:
+        with open("/proc/self/smaps") as f:
+            lines = f.readlines()
+    except OSError:
+        return float("nan")
+    size = None
+    for line in lines:
+        fields = line.split()
+        if "-" in fields[0] and not fields[0].endswith(":"):
+            lo, hi = (int(x, 16) for x in fields[0].split("-"))
+            size = hi - lo if lo <= address < hi else None
+        elif size is not None and fields[0] == "AnonHugePages:":
+            return int(fields[1]) * 1024 / size
+    return float("nan")
+
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+cases = [("Lagrange", "tetrahedron", 4, 1), ("Nedelec 1st kind H(curl)", "tetrahedron", 3, 0),
+         ("Lagrange", "hexahedron", 3, 0)]
+policies = [libtab.HugePagePolicy.none, libtab.HugePagePolicy.transparent, libtab.HugePagePolicy.hugetlb]
+
+print(f"{'element':>36} {'policy':>12} {'tabulate':>9} {'gather':>9} {'huge pages':>11}")
+for family, cell, degree, nderiv in cases:
+    element = libtab.create_element(family, cell, degree)
+    tdim = len(libtab.topology(element.cell_type)) - 1
+    pts = np.random.rand(npoints, tdim) / tdim
+    plan = libtab.TabulationPlan(element, npoints, nderiv)
+    gather = np.random.randint(0, npoints, 100000)
+
+    name = f"{family} {cell} {degree} (nd={nderiv})"
+    for policy in policies:
+        libtab.set_huge_page_policy(policy)
+        t0 = best_time(lambda: plan.execute_array(pts))
+
+        # Values of all dofs and components at random points
+        values = plan.execute_array(pts)
+        t1 = best_time(lambda: values[:, :, :, gather].sum())
+
+        print(f"{name:>36} {policy.name:>12} {t0:8.4f}s {t1:8.4f}s {100 * huge_page_fraction(values):10.0f}%")
+libtab.set_huge_page_policy(libtab.HugePagePolicy.none)
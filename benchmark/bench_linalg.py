@@ -0,0 +1,41 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Time element construction and tabulation with the default choice of
+# Eigen or BLAS for each shape class, then autotune the choice and time
+# again. Build libtab with -DLIBTAB_USE_BLAS=ON (and optionally
+# -DBLA_VENDOR=OpenBLAS) to compare against an external BLAS.
+#
+# Usage: python3 bench_linalg.py [npoints]
+
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+def run(npoints):
+    results = []
+    for family, cell, degree in [("Lagrange", "tetrahedron", 5), ("Raviart-Thomas", "tetrahedron", 3),
+                                 ("Nedelec 1st kind H(curl)", "tetrahedron", 3)]:
+        t_create = best_time(lambda: libtab.create_element(family, cell, degree))
+        element = libtab.create_element(family, cell, degree)
+        pts = np.random.rand(npoints, 3) / 3.0
+        t_tab = best_time(lambda: element.tabulate(1, pts))
+        results.append((f"{family} {cell} {degree}", t_create, t_tab))
+    return results
+
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+print("BLAS available:", libtab.has_blas())
+
+before = run(npoints)
+print("Default backends:", [b.name for b in libtab.linalg_backends()])
+print("Tuned backends:  ", [b.name for b in libtab.linalg_autotune()])
+after = run(npoints)
+
+print(f"{'element':>40} {'create':>10} {'tuned':>10} {'tabulate':>10} {'tuned':>10}")
+for (name, c0, t0), (_, c1, t1) in zip(before, after):
+    print(f"{name:>40} {c0:9.4f}s {c1:9.4f}s {t0:9.4f}s {t1:9.4f}s")
@@ -0,0 +1,66 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Measure the effect of the placement of the output pages on a parallel
+# tabulation. On a machine with several NUMA nodes (e.g. a dual-socket
+# node), an output which is initialised by the main thread lies on one
+# node, and the threads on the other nodes write to it across the link
+# between the sockets. An output which is first touched by the thread that
+# computes each tile is spread over the nodes of the threads. With libnuma,
+# interleaved pages are also compared.
+#
+# Run with one thread per core, e.g. on both sockets, to see the effect.
+#
+# Usage: python3 bench_numa.py [npoints] [nthreads]
+
+import collections
+import os
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+def placement(a):
+    nodes = collections.Counter(libtab.numa_page_nodes(a))
+    if -1 in nodes:
+        return "unknown"
+    return " ".join(f"{n}:{100 * c / sum(nodes.values()):.0f}%" for n, c in sorted(nodes.items()))
+
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 1000000
+nthreads = int(sys.argv[2]) if len(sys.argv) > 2 else os.cpu_count()
+cases = [("Lagrange", "tetrahedron", 3, 1), ("Nedelec 1st kind H(curl)", "tetrahedron", 2, 1),
+         ("Lagrange", "hexahedron", 2, 1)]
+
+print(f"{libtab.num_numa_nodes()} NUMA node(s), libnuma: {libtab.has_numa()}, {nthreads} threads")
+print(f"{'element':>36} {'output':>12} {'time':>9} {'write GB/s':>11}  pages by node")
+for family, cell, degree, nderiv in cases:
+    element = libtab.create_element(family, cell, degree)
+    tdim = len(libtab.topology(element.cell_type)) - 1
+    pts = np.random.rand(npoints, tdim) / tdim
+    plan = libtab.TabulationPlan(element, npoints, nderiv, nthreads=nthreads)
+    shape = plan.execute_array(pts).shape
+
+    outputs = {}
+
+    # Written by the main thread before the tabulation
+    out = np.empty(shape)
+    out.fill(0.0)
+    outputs["main thread"] = out
+
+    # First touched by the thread which computes each tile
+    out = libtab.numa_empty(shape)
+    plan.first_touch(out)
+    outputs["first touch"] = out
+
+    if libtab.has_numa():
+        outputs["interleaved"] = libtab.numa_empty(shape, libtab.NumaPolicy.interleave)
+        outputs["local"] = libtab.numa_empty(shape, libtab.NumaPolicy.local)
+
+    name = f"{family} {cell} {degree} (nd={nderiv})"
+    for label, out in outputs.items():
+        t = best_time(lambda: plan.execute_array(pts, out=out))
+        print(f"{name:>36} {label:>12} {t:8.4f}s {out.nbytes / t / 1e9:10.2f}  {placement(out)}")
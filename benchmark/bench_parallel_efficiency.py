@@ -0,0 +1,50 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Report the parallel efficiency T(1) / (p T(p)) of tabulation and of
+# building orientation tables with p threads, using the built-in
+# work-stealing pool and an external concurrent.futures pool.
+#
+# Usage: python3 bench_parallel_efficiency.py [npoints]
+
+import os
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 20000
+maxthreads = os.cpu_count()
+threads = [p for p in [1, 2, 4, 8, 16, 32] if p <= maxthreads]
+
+lagrange = libtab.create_element("Lagrange", "tetrahedron", 6)
+nedelec = libtab.create_element("Nedelec 1st kind H(curl)", "tetrahedron", 3)
+pts = np.random.rand(npoints, 3) / 3.0
+cases = [("tabulate Lagrange P6, 3 derivs", lambda p: lagrange.tabulate(3, pts, nthreads=p)),
+         ("orientation tables N1curl 3", lambda p: libtab.OrientationTables(nedelec, 1, pts[:1000], nthreads=p))]
+
+pool = ThreadPoolExecutor(maxthreads)
+
+
+def external(n, nthreads, task):
+    list(pool.map(task, range(n)))
+
+
+for executor_name, executor in [("work-stealing", None), ("ThreadPoolExecutor", external)]:
+    libtab.set_executor(executor)
+    print(f"Executor: {executor_name}")
+    print(f"{'case':>34} " + " ".join(f"{'p=' + str(p):>12}" for p in threads))
+    for name, f in cases:
+        t1 = best_time(lambda: f(1))
+        row = []
+        for p in threads:
+            tp = best_time(lambda: f(p))
+            row.append(f"{tp:6.3f}s {t1 / (p * tp):4.0%}")
+        print(f"{name:>34} " + " ".join(f"{r:>12}" for r in row))
+
+libtab.set_executor(None)
+pool.shutdown()
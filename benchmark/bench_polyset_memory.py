@@ -0,0 +1,77 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Compare the peak memory of polyset tabulation of high order derivatives
+# on 3D cells with and without streaming by derivative order, and check the
+# streaming peak against the documented bound.
+#
+# Usage: python3 bench_polyset_memory.py [npoints] [degree] [nderiv]
+
+import resource
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+
+def peak_rss():
+    # ru_maxrss is in kilobytes on Linux
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss * 1024
+
+
+def run(mode, celltype, npoints, degree, nderiv, block_size):
+    import libtab
+    ct = getattr(libtab.CellType, celltype)
+    pts = np.random.rand(npoints, 3) / 3.0
+    base = peak_rss()
+    start = time.perf_counter()
+    if mode == "full":
+        tables = libtab.tabulate_polynomial_set(ct, degree, nderiv, pts)
+        norm = sum(np.abs(t).sum() for t in tables)
+        del tables
+    else:
+        norm = 0.0
+
+        def consumer(k, offset, tables):
+            nonlocal norm
+            norm += sum(np.abs(t).sum() for t in tables)
+
+        libtab.tabulate_polynomial_set_by_order(ct, degree, nderiv, pts, block_size, consumer)
+    elapsed = time.perf_counter() - start
+    print(peak_rss() - base, elapsed, norm)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) > 1 and sys.argv[1] in ("full", "stream"):
+        run(sys.argv[1], sys.argv[2], *[int(a) for a in sys.argv[3:]])
+        sys.exit(0)
+
+    npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 200000
+    degree = int(sys.argv[2]) if len(sys.argv) > 2 else 8
+    nderiv = int(sys.argv[3]) if len(sys.argv) > 3 else 3
+    block_size = 4096
+
+    for celltype, psize in [("tetrahedron", (degree + 1) * (degree + 2) * (degree + 3) // 6),
+                            ("pyramid", (degree + 1) * (degree + 2) * (2 * degree + 3) // 6)]:
+        results = {}
+        for mode in ("full", "stream"):
+            out = subprocess.run([sys.executable, __file__, mode, celltype, str(npoints), str(degree),
+                                  str(nderiv), str(block_size)], capture_output=True, text=True, check=True)
+            results[mode] = [float(v) for v in out.stdout.split()]
+
+        md = (nderiv + 1) * (nderiv + 2) * (nderiv + 3) // 6
+        live = md if nderiv < 2 else (3 * nderiv * nderiv + 3 * nderiv + 2) // 2
+        # Live tables, one scratch table and the copies handed to Python
+        bound = (live + 1 + (nderiv + 1) * (nderiv + 2) // 2) * block_size * psize * 8
+        full_bytes = md * npoints * psize * 8
+
+        print(f"{celltype}: {npoints} points, degree {degree}, nderiv {nderiv}")
+        print(f"  full:   peak {results['full'][0] / 2**20:9.1f} MiB "
+              f"(tables {full_bytes / 2**20:.1f} MiB), {results['full'][1]:.3f} s")
+        print(f"  stream: peak {results['stream'][0] / 2**20:9.1f} MiB "
+              f"(bound {bound / 2**20:.1f} MiB), {results['stream'][1]:.3f} s")
+        assert np.isclose(results["full"][2], results["stream"][2])
+        # Allow for the interpreter and allocator overhead
+        assert results["stream"][0] <= bound + 64 * 2**20, "Streaming peak memory exceeds bound"
@@ -0,0 +1,61 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Compare the cost of assembling mass and stiffness matrices with the
+# Gauss product rule and with the reduced symmetric rule of the same
+# total-degree exactness. The matrices are for the space P_p of
+# polynomials of total degree at most p (with the monomial basis), so
+# that the integrands have total degree 2p and both rules are exact: the
+# last column, the largest difference between the matrices, is at the
+# level of rounding. (For the Q_p Lagrange elements the integrands are in
+# Q_2p, for which the reduced rules are not exact.)
+#
+# Usage: python3 bench_reduced_quadrature.py [repeats]
+
+import itertools
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+def tabulate(exponents, pts):
+    # Values and first derivatives of the monomials at the points
+    tables = [np.prod(pts[:, None, :] ** exponents, axis=2)]
+    for d in range(pts.shape[1]):
+        lower = exponents.copy()
+        lower[:, d] = np.maximum(lower[:, d] - 1, 0)
+        tables.append(exponents[:, d] * np.prod(pts[:, None, :] ** lower, axis=2))
+    return tables
+
+
+def assemble(exponents, pts, wts, repeats):
+    # Mass and stiffness matrices on the reference cell
+    for i in range(repeats):
+        tables = tabulate(exponents, pts)
+        A = (tables[0].T * wts) @ tables[0]
+        for d in tables[1:]:
+            A += (d.T * wts) @ d
+    return A
+
+
+repeats = int(sys.argv[1]) if len(sys.argv) > 1 else 200
+print(f"{'space':>20} {'points':>8} {'reduced':>8} {'time':>9} {'reduced':>9} {'difference':>10}")
+for cell, tdim in [("quadrilateral", 2), ("hexahedron", 3), ("prism", 3)]:
+    for degree in [1, 2, 3]:
+        celltype = libtab.CellType.__members__[cell]
+        exponents = np.array([a for a in itertools.product(range(degree + 1), repeat=tdim) if sum(a) <= degree])
+
+        # Integrands are products of two basis functions (or derivatives)
+        qdegree = 2 * degree
+        pts, wts = libtab.make_quadrature(celltype, qdegree // 2 + 1)
+        rpts, rwts = libtab.make_reduced_quadrature(celltype, qdegree)
+
+        t = best_time(lambda: assemble(exponents, pts, wts, repeats))
+        tr = best_time(lambda: assemble(exponents, rpts, rwts, repeats))
+        A = assemble(exponents, pts, wts, 1)
+        difference = abs(A - assemble(exponents, rpts, rwts, 1)).max() / abs(A).max()
+        print(f"{'P' + str(degree) + ' ' + cell:>20} {len(wts):>8} {len(rwts):>8} "
+              f"{t:8.4f}s {tr:8.4f}s {difference:10.2e}")
@@ -0,0 +1,44 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Compare FiniteElement.tabulate for a large number of points with and
+# without tiling of the points. Without tiling, the expansion set tables for
+# all points are written to memory and read back for the product with the
+# coefficients. With tiling, they stay in cache and only the result is
+# written to memory.
+#
+# Usage: python3 bench_tabulate_blocking.py [npoints]
+
+import sys
+
+import numpy as np
+import libtab
+from timing import best_time
+
+
+npoints = int(sys.argv[1]) if len(sys.argv) > 1 else 500000
+cases = [("Lagrange", "triangle", 4, 2), ("Lagrange", "tetrahedron", 3, 2),
+         ("Nedelec 1st kind H(curl)", "tetrahedron", 3, 1), ("Lagrange", "hexahedron", 2, 1)]
+
+print(f"{'element':>40} {'unblocked':>10} {'blocked':>10} {'speedup':>8} {'traffic saved':>14}")
+for family, cell, degree, nderiv in cases:
+    element = libtab.create_element(family, cell, degree)
+    tdim = len(libtab.topology(element.cell_type)) - 1
+    pts = np.random.rand(npoints, tdim) / tdim
+
+    tables = element.tabulate(nderiv, pts[:1])
+    nderivs = len(tables)
+    psize = libtab.tabulate_polynomial_set(element.cell_type, degree, 0, pts[:1])[0].shape[1]
+
+    t0 = best_time(lambda: element.tabulate(nderiv, pts, block_size=0))
+    t1 = best_time(lambda: element.tabulate(nderiv, pts))
+
+    # Estimated memory traffic: the expansion set is written and read back
+    # once when unblocked. The result is written in both cases.
+    result_bytes = nderivs * npoints * tables[0].shape[1] * 8
+    polyset_bytes = 2 * nderivs * npoints * psize * 8
+    saved = polyset_bytes / (polyset_bytes + result_bytes)
+
+    name = f"{family} {cell} {degree} (nd={nderiv})"
+    print(f"{name:>40} {t0:9.3f}s {t1:9.3f}s {t0 / t1:7.2f}x {100 * saved:12.1f}%")
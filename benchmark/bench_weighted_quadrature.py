@@ -0,0 +1,51 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Compare the number of points needed to integrate weighted and
+# endpoint-singular integrands on [0, 1] with plain Gauss-Legendre and
+# with a Gauss-Jacobi rule that absorbs the weight (1 - x)^a x^b.
+#
+# Usage: python3 bench_weighted_quadrature.py [tolerance]
+
+import sys
+
+import numpy as np
+import libtab
+
+# (description, a, b, smooth part f); the integrand is (1 - x)^a x^b f(x)
+integrals = [("axisymmetric r-weight, r cos(3r)", 0.0, 1.0, lambda x: np.cos(3 * x)),
+             ("sqrt(x) exp(x)", 0.0, 0.5, np.exp),
+             ("exp(x) / sqrt(1 - x)", -0.5, 0.0, np.exp),
+             ("x^-0.3 (1 - x)^0.4 sin(x)", 0.4, -0.3, np.sin),
+             ("boundary layer x^-0.9 cos(x)", 0.0, -0.9, np.cos)]
+
+
+def legendre(a, b, f, m):
+    pts, wts = libtab.make_quadrature(libtab.CellType.interval, m)
+    x = pts[:, 0]
+    return sum(wts * (1 - x)**a * x**b * f(x))
+
+
+def jacobi(a, b, f, m):
+    pts, wts = libtab.make_quadrature(libtab.CellType.interval, libtab.QuadratureType.gauss_jacobi, m, [[a, b]])
+    return sum(wts * f(pts[:, 0]))
+
+
+def points_needed(rule, a, b, f, exact, tol, max_points):
+    m = 1
+    while m <= max_points:
+        if abs(rule(a, b, f, m) - exact) < tol * abs(exact):
+            return m
+        m = m + 1 if m < 16 else 2 * m
+    return None
+
+
+tol = float(sys.argv[1]) if len(sys.argv) > 1 else 1e-10
+print(f"{'integrand':>32} {'Gauss-Legendre':>15} {'Gauss-Jacobi':>13}")
+for name, a, b, f in integrals:
+    exact = jacobi(a, b, f, 40)
+    n_leg = points_needed(legendre, a, b, f, exact, tol, 1024)
+    n_jac = points_needed(jacobi, a, b, f, exact, tol, 40)
+    leg = str(n_leg) if n_leg is not None else "> 1024"
+    print(f"{name:>32} {leg:>15} {n_jac:>13}")
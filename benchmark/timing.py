@@ -0,0 +1,17 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+# Timing shared by the benchmarks
+
+import time
+
+
+def best_time(f, repeat=3):
+    """Best wall clock time of several calls of f, in seconds"""
+    t = []
+    for i in range(repeat):
+        start = time.perf_counter()
+        f()
+        t.append(time.perf_counter() - start)
+    return min(t)
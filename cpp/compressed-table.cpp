@@ -0,0 +1,203 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "compressed-table.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Number of points widened at once by the contraction kernels
+constexpr int tile_rows = 128;
+//-----------------------------------------------------------------------------
+float bits_to_float(std::uint32_t bits)
+{
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+//-----------------------------------------------------------------------------
+// Round to the nearest float16 (ties to even)
+std::uint16_t to_float16(double v)
+{
+  const std::uint16_t sign = std::signbit(v) ? 0x8000 : 0;
+  const double a = std::abs(v);
+  if (std::isnan(a))
+    return sign | 0x7e00;
+  if (a >= 65520.0)
+    throw std::runtime_error("Table value out of range of float16");
+
+  // Subnormal numbers are multiples of 2^-24. Rounding up to 1024 gives
+  // the smallest normal number, which has the same bits.
+  if (a < std::ldexp(1.0, -14))
+    return sign | static_cast<std::uint16_t>(std::nearbyint(a * 0x1p24));
+
+  // a = (1 + f / 1024) 2^(e - 15)
+  int e;
+  const double m = std::frexp(a, &e);
+  int f = static_cast<int>(std::nearbyint((2 * m - 1) * 1024));
+  e += 14;
+  if (f == 1024)
+  {
+    f = 0;
+    ++e;
+  }
+  return sign | static_cast<std::uint16_t>(e << 10 | f);
+}
+//-----------------------------------------------------------------------------
+double from_float16(std::uint16_t h)
+{
+  const std::uint32_t sign = std::uint32_t(h & 0x8000) << 16;
+  const std::uint32_t e = h >> 10 & 0x1f;
+  const std::uint32_t f = h & 0x3ff;
+  if (e == 0)
+  {
+    const float v = f * 0x1p-24f;
+    return sign ? -v : v;
+  }
+  if (e == 0x1f)
+    return bits_to_float(sign | 0x7f800000 | f << 13);
+  return bits_to_float(sign | (e + 112) << 23 | f << 13);
+}
+//-----------------------------------------------------------------------------
+// Round to the nearest bfloat16 (ties to even), through single precision
+std::uint16_t to_bfloat16(double v)
+{
+  const float x = static_cast<float>(v);
+  std::uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  if (std::isnan(x))
+    return bits >> 16 | 0x40;
+  bits += 0x7fff + (bits >> 16 & 1);
+  return bits >> 16;
+}
+//-----------------------------------------------------------------------------
+double from_bfloat16(std::uint16_t b)
+{
+  return bits_to_float(std::uint32_t(b) << 16);
+}
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+CompressedTable::CompressedTable(const Eigen::ArrayXXd& table, format storage)
+    : _rows(table.rows()), _cols(table.cols()), _format(storage),
+      _values(table.size())
+{
+  if (storage == format::scaled_int16)
+  {
+    _scales.resize(_cols);
+    for (int j = 0; j < _cols; ++j)
+      _scales[j] = table.col(j).abs().maxCoeff() / 32767.0;
+  }
+
+  for (int i = 0; i < _rows; ++i)
+  {
+    std::uint16_t* row = _values.data() + std::size_t(i) * _cols;
+    for (int j = 0; j < _cols; ++j)
+    {
+      switch (storage)
+      {
+      case format::float16:
+        row[j] = to_float16(table(i, j));
+        break;
+      case format::bfloat16:
+        row[j] = to_bfloat16(table(i, j));
+        break;
+      default:
+      {
+        const double q = _scales[j] > 0 ? table(i, j) / _scales[j] : 0.0;
+        row[j] = static_cast<std::uint16_t>(
+            static_cast<std::int16_t>(std::nearbyint(q)));
+      }
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+int CompressedTable::rows() const { return _rows; }
+//-----------------------------------------------------------------------------
+int CompressedTable::cols() const { return _cols; }
+//-----------------------------------------------------------------------------
+CompressedTable::format CompressedTable::storage() const { return _format; }
+//-----------------------------------------------------------------------------
+std::size_t CompressedTable::memory_usage() const
+{
+  return _values.size() * sizeof(std::uint16_t)
+         + _scales.size() * sizeof(double);
+}
+//-----------------------------------------------------------------------------
+Eigen::ArrayXXd CompressedTable::expand() const
+{
+  Eigen::MatrixXd table(_cols, _rows);
+  widen(0, table);
+  return table.transpose().array();
+}
+//-----------------------------------------------------------------------------
+void CompressedTable::contract(const Eigen::Ref<const Eigen::MatrixXd>& u,
+                               Eigen::Ref<Eigen::MatrixXd> r) const
+{
+  if (u.rows() != _cols or r.rows() != _rows or r.cols() != u.cols())
+    throw std::runtime_error("Coefficients do not match table");
+
+  Eigen::MatrixXd tile(_cols, tile_rows);
+  for (int offset = 0; offset < _rows; offset += tile_rows)
+  {
+    const int rows = std::min(tile_rows, _rows - offset);
+    tile.conservativeResize(Eigen::NoChange, rows);
+    widen(offset, tile);
+    r.middleRows(offset, rows).noalias() = tile.transpose() * u;
+  }
+}
+//-----------------------------------------------------------------------------
+void CompressedTable::contract_transpose(
+    const Eigen::Ref<const Eigen::MatrixXd>& w,
+    Eigen::Ref<Eigen::MatrixXd> r) const
+{
+  if (w.rows() != _rows or r.rows() != _cols or r.cols() != w.cols())
+    throw std::runtime_error("Values do not match table");
+
+  r.setZero();
+  Eigen::MatrixXd tile(_cols, tile_rows);
+  for (int offset = 0; offset < _rows; offset += tile_rows)
+  {
+    const int rows = std::min(tile_rows, _rows - offset);
+    tile.conservativeResize(Eigen::NoChange, rows);
+    widen(offset, tile);
+    r.noalias() += tile * w.middleRows(offset, rows);
+  }
+}
+//-----------------------------------------------------------------------------
+void CompressedTable::widen(int offset, Eigen::MatrixXd& tile) const
+{
+  const int n = tile.size();
+  const std::uint16_t* v = _values.data() + std::size_t(offset) * _cols;
+  double* t = tile.data();
+  switch (_format)
+  {
+  case format::float16:
+    for (int i = 0; i < n; ++i)
+      t[i] = from_float16(v[i]);
+    break;
+  case format::bfloat16:
+    for (int i = 0; i < n; ++i)
+      t[i] = from_bfloat16(v[i]);
+    break;
+  default:
+    for (int k = 0; k < tile.cols(); ++k)
+    {
+      for (int j = 0; j < _cols; ++j)
+      {
+        t[k * _cols + j]
+            = _scales[j] * static_cast<std::int16_t>(v[k * _cols + j]);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,95 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libtab
+{
+
+/// A table of basis function values (e.g. one derivative table from
+/// FiniteElement::tabulate, of shape (npoints, ndofs)) stored with 16 bits
+/// per value, for codes which keep the reference tables of many elements
+/// at quadrature points and are limited by memory bandwidth.
+///
+/// The values are widened to double on the fly, one tile of points at a
+/// time, by the contraction kernels, so the full table is never expanded
+/// in memory.
+///
+/// The error of each stored value is at most (relative to its magnitude)
+/// 2^-11 for float16 and 2^-8 for bfloat16. float16 values smaller than
+/// 2^-14 lose relative precision, and values of magnitude 65520 or more
+/// cannot be stored. For scaled_int16, each column (dof) is scaled by its
+/// largest magnitude, and the error is at most 1/65534 of that magnitude.
+class CompressedTable
+{
+public:
+  /// Storage format of the values
+  enum class format
+  {
+    /// IEEE half precision: 11 significant bits, 5 exponent bits
+    float16,
+
+    /// Truncated single precision: 8 significant bits, 8 exponent bits
+    bfloat16,
+
+    /// Integers scaled by the largest magnitude in each column
+    scaled_int16
+  };
+
+  /// Compress a table
+  /// @param[in] table The values, of shape (npoints, ndofs)
+  /// @param[in] storage The format to store them in
+  CompressedTable(const Eigen::ArrayXXd& table, format storage);
+
+  /// The number of rows (points)
+  int rows() const;
+
+  /// The number of columns (dofs)
+  int cols() const;
+
+  /// The storage format
+  format storage() const;
+
+  /// Memory used by the values (and scales), in bytes
+  std::size_t memory_usage() const;
+
+  /// The values widened to double
+  /// @return Table of shape (rows, cols)
+  Eigen::ArrayXXd expand() const;
+
+  /// Compute r = T u, e.g. the values at the points of the functions with
+  /// coefficients u on a batch of cells
+  /// @param[in] u Coefficients, of shape (cols, ncells)
+  /// @param[out] r Result, of shape (rows, ncells)
+  void contract(const Eigen::Ref<const Eigen::MatrixXd>& u,
+                Eigen::Ref<Eigen::MatrixXd> r) const;
+
+  /// Compute r = T^T w, e.g. the integrals against each basis function of
+  /// the weighted values w at the points on a batch of cells
+  /// @param[in] w Values at the points, of shape (rows, ncells)
+  /// @param[out] r Result, of shape (cols, ncells)
+  void contract_transpose(const Eigen::Ref<const Eigen::MatrixXd>& w,
+                          Eigen::Ref<Eigen::MatrixXd> r) const;
+
+private:
+  // Widen the values of rows [offset, offset + tile.cols()) into the
+  // columns of tile
+  void widen(int offset, Eigen::MatrixXd& tile) const;
+
+  int _rows, _cols;
+  format _format;
+
+  // Row-major values, so that a tile of rows is contiguous
+  std::vector<std::uint16_t> _values;
+
+  // Scale of each column, for scaled_int16
+  std::vector<double> _scales;
+};
+
+} // namespace libtab
@@ -0,0 +1,124 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "dg-operators.h"
+#include "cell.h"
+#include "libtab.h"
+#include "polyset.h"
+#include "quadrature.h"
+#include <mutex>
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Volume of the reference cell
+double volume(cell::type celltype)
+{
+  switch (celltype)
+  {
+  case cell::type::interval:
+  case cell::type::quadrilateral:
+  case cell::type::hexahedron:
+    return 1.0;
+  case cell::type::triangle:
+  case cell::type::prism:
+    return 1.0 / 2.0;
+  case cell::type::tetrahedron:
+    return 1.0 / 6.0;
+  case cell::type::pyramid:
+    return 1.0 / 3.0;
+  default:
+    throw std::runtime_error("Unsupported cell type");
+  }
+}
+//-----------------------------------------------------------------------------
+// Quadrature rule on a facet of the reference cell, with points in the
+// coordinates of the cell and weights scaled by the size of the facet
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+make_facet_quadrature(cell::type celltype, int facet, int m)
+{
+  const int tdim = cell::topological_dimension(celltype);
+  const Eigen::ArrayXXd facet_x
+      = cell::sub_entity_geometry(celltype, tdim - 1, facet);
+  if (tdim == 1)
+    return {facet_x, Eigen::ArrayXd::Ones(1)};
+
+  const cell::type facet_type = cell::sub_entity_type(celltype, tdim - 1, facet);
+  if (facet_type != cell::type::quadrilateral)
+    return quadrature::make_quadrature(facet_x, m);
+
+  // Map the rule from the reference quadrilateral to the (planar,
+  // rectangular) facet
+  auto [pts, wts] = quadrature::make_quadrature(facet_type, m);
+  const Eigen::Vector3d a = facet_x.row(1) - facet_x.row(0);
+  const Eigen::Vector3d b = facet_x.row(2) - facet_x.row(0);
+  Eigen::ArrayXXd x(pts.rows(), 3);
+  for (int i = 0; i < pts.rows(); ++i)
+  {
+    x.row(i) = facet_x.row(0) + pts(i, 0) * a.transpose().array()
+               + pts(i, 1) * b.transpose().array();
+  }
+  return {x, wts * a.cross(b).norm()};
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<const dg::Operators> compute(const FiniteElement& element)
+{
+  const cell::type celltype = element.cell_type();
+  const int tdim = cell::topological_dimension(celltype);
+  const int ndofs = element.dim();
+  const int vs = element.value_size();
+  const int psize = polyset::dim(celltype, element.degree());
+  const Eigen::MatrixXd& coeffs = element.coefficients();
+
+  // The expansion set is orthogonal, and each member has the same norm as
+  // the constant member, which gives the scale of the Gram matrix
+  const double p0
+      = polyset::tabulate(celltype, 0, 0, Eigen::ArrayXXd::Zero(1, tdim))[0](
+          0, 0);
+  const double scale = p0 * p0 * volume(celltype);
+
+  auto ops = std::make_shared<dg::Operators>();
+  ops->mass = Eigen::MatrixXd::Zero(ndofs, ndofs);
+  for (int j = 0; j < vs; ++j)
+  {
+    const auto c = coeffs.middleCols(element.value_map()[j] * psize, psize);
+    ops->mass.noalias() += scale * c * c.transpose();
+  }
+
+  // A rule with degree + 1 points in each direction is exact for the
+  // product of two basis functions on each facet
+  const Eigen::LDLT<Eigen::MatrixXd> mass_inv(ops->mass);
+  const int nfacets = cell::sub_entity_count(celltype, tdim - 1);
+  for (int f = 0; f < nfacets; ++f)
+  {
+    auto [x, w] = make_facet_quadrature(celltype, f, element.degree() + 1);
+    const Eigen::ArrayXXd phi = element.tabulate(0, x)[0];
+    Eigen::MatrixXd facet_mass = Eigen::MatrixXd::Zero(ndofs, ndofs);
+    for (int j = 0; j < vs; ++j)
+    {
+      const auto phi_j = phi.matrix().middleCols(j * ndofs, ndofs);
+      facet_mass.noalias()
+          += phi_j.transpose() * w.matrix().asDiagonal() * phi_j;
+    }
+    ops->lift.push_back(mass_inv.solve(facet_mass));
+    ops->facet_mass.push_back(std::move(facet_mass));
+  }
+
+  return ops;
+}
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+std::shared_ptr<const dg::Operators>
+dg::operators(const FiniteElement& element)
+{
+  FiniteElement::DGOperators& cache = *element._dg_operators;
+  std::call_once(cache.computed,
+                 [&]() { cache.operators = compute(element); });
+  return cache.operators;
+}
+//-----------------------------------------------------------------------------
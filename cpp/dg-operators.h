@@ -0,0 +1,50 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <memory>
+#include <vector>
+
+namespace libtab
+{
+
+class FiniteElement;
+
+/// ## Discontinuous Galerkin operators
+/// Mass matrices, facet mass matrices and lifting operators of an element
+/// on the reference cell. The operators of each element are computed once
+/// and stored on the element, so repeated calls for the same element (or
+/// its copies) are cheap, and the operators are freed with the element.
+namespace dg
+{
+
+/// Operators of an element on the reference cell
+struct Operators
+{
+  /// Mass matrix: the integral of the product of basis functions i and j
+  /// (the inner product of the values, for vector-valued elements)
+  Eigen::MatrixXd mass;
+
+  /// Facet mass matrices: for each facet, the integral of the product of
+  /// basis functions i and j over the facet
+  std::vector<Eigen::MatrixXd> facet_mass;
+
+  /// Lifting operators: for each facet, the inverse mass matrix times the
+  /// facet mass matrix
+  std::vector<Eigen::MatrixXd> lift;
+};
+
+/// Get the operators of an element, computing them on first use. The mass
+/// matrix is computed from the expansion coefficients, as the expansion
+/// set is orthogonal with basis functions of equal norm. The facet mass
+/// matrices use a quadrature rule on each facet which is exact for the
+/// polynomials of the element.
+/// @param[in] element The element
+/// @return The operators, shared with the element
+std::shared_ptr<const Operators> operators(const FiniteElement& element);
+
+} // namespace dg
+} // namespace libtab
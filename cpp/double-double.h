@@ -0,0 +1,220 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <limits>
+
+namespace libtab
+{
+
+/// Double-double number, the unevaluated sum hi + lo of two doubles with
+/// |lo| <= ulp(hi) / 2, which carries about 32 significant digits
+///
+/// The operations use the error-free transformations of Dekker and Knuth
+/// (with fused multiply-add for products), as in the QD library of Hida,
+/// Li and Bailey, and are portable, unlike __float128. This is used by
+/// extended_precision to construct elements whose dual matrices are too
+/// ill-conditioned for double precision. The code must not be compiled
+/// with -ffast-math, which breaks the transformations.
+class DoubleDouble
+{
+public:
+  /// A double
+  DoubleDouble(double hi = 0.0) : _hi(hi), _lo(0.0) {}
+
+  /// The number hi + lo, which must satisfy |lo| <= ulp(hi) / 2
+  DoubleDouble(double hi, double lo) : _hi(hi), _lo(lo) {}
+
+  /// The leading part, i.e. the number rounded to double
+  double hi() const { return _hi; }
+
+  /// The trailing part
+  double lo() const { return _lo; }
+
+  /// Add another number
+  DoubleDouble& operator+=(const DoubleDouble& b)
+  {
+    double e, f;
+    const double s = two_sum(_hi, b._hi, e);
+    const double t = two_sum(_lo, b._lo, f);
+    e += t;
+    double h = quick_two_sum(s, e, e);
+    e += f;
+    _hi = quick_two_sum(h, e, _lo);
+    return *this;
+  }
+
+  /// Subtract another number
+  DoubleDouble& operator-=(const DoubleDouble& b) { return *this += -b; }
+
+  /// Multiply by another number
+  DoubleDouble& operator*=(const DoubleDouble& b)
+  {
+    double e;
+    const double p = two_prod(_hi, b._hi, e);
+    e += _hi * b._lo + _lo * b._hi;
+    _hi = quick_two_sum(p, e, _lo);
+    return *this;
+  }
+
+  /// Multiply by a double
+  DoubleDouble& operator*=(double b)
+  {
+    double e;
+    const double p = two_prod(_hi, b, e);
+    e += _lo * b;
+    _hi = quick_two_sum(p, e, _lo);
+    return *this;
+  }
+
+  /// Divide by another number, with three steps of long division
+  DoubleDouble& operator/=(const DoubleDouble& b)
+  {
+    const double q1 = _hi / b._hi;
+    DoubleDouble r = *this - b * q1;
+    const double q2 = r._hi / b._hi;
+    r -= b * q2;
+    const double q3 = r._hi / b._hi;
+    double lo;
+    const double hi = quick_two_sum(q1, q2, lo);
+    *this = DoubleDouble(hi, lo) + q3;
+    return *this;
+  }
+
+  friend DoubleDouble operator-(const DoubleDouble& a)
+  {
+    return DoubleDouble(-a._hi, -a._lo);
+  }
+
+  friend DoubleDouble operator+(DoubleDouble a, const DoubleDouble& b)
+  {
+    return a += b;
+  }
+  friend DoubleDouble operator-(DoubleDouble a, const DoubleDouble& b)
+  {
+    return a -= b;
+  }
+  friend DoubleDouble operator*(DoubleDouble a, const DoubleDouble& b)
+  {
+    return a *= b;
+  }
+  friend DoubleDouble operator*(DoubleDouble a, double b) { return a *= b; }
+  friend DoubleDouble operator*(double a, DoubleDouble b) { return b *= a; }
+  friend DoubleDouble operator/(DoubleDouble a, const DoubleDouble& b)
+  {
+    return a /= b;
+  }
+
+  friend bool operator==(const DoubleDouble& a, const DoubleDouble& b)
+  {
+    return a._hi == b._hi and a._lo == b._lo;
+  }
+  friend bool operator!=(const DoubleDouble& a, const DoubleDouble& b)
+  {
+    return !(a == b);
+  }
+  friend bool operator<(const DoubleDouble& a, const DoubleDouble& b)
+  {
+    return a._hi < b._hi or (a._hi == b._hi and a._lo < b._lo);
+  }
+  friend bool operator>(const DoubleDouble& a, const DoubleDouble& b)
+  {
+    return b < a;
+  }
+  friend bool operator<=(const DoubleDouble& a, const DoubleDouble& b)
+  {
+    return !(b < a);
+  }
+  friend bool operator>=(const DoubleDouble& a, const DoubleDouble& b)
+  {
+    return !(a < b);
+  }
+
+  /// Absolute value
+  friend DoubleDouble abs(const DoubleDouble& a) { return a._hi < 0 ? -a : a; }
+
+  /// Square root, by one Newton step from the double square root
+  friend DoubleDouble sqrt(const DoubleDouble& a)
+  {
+    if (a._hi <= 0.0)
+      return DoubleDouble(std::sqrt(a._hi));
+    const double q = std::sqrt(a._hi);
+    double e;
+    const double q2 = two_prod(q, q, e);
+    const DoubleDouble r = a - DoubleDouble(q2, e);
+    return DoubleDouble(q) + r._hi * (0.5 / q);
+  }
+
+private:
+  // s + e = a + b exactly
+  static double two_sum(double a, double b, double& e)
+  {
+    const double s = a + b;
+    const double bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+    return s;
+  }
+
+  // s + e = a + b exactly, for |a| >= |b|
+  static double quick_two_sum(double a, double b, double& e)
+  {
+    const double s = a + b;
+    e = b - (s - a);
+    return s;
+  }
+
+  // p + e = a * b exactly
+  static double two_prod(double a, double b, double& e)
+  {
+    const double p = a * b;
+    e = std::fma(a, b, -p);
+    return p;
+  }
+
+  double _hi, _lo;
+};
+
+} // namespace libtab
+
+namespace Eigen
+{
+/// Traits which allow Eigen matrices of double-double numbers, including
+/// their products and LU factorisations
+template <>
+struct NumTraits<libtab::DoubleDouble>
+    : GenericNumTraits<libtab::DoubleDouble>
+{
+  typedef libtab::DoubleDouble Real;
+  typedef libtab::DoubleDouble NonInteger;
+  typedef libtab::DoubleDouble Nested;
+  typedef libtab::DoubleDouble Literal;
+
+  enum
+  {
+    IsComplex = 0,
+    IsInteger = 0,
+    IsSigned = 1,
+    RequireInitialization = 1,
+    ReadCost = 2,
+    AddCost = 20,
+    MulCost = 10
+  };
+
+  static inline Real epsilon() { return Real(0x1p-104); }
+  static inline Real dummy_precision() { return Real(1e-28); }
+  static inline Real highest()
+  {
+    return Real(std::numeric_limits<double>::max());
+  }
+  static inline Real lowest()
+  {
+    return Real(std::numeric_limits<double>::lowest());
+  }
+  static inline int digits10() { return 31; }
+  static inline int digits() { return 106; }
+};
+} // namespace Eigen
@@ -0,0 +1,366 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace libtab
+{
+
+/// Dual number with N derivative components, for forward-mode automatic
+/// differentiation
+///
+/// A Dual holds a value and its gradient with respect to N independent
+/// variables, and the arithmetic operators apply the chain rule. Passing
+/// points of Dual<tdim> seeded with dual::variables through
+/// FiniteElement::tabulate_values gives the basis functions and all their
+/// first derivatives. Points seeded with derivatives with respect to other
+/// parameters (e.g. of the geometry) give the exact derivatives of the
+/// basis functions with respect to these.
+///
+/// The components are of scalar type S, which may itself be a dual number:
+/// Dual<N, Dual<N>> seeded with dual::second_order_variables carries the
+/// second derivatives.
+template <int N, typename S = double>
+class Dual
+{
+  // Constants are values of any type which converts to S, in particular
+  // double also when S is a dual number
+  template <typename V>
+  using if_constant = std::enable_if_t<std::is_convertible_v<V, S>, int>;
+
+public:
+  /// A constant, with zero gradient
+  Dual() : _value(0.0), _gradient{} {}
+
+  /// A constant, with zero gradient
+  template <typename V, if_constant<V> = 0>
+  Dual(const V& value) : _value(value), _gradient{}
+  {
+  }
+
+  /// A value with the given gradient
+  Dual(const S& value, const std::array<S, N>& gradient)
+      : _value(value), _gradient(gradient)
+  {
+  }
+
+  /// The independent variable i, i.e. a value whose gradient is the unit
+  /// vector in direction i
+  static Dual variable(const S& value, int i)
+  {
+    Dual v(value);
+    v._gradient[i] = S(1.0);
+    return v;
+  }
+
+  /// The value
+  const S& value() const { return _value; }
+
+  /// The gradient
+  const std::array<S, N>& gradient() const { return _gradient; }
+
+  /// The derivative with respect to variable i
+  const S& derivative(int i) const { return _gradient[i]; }
+
+  /// Add another dual number
+  Dual& operator+=(const Dual& b)
+  {
+    _value += b._value;
+    for (int i = 0; i < N; ++i)
+      _gradient[i] += b._gradient[i];
+    return *this;
+  }
+
+  /// Subtract another dual number
+  Dual& operator-=(const Dual& b)
+  {
+    _value -= b._value;
+    for (int i = 0; i < N; ++i)
+      _gradient[i] -= b._gradient[i];
+    return *this;
+  }
+
+  /// Multiply by another dual number
+  Dual& operator*=(const Dual& b)
+  {
+    for (int i = 0; i < N; ++i)
+      _gradient[i] = _gradient[i] * b._value + _value * b._gradient[i];
+    _value *= b._value;
+    return *this;
+  }
+
+  /// Divide by another dual number
+  Dual& operator/=(const Dual& b)
+  {
+    const S inv = S(1.0) / b._value;
+    _value *= inv;
+    for (int i = 0; i < N; ++i)
+      _gradient[i] = (_gradient[i] - _value * b._gradient[i]) * inv;
+    return *this;
+  }
+
+  /// Add a constant
+  template <typename V, if_constant<V> = 0>
+  Dual& operator+=(const V& b)
+  {
+    _value += S(b);
+    return *this;
+  }
+
+  /// Subtract a constant
+  template <typename V, if_constant<V> = 0>
+  Dual& operator-=(const V& b)
+  {
+    _value -= S(b);
+    return *this;
+  }
+
+  /// Multiply by a constant
+  template <typename V, if_constant<V> = 0>
+  Dual& operator*=(const V& b)
+  {
+    const S c(b);
+    _value *= c;
+    for (int i = 0; i < N; ++i)
+      _gradient[i] *= c;
+    return *this;
+  }
+
+  /// Divide by a constant
+  template <typename V, if_constant<V> = 0>
+  Dual& operator/=(const V& b)
+  {
+    return *this *= S(1.0 / S(b));
+  }
+
+  friend Dual operator-(Dual a)
+  {
+    a *= S(-1.0);
+    return a;
+  }
+
+  // The binary operators are friends, so that they are found for
+  // constants as well as dual numbers
+
+  friend Dual operator+(Dual a, const Dual& b) { return a += b; }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator+(Dual a, const V& b)
+  {
+    return a += b;
+  }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator+(const V& a, Dual b)
+  {
+    return b += a;
+  }
+
+  friend Dual operator-(Dual a, const Dual& b) { return a -= b; }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator-(Dual a, const V& b)
+  {
+    return a -= b;
+  }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator-(const V& a, const Dual& b)
+  {
+    return -b + a;
+  }
+
+  friend Dual operator*(Dual a, const Dual& b) { return a *= b; }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator*(Dual a, const V& b)
+  {
+    return a *= b;
+  }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator*(const V& a, Dual b)
+  {
+    return b *= a;
+  }
+
+  friend Dual operator/(Dual a, const Dual& b) { return a /= b; }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator/(Dual a, const V& b)
+  {
+    return a /= b;
+  }
+  template <typename V, if_constant<V> = 0>
+  friend Dual operator/(const V& a, const Dual& b)
+  {
+    return Dual(a) /= b;
+  }
+
+  /// Square root
+  friend Dual sqrt(const Dual& a)
+  {
+    using std::sqrt;
+    const S s = sqrt(a._value);
+    Dual r(s);
+    for (int i = 0; i < N; ++i)
+      r._gradient[i] = a._gradient[i] * 0.5 / s;
+    return r;
+  }
+
+private:
+  S _value;
+  std::array<S, N> _gradient;
+};
+
+/// Conversion between tables of double and tables of dual numbers
+namespace dual
+{
+
+/// Strided view of one component of a table of dual numbers
+using ComponentMap
+    = Eigen::Map<Eigen::ArrayXXd, 0,
+                 Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+/// Strided read-only view of one component of a table of dual numbers
+using ConstComponentMap
+    = Eigen::Map<const Eigen::ArrayXXd, 0,
+                 Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+/// View of component k of a table of dual numbers, i.e. the values for
+/// k = 0 and the derivatives with respect to variable k - 1 for k > 0,
+/// without copying. A Dual<N> is stored as N + 1 consecutive doubles.
+/// @param[in] table Table of dual numbers
+/// @param[in] k The component
+/// @return View of shape (rows, cols) of the table
+template <int N>
+ComponentMap
+component(Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic>& table, int k)
+{
+  static_assert(sizeof(Dual<N>) == (N + 1) * sizeof(double),
+                "Dual number is not stored as N + 1 doubles");
+  return ComponentMap(reinterpret_cast<double*>(table.data()) + k,
+                      table.rows(), table.cols(),
+                      {(N + 1) * table.rows(), N + 1});
+}
+
+/// Read-only view of component k of a table of dual numbers
+template <int N>
+ConstComponentMap component(
+    const Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic>& table,
+    int k)
+{
+  static_assert(sizeof(Dual<N>) == (N + 1) * sizeof(double),
+                "Dual number is not stored as N + 1 doubles");
+  return ConstComponentMap(
+      reinterpret_cast<const double*>(table.data()) + k, table.rows(),
+      table.cols(), {(N + 1) * table.rows(), N + 1});
+}
+
+/// Points as independent variables: coordinate j of each point is seeded
+/// with the unit gradient in direction j
+/// @param[in] x Points, of shape (npoints, N)
+/// @return The points as dual numbers
+template <int N>
+Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic>
+variables(const Eigen::ArrayXXd& x)
+{
+  if (x.cols() != N)
+    throw std::runtime_error("Points do not match number of variables");
+
+  Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic> v(x.rows(), N);
+  for (int j = 0; j < N; ++j)
+    for (int i = 0; i < x.rows(); ++i)
+      v(i, j) = Dual<N>::variable(x(i, j), j);
+  return v;
+}
+
+/// Points as independent variables for second derivatives: coordinate j
+/// of each point is seeded with the unit gradient in direction j, both in
+/// its value and in its gradient, so that for a function f of the points
+/// f.derivative(i).derivative(j) is the second derivative of f in
+/// directions i and j
+/// @param[in] x Points, of shape (npoints, N)
+/// @return The points as nested dual numbers
+template <int N>
+Eigen::Array<Dual<N, Dual<N>>, Eigen::Dynamic, Eigen::Dynamic>
+second_order_variables(const Eigen::ArrayXXd& x)
+{
+  if (x.cols() != N)
+    throw std::runtime_error("Points do not match number of variables");
+
+  Eigen::Array<Dual<N, Dual<N>>, Eigen::Dynamic, Eigen::Dynamic> v(x.rows(),
+                                                                   N);
+  for (int j = 0; j < N; ++j)
+    for (int i = 0; i < x.rows(); ++i)
+      v(i, j) = Dual<N, Dual<N>>::variable(Dual<N>::variable(x(i, j), j), j);
+  return v;
+}
+
+/// The second derivatives in directions i and j of a table of nested dual
+/// numbers, as given by second_order_variables
+template <int N>
+Eigen::ArrayXXd second_derivatives(
+    const Eigen::Array<Dual<N, Dual<N>>, Eigen::Dynamic, Eigen::Dynamic>&
+        table,
+    int i, int j)
+{
+  return table.unaryExpr([i, j](const Dual<N, Dual<N>>& f) {
+    return f.derivative(i).derivative(j);
+  });
+}
+
+/// The values of a table of dual numbers
+template <int N>
+Eigen::ArrayXXd
+values(const Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic>& table)
+{
+  return component(table, 0);
+}
+
+/// The derivatives with respect to variable k of a table of dual numbers
+template <int N>
+Eigen::ArrayXXd
+derivatives(const Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic>& table,
+            int k)
+{
+  return component(table, k + 1);
+}
+
+/// Values of functions at points of dual numbers, given their values and
+/// first derivatives at the values of the points: the derivatives of the
+/// result follow by the chain rule
+/// @param[in] x Points, of shape (npoints, tdim)
+/// @param[in] tables The values, of shape (npoints, nfunctions), followed
+/// by the derivatives in each of the tdim directions, as given by
+/// polyset::tabulate or FiniteElement::tabulate with nd = 1
+/// @return The values as dual numbers
+template <int N>
+Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic>
+chain_rule(const Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic>& x,
+           const std::vector<Eigen::ArrayXXd>& tables)
+{
+  if (static_cast<int>(tables.size()) != x.cols() + 1)
+    throw std::runtime_error("Tables do not match points");
+
+  Eigen::Array<Dual<N>, Eigen::Dynamic, Eigen::Dynamic> result(
+      x.rows(), tables[0].cols());
+  component(result, 0) = tables[0];
+  for (int k = 1; k < N + 1; ++k)
+  {
+    // d/dt_k f(x) = sum_j df/dx_j dx_j/dt_k
+    auto r = component(result, k);
+    r.setZero();
+    for (int j = 0; j < x.cols(); ++j)
+    {
+      const Eigen::ArrayXd dx = component(x, k).col(j);
+      r += tables[1 + j].colwise() * dx;
+    }
+  }
+
+  return result;
+}
+
+} // namespace dual
+} // namespace libtab
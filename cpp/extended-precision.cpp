@@ -0,0 +1,79 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "extended-precision.h"
+#include "double-double.h"
+#include "lagrange.h"
+#include "nedelec.h"
+#include "raviart-thomas.h"
+#include <Eigen/Dense>
+#include <stdexcept>
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+Eigen::MatrixXd round_to_double(
+    const Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>& A)
+{
+  Eigen::MatrixXd B(A.rows(), A.cols());
+  for (int j = 0; j < A.cols(); ++j)
+    for (int i = 0; i < A.rows(); ++i)
+      B(i, j) = A(i, j).hi();
+  return B;
+}
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+bool extended_precision::supported(const std::string& family)
+{
+  return family == "Lagrange" or family == "Discontinuous Lagrange"
+         or family == "Raviart-Thomas"
+         or family == "Nedelec 1st kind H(curl)";
+}
+//-----------------------------------------------------------------------------
+FiniteElement extended_precision::create_element(const std::string& family,
+                                                 cell::type celltype,
+                                                 int degree)
+{
+  using T = DoubleDouble;
+
+  // The element constructors solve for the coefficients in double
+  // precision, so only their dof layout is used, and the span and dual
+  // matrices are built by the same functions in double-double arithmetic
+  DofLayout layout;
+  Eigen::MatrixXd coeffs;
+  if (family == "Lagrange" or family == "Discontinuous Lagrange")
+  {
+    layout = (family == "Lagrange") ? lagrange_layout(celltype, degree)
+                                    : dlagrange_layout(celltype, degree);
+    coeffs = round_to_double(
+        lagrange_coefficients<T>(celltype, degree, layout.points));
+  }
+  else if (family == "Raviart-Thomas")
+  {
+    layout = rt_layout(celltype, degree);
+    coeffs = round_to_double(compute_expansion_coefficients(
+        rt_space<T>(celltype, degree), rt_dual<T>(celltype, degree)));
+  }
+  else if (family == "Nedelec 1st kind H(curl)")
+  {
+    layout = nedelec_layout(celltype, degree);
+    coeffs = round_to_double(
+        compute_expansion_coefficients(nedelec_space<T>(celltype, degree),
+                                       nedelec_dual<T>(celltype, degree)));
+  }
+  else
+  {
+    throw std::runtime_error("Family not supported in extended precision: \""
+                             + family + "\"");
+  }
+
+  return FiniteElement(family, celltype, degree, layout.value_shape, coeffs,
+                       layout.entity_dofs, layout.base_permutations,
+                       layout.points);
+}
+//-----------------------------------------------------------------------------
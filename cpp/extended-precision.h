@@ -0,0 +1,50 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "cell.h"
+#include "libtab.h"
+#include <string>
+
+namespace libtab
+{
+
+/// ## Element construction in extended precision
+/// The expansion coefficients of an element solve a linear system with the
+/// matrix B D^T of the span coefficients B and the dual matrix D (see
+/// compute_expansion_coefficients), whose condition number grows quickly
+/// with the degree for equispaced Lagrange points and for moments against
+/// equispaced Lagrange spaces. At high degree, the coefficients computed
+/// in double precision lose digits.
+///
+/// Here the polynomial set, the quadrature rules, the moment spaces, B, D
+/// and the solve are all evaluated in double-double arithmetic (see
+/// DoubleDouble), and only the final coefficients are rounded to double,
+/// so that they are accurate to rounding as long as the condition number
+/// is below about 1e16. This is several times slower than the
+/// construction in double precision, and the cost grows with the cube of
+/// the number of dofs.
+namespace extended_precision
+{
+
+/// Whether an element family can be constructed in extended precision.
+/// These are Lagrange, Discontinuous Lagrange, Raviart-Thomas and Nedelec
+/// 1st kind H(curl).
+/// @param[in] family The element family
+bool supported(const std::string& family);
+
+/// Create an element with its expansion coefficients computed in
+/// double-double arithmetic. Everything else about the element (dofs,
+/// points, base permutations) is as for the element created in double
+/// precision.
+/// @param[in] family The element family, which must be supported
+/// @param[in] celltype The cell type
+/// @param[in] degree The degree
+/// @return The element
+FiniteElement create_element(const std::string& family, cell::type celltype,
+                             int degree);
+
+} // namespace extended_precision
+} // namespace libtab
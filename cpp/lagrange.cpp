@@ -4,18 +4,20 @@
 
 #include "lagrange.h"
 #include "dof-permutations.h"
+#include "double-double.h"
 #include "lattice.h"
 #include "libtab.h"
+#include "polyset-scalar.h"
 #include "polyset.h"
 #include <Eigen/Dense>
+#include <cmath>
 #include <iostream>
 #include <numeric>
 
 using namespace libtab;
 
 //----------------------------------------------------------------------------
-FiniteElement libtab::create_lagrange(cell::type celltype, int degree,
-                                      const std::string& name)
+DofLayout libtab::lagrange_layout(cell::type celltype, int degree)
 {
   if (celltype == cell::type::point)
     throw std::runtime_error("Invalid celltype");
@@ -125,17 +127,49 @@ FiniteElement libtab::create_lagrange(cell::type celltype, int degree,
     }
   }
 
+  return {{1}, entity_dofs, base_permutations, pt};
+}
+//----------------------------------------------------------------------------
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+libtab::lagrange_coefficients(cell::type celltype, int degree,
+                              const Eigen::ArrayXXd& points)
+{
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+  polyset::Table<T> x(points.rows(), points.cols());
+  for (int i = 0; i < points.rows(); ++i)
+  {
+    for (int j = 0; j < points.cols(); ++j)
+    {
+      const double n = std::round(points(i, j) * degree);
+      if (degree > 0 and std::abs(points(i, j) * degree - n) < 1e-10)
+        x(i, j) = T(n) / T(degree);
+      else
+        x(i, j) = T(points(i, j));
+    }
+  }
+
   // Point evaluation of basis
-  Eigen::MatrixXd dualmat = polyset::tabulate(celltype, degree, 0, pt)[0];
-  Eigen::MatrixXd coeffs = compute_expansion_coefficients(
-      Eigen::MatrixXd::Identity(ndofs, ndofs), dualmat);
+  const Matrix dualmat
+      = polyset::tabulate_values(celltype, degree, x).matrix();
+  const Matrix span = Matrix::Identity(dualmat.rows(), dualmat.rows());
+  return compute_expansion_coefficients(span, dualmat);
+}
+//----------------------------------------------------------------------------
+FiniteElement libtab::create_lagrange(cell::type celltype, int degree,
+                                      const std::string& name)
+{
+  const DofLayout layout = lagrange_layout(celltype, degree);
+  const Eigen::MatrixXd coeffs
+      = lagrange_coefficients<double>(celltype, degree, layout.points);
 
-  return FiniteElement(name, celltype, degree, {1}, coeffs, entity_dofs,
-                       base_permutations);
+  return FiniteElement(name, celltype, degree, layout.value_shape, coeffs,
+                       layout.entity_dofs, layout.base_permutations,
+                       layout.points);
 }
 //-----------------------------------------------------------------------------
-FiniteElement libtab::create_dlagrange(cell::type celltype, int degree,
-                                       const std::string& name)
+DofLayout libtab::dlagrange_layout(cell::type celltype, int degree)
 {
   if (celltype != cell::type::interval and celltype != cell::type::triangle
       and celltype != cell::type::tetrahedron)
@@ -166,12 +200,6 @@ FiniteElement libtab::create_dlagrange(cell::type celltype, int degree,
       pt.row(j) += (geometry.row(k + 1) - geometry.row(0)) * lattice(j, k);
   }
 
-  // Point evaluation of basis
-  Eigen::MatrixXd dualmat = polyset::tabulate(celltype, degree, 0, pt)[0];
-
-  Eigen::MatrixXd coeffs = compute_expansion_coefficients(
-      Eigen::MatrixXd::Identity(ndofs, ndofs), dualmat);
-
   int perm_count = 0;
   for (std::size_t i = 1; i < topology.size() - 1; ++i)
     perm_count += topology[i].size() * i;
@@ -179,7 +207,37 @@ FiniteElement libtab::create_dlagrange(cell::type celltype, int degree,
   std::vector<Eigen::MatrixXd> base_permutations(
       perm_count, Eigen::MatrixXd::Identity(ndofs, ndofs));
 
-  return FiniteElement(name, celltype, degree, {1}, coeffs, entity_dofs,
-                       base_permutations);
+  return {{1}, entity_dofs, base_permutations, pt};
 }
 //-----------------------------------------------------------------------------
+FiniteElement libtab::create_dlagrange(cell::type celltype, int degree,
+                                       const std::string& name)
+{
+  const DofLayout layout = dlagrange_layout(celltype, degree);
+  const Eigen::MatrixXd coeffs
+      = lagrange_coefficients<double>(celltype, degree, layout.points);
+
+  return FiniteElement(name, celltype, degree, layout.value_shape, coeffs,
+                       layout.entity_dofs, layout.base_permutations,
+                       layout.points);
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+moments::MomentSpace<T> libtab::dlagrange_space(cell::type celltype,
+                                                int degree)
+{
+  const DofLayout layout = dlagrange_layout(celltype, degree);
+  return {celltype, degree,
+          lagrange_coefficients<T>(celltype, degree, layout.points)};
+}
+//-----------------------------------------------------------------------------
+template Eigen::MatrixXd
+libtab::lagrange_coefficients<double>(cell::type, int, const Eigen::ArrayXXd&);
+template Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>
+libtab::lagrange_coefficients<DoubleDouble>(cell::type, int,
+                                            const Eigen::ArrayXXd&);
+template moments::MomentSpace<double>
+libtab::dlagrange_space<double>(cell::type, int);
+template moments::MomentSpace<DoubleDouble>
+libtab::dlagrange_space<DoubleDouble>(cell::type, int);
+//-----------------------------------------------------------------------------
@@ -6,10 +6,48 @@
 
 #include "cell.h"
 #include "libtab.h"
+#include "moments.h"
 #include <string>
 
 namespace libtab
 {
+/// Dofs of the Lagrange element on cell with given degree, without
+/// computing its expansion coefficients
+/// @param[in] celltype interval, triangle or tetrahedral celltype
+/// @param[in] degree
+/// @return The dofs, at equispaced points ordered by topology (vertices
+/// first)
+DofLayout lagrange_layout(cell::type celltype, int degree);
+
+/// Dofs of the discontinuous Lagrange element on cell with given degree,
+/// without computing its expansion coefficients
+/// @param[in] celltype interval, triangle or tetrahedral celltype
+/// @param[in] degree
+/// @return The dofs, at equispaced points associated with the interior
+DofLayout dlagrange_layout(cell::type celltype, int degree);
+
+/// Expansion coefficients of the Lagrange element with point evaluation
+/// dofs at the given points, in the arithmetic of T (double or
+/// DoubleDouble). Coordinates within 1e-10 of a multiple of 1/degree are
+/// taken to be exactly that multiple, so that lattice points are exact in
+/// T.
+/// @param[in] celltype The cell type
+/// @param[in] degree
+/// @param[in] points The points, ordered by dof
+/// @return The expansion coefficients, of shape (ndofs, ndofs)
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+lagrange_coefficients(cell::type celltype, int degree,
+                      const Eigen::ArrayXXd& points);
+
+/// The Discontinuous Lagrange element as a space to take integral moments
+/// against, in the arithmetic of T (double or DoubleDouble)
+/// @param[in] celltype interval, triangle or tetrahedral celltype
+/// @param[in] degree
+/// @return The moment space
+template <typename T>
+moments::MomentSpace<T> dlagrange_space(cell::type celltype, int degree);
+
 /// Create a Lagrange element on cell with given degree
 /// @param[in] celltype interval, triangle or tetrahedral celltype
 /// @param[in] degree
@@ -4,11 +4,17 @@
 
 #include "libtab.h"
 #include "crouzeix-raviart.h"
+#include "double-double.h"
+#include "extended-precision.h"
 #include "lagrange.h"
+#include "linalg.h"
 #include "nedelec.h"
-#include "polyset.h"
 #include "raviart-thomas.h"
 #include "regge.h"
+#include "symmetric-tensor.h"
+#include "tabulation-plan.h"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <numeric>
 
@@ -17,10 +23,25 @@
 
 using namespace libtab;
 
+namespace
+{
+//-----------------------------------------------------------------------------
+// Identifier for the next element created
+std::atomic<std::size_t> next_element_id(0);
+//-----------------------------------------------------------------------------
+} // namespace
+
 //-----------------------------------------------------------------------------
 libtab::FiniteElement libtab::create_element(std::string family,
-                                             std::string cell, int degree)
+                                             std::string cell, int degree,
+                                             precision p)
 {
+  if (p == precision::double_double)
+  {
+    return extended_precision::create_element(family, cell::str_to_type(cell),
+                                              degree);
+  }
+
   if (family == "Lagrange")
     return create_lagrange(cell::str_to_type(cell), degree, family);
   else if (family == "Discontinuous Lagrange")
@@ -49,7 +70,8 @@ libtab::compute_expansion_coefficients(const Eigen::MatrixXd& coeffs,
   std::cout << "Dual matrix = \n[" << dual << "]\n";
 #endif
 
-  const Eigen::MatrixXd A = coeffs * dual.transpose();
+  Eigen::MatrixXd A(coeffs.rows(), dual.rows());
+  linalg::matmul(coeffs, dual, A, true);
   if (condition_check)
   {
     Eigen::JacobiSVD svd(A);
@@ -63,7 +85,7 @@ libtab::compute_expansion_coefficients(const Eigen::MatrixXd& coeffs,
     }
   }
 
-  Eigen::MatrixXd new_coeffs = A.colPivHouseholderQr().solve(coeffs);
+  Eigen::MatrixXd new_coeffs = linalg::solve(A, coeffs);
 #ifndef NDEBUG
   std::cout << "New coeffs = \n[" << new_coeffs << "]\n";
 #endif
@@ -71,16 +93,60 @@ libtab::compute_expansion_coefficients(const Eigen::MatrixXd& coeffs,
   return new_coeffs;
 }
 //-----------------------------------------------------------------------------
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+libtab::compute_expansion_coefficients(
+    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& coeffs,
+    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& dual)
+{
+  const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> A
+      = coeffs * dual.transpose();
+  return A.partialPivLu().solve(coeffs);
+}
+//-----------------------------------------------------------------------------
+template Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>
+libtab::compute_expansion_coefficients(
+    const Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>&,
+    const Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>&);
+//-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 FiniteElement::FiniteElement(
     std::string name, cell::type cell_type, int degree,
     const std::vector<int>& value_shape, const Eigen::ArrayXXd& coeffs,
     const std::vector<std::vector<int>>& entity_dofs,
-    const std::vector<Eigen::MatrixXd>& base_permutations)
-    : _cell_type(cell_type), _degree(degree), _value_shape(value_shape),
-      _coeffs(coeffs), _entity_dofs(entity_dofs),
-      _base_permutations(base_permutations), _family_name(name)
+    const std::vector<Eigen::MatrixXd>& base_permutations,
+    const Eigen::ArrayXXd& points, bool symmetric)
+    : _id(next_element_id++), _cell_type(cell_type), _degree(degree),
+      _value_shape(value_shape), _coeffs(coeffs), _entity_dofs(entity_dofs),
+      _base_permutations(base_permutations), _family_name(name),
+      _points(points)
 {
+  if (symmetric)
+  {
+    if (value_shape.size() != 2 or value_shape[0] != value_shape[1])
+      throw std::runtime_error("Symmetric values must be square tensors");
+    _value_map = symmetric_tensor::value_map(value_shape[0]);
+  }
+  else
+  {
+    _value_map.resize(value_size());
+    std::iota(_value_map.begin(), _value_map.end(), 0);
+  }
+
+  // Split the coefficients by stored value component, for the kernels of
+  // TabulationPlan
+  const int psize = polyset::dim(_cell_type, _degree);
+  auto blocks = std::make_shared<std::vector<Eigen::MatrixXd>>();
+  auto blocks_t = std::make_shared<std::vector<Eigen::MatrixXd>>();
+  for (int c = 0; c < stored_value_size(); ++c)
+  {
+    blocks->push_back(_coeffs.block(0, psize * c, _coeffs.rows(), psize));
+    blocks_t->push_back(blocks->back().transpose());
+  }
+  _coeff_blocks = blocks;
+  _coeff_blocks_t = blocks_t;
+  _dg_operators = std::make_shared<DGOperators>();
+
   // Check that entity dofs add up to total number of dofs
   int sum = 0;
   for (const std::vector<int>& q : entity_dofs)
@@ -91,6 +157,80 @@ FiniteElement::FiniteElement(
     throw std::runtime_error(
         "Number of entity dofs does not match total number of dofs");
   }
+
+  // Dofs are numbered by entity, in order of dimension then entity index
+  const std::size_t ndims = _entity_dofs.size();
+  _entity_dof_offsets.resize(ndims);
+  _entity_dof_indices.resize(ndims);
+  int dof = 0;
+  for (std::size_t d = 0; d < ndims; ++d)
+  {
+    _entity_dof_offsets[d] = {0};
+    for (int n : _entity_dofs[d])
+    {
+      for (int i = 0; i < n; ++i)
+        _entity_dof_indices[d].push_back(dof++);
+      _entity_dof_offsets[d].push_back(_entity_dof_indices[d].size());
+    }
+  }
+
+  // The closure of an entity contains the sub-entities whose vertices are
+  // all vertices of the entity
+  const std::vector<std::vector<std::vector<int>>> topology
+      = cell::topology(_cell_type);
+  if (topology.size() != ndims)
+    throw std::runtime_error("Entity dofs do not match cell topology");
+  _closure_dof_offsets.resize(ndims);
+  _closure_dof_indices.resize(ndims);
+  for (std::size_t d = 0; d < ndims; ++d)
+  {
+    if (topology[d].size() != _entity_dofs[d].size())
+      throw std::runtime_error("Entity dofs do not match cell topology");
+
+    _closure_dof_offsets[d] = {0};
+    for (const std::vector<int>& vertices : topology[d])
+    {
+      for (std::size_t d1 = 0; d1 <= d; ++d1)
+      {
+        for (std::size_t e = 0; e < topology[d1].size(); ++e)
+        {
+          const std::vector<int>& sub = topology[d1][e];
+          if (std::all_of(sub.begin(), sub.end(), [&](int v) {
+                return std::find(vertices.begin(), vertices.end(), v)
+                       != vertices.end();
+              }))
+          {
+            _closure_dof_indices[d].insert(
+                _closure_dof_indices[d].end(),
+                _entity_dof_indices[d1].begin() + _entity_dof_offsets[d1][e],
+                _entity_dof_indices[d1].begin()
+                    + _entity_dof_offsets[d1][e + 1]);
+          }
+        }
+      }
+      _closure_dof_offsets[d].push_back(_closure_dof_indices[d].size());
+    }
+  }
+
+  _interior_dofs = _entity_dof_indices.back();
+  for (std::size_t d = 0; d + 1 < ndims; ++d)
+  {
+    _interface_dofs.insert(_interface_dofs.end(),
+                           _entity_dof_indices[d].begin(),
+                           _entity_dof_indices[d].end());
+  }
+
+  if (_points.size() > 0)
+  {
+    if (_points.rows() != _coeffs.rows()
+        or _points.cols() != cell::topological_dimension(_cell_type))
+    {
+      throw std::runtime_error("Dof points do not match element");
+    }
+    if (value_size() != 1)
+      throw std::runtime_error("Dof points require a scalar element");
+  }
+  _diff_matrices = std::make_shared<DiffMatrices>();
 }
 //-----------------------------------------------------------------------------
 cell::type FiniteElement::cell_type() const { return _cell_type; }
@@ -110,41 +250,132 @@ const std::vector<int>& FiniteElement::value_shape() const
   return _value_shape;
 }
 //-----------------------------------------------------------------------------
+bool FiniteElement::symmetric() const
+{
+  return static_cast<int>(_value_map.size()) != stored_value_size();
+}
+//-----------------------------------------------------------------------------
+int FiniteElement::stored_value_size() const
+{
+  return _value_map.empty()
+             ? 0
+             : *std::max_element(_value_map.begin(), _value_map.end()) + 1;
+}
+//-----------------------------------------------------------------------------
+const std::vector<int>& FiniteElement::value_map() const { return _value_map; }
+//-----------------------------------------------------------------------------
 int FiniteElement::dim() const { return _coeffs.rows(); }
 //-----------------------------------------------------------------------------
+const Eigen::MatrixXd& FiniteElement::coefficients() const { return _coeffs; }
+//-----------------------------------------------------------------------------
 std::string FiniteElement::family_name() const { return _family_name; }
 //-----------------------------------------------------------------------------
-std::vector<std::vector<int>> FiniteElement::entity_dofs() const
+const std::vector<std::vector<int>>& FiniteElement::entity_dofs() const
 {
   return _entity_dofs;
 }
 //-----------------------------------------------------------------------------
+const std::vector<int>& FiniteElement::entity_dof_offsets(int dim) const
+{
+  return _entity_dof_offsets.at(dim);
+}
+//-----------------------------------------------------------------------------
+const std::vector<int>& FiniteElement::entity_dof_indices(int dim) const
+{
+  return _entity_dof_indices.at(dim);
+}
+//-----------------------------------------------------------------------------
+const std::vector<int>&
+FiniteElement::entity_closure_dof_offsets(int dim) const
+{
+  return _closure_dof_offsets.at(dim);
+}
+//-----------------------------------------------------------------------------
+const std::vector<int>&
+FiniteElement::entity_closure_dof_indices(int dim) const
+{
+  return _closure_dof_indices.at(dim);
+}
+//-----------------------------------------------------------------------------
+const std::vector<int>& FiniteElement::interior_dofs() const
+{
+  return _interior_dofs;
+}
+//-----------------------------------------------------------------------------
+const std::vector<int>& FiniteElement::interface_dofs() const
+{
+  return _interface_dofs;
+}
+//-----------------------------------------------------------------------------
 std::vector<Eigen::ArrayXXd>
-FiniteElement::tabulate(int nd, const Eigen::ArrayXXd& x) const
+FiniteElement::tabulate(int nd, const Eigen::ArrayXXd& x, int nthreads,
+                        int block_size, polyset::coordinates coords) const
 {
-  const int tdim = cell::topological_dimension(_cell_type);
-  if (x.cols() != tdim)
-    throw std::runtime_error("Point dim does not match element dim.");
-
-  std::vector<Eigen::ArrayXXd> basis
-      = polyset::tabulate(_cell_type, _degree, nd, x);
-  const int psize = polyset::dim(_cell_type, _degree);
-  const int ndofs = _coeffs.rows();
-  const int vs = value_size();
-
-  std::vector<Eigen::ArrayXXd> dresult(basis.size(),
-                                       Eigen::ArrayXXd(x.rows(), ndofs * vs));
-  for (std::size_t p = 0; p < dresult.size(); ++p)
-  {
-    for (int j = 0; j < vs; ++j)
+  std::vector<Eigen::ArrayXXd> tables;
+  TabulationPlan(*this, x.rows(), nd, nthreads, block_size)
+      .execute(x, tables, coords);
+  return tables;
+}
+//-----------------------------------------------------------------------------
+std::vector<Eigen::ArrayXXd>
+FiniteElement::tabulate_compact(int nd, const Eigen::ArrayXXd& x,
+                                int nthreads, int block_size) const
+{
+  std::vector<Eigen::ArrayXXd> tables;
+  TabulationPlan(*this, x.rows(), nd, nthreads, block_size, false,
+                 TabulationPlan::default_layout, true)
+      .execute(x, tables);
+  return tables;
+}
+//-----------------------------------------------------------------------------
+tabulation_cache::tables
+FiniteElement::tabulate_cached(int nd, const Eigen::ArrayXXd& x,
+                               int nthreads) const
+{
+  return tabulation_cache::get(_id, nd, x,
+                               [&]() { return tabulate(nd, x, nthreads); });
+}
+//-----------------------------------------------------------------------------
+tabulation_cache::compressed_tables
+FiniteElement::tabulate_cached(int nd, const Eigen::ArrayXXd& x,
+                               CompressedTable::format storage,
+                               int nthreads) const
+{
+  return tabulation_cache::get(_id, nd, x, storage,
+                               [&]() { return tabulate(nd, x, nthreads); });
+}
+//-----------------------------------------------------------------------------
+std::size_t FiniteElement::id() const { return _id; }
+//-----------------------------------------------------------------------------
+const Eigen::ArrayXXd& FiniteElement::points() const { return _points; }
+//-----------------------------------------------------------------------------
+const std::vector<Eigen::MatrixXd>&
+FiniteElement::differentiation_matrices() const
+{
+  DiffMatrices& diff = *_diff_matrices;
+  std::call_once(diff.computed, [&]() {
+    if (_points.size() > 0)
     {
-      dresult[p].block(0, ndofs * j, x.rows(), ndofs)
-          = basis[p].matrix()
-            * _coeffs.block(0, psize * j, _coeffs.rows(), psize).transpose();
+      const std::vector<Eigen::ArrayXXd> tables = tabulate(1, _points);
+      diff.matrices.assign(tables.begin() + 1, tables.end());
     }
-  }
+  });
+  return diff.matrices;
+}
+//-----------------------------------------------------------------------------
+void FiniteElement::differentiate(int direction,
+                                  const Eigen::Ref<const Eigen::MatrixXd>& u,
+                                  Eigen::Ref<Eigen::MatrixXd> du) const
+{
+  const std::vector<Eigen::MatrixXd>& diff = differentiation_matrices();
+  if (diff.empty())
+    throw std::runtime_error("Element does not have dof points");
+  if (direction < 0 or direction >= static_cast<int>(diff.size()))
+    throw std::runtime_error("Invalid direction");
+  if (u.rows() != dim() or du.rows() != dim() or du.cols() != u.cols())
+    throw std::runtime_error("Wrong shape of nodal values");
 
-  return dresult;
+  linalg::matmul(diff[direction], u, du);
 }
 //-----------------------------------------------------------------------------
 std::vector<Eigen::MatrixXd> FiniteElement::base_permutations() const
@@ -4,7 +4,14 @@
 #pragma once
 
 #include "cell.h"
+#include "dual.h"
+#include "polyset-scalar.h"
+#include "symmetric-tensor.h"
+#include "tabulation-cache.h"
 #include <Eigen/Dense>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -141,19 +148,77 @@ compute_expansion_coefficients(const Eigen::MatrixXd& span_coeffs,
                                const Eigen::MatrixXd& dual,
                                bool condition_check = false);
 
+/// Calculates the basis functions of the finite element, as above, in the
+/// arithmetic of T (DoubleDouble), solving with a partial pivoting LU
+/// decomposition
+/// @param[in] span_coeffs The matrix B
+/// @param[in] dual The matrix D
+/// @return The matrix C
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+compute_expansion_coefficients(
+    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& span_coeffs,
+    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& dual);
+
+/// The dofs of an element, without its expansion coefficients. The
+/// element constructors compute this before solving for the coefficients,
+/// so that the coefficients can also be computed in another way (see
+/// extended_precision::create_element).
+struct DofLayout
+{
+  /// Value shape
+  std::vector<int> value_shape;
+
+  /// Number of dofs associated with each cell entity, by dimension
+  std::vector<std::vector<int>> entity_dofs;
+
+  /// Base permutations of the dofs
+  std::vector<Eigen::MatrixXd> base_permutations;
+
+  /// Points of point evaluation dofs, ordered by dof (empty for elements
+  /// with other dofs)
+  Eigen::ArrayXXd points;
+};
+
+class FiniteElement;
+class TabulationPlan;
+
+namespace dg
+{
+struct Operators;
+std::shared_ptr<const Operators> operators(const FiniteElement& element);
+} // namespace dg
+
 class FiniteElement
 {
   /// Finite Element
   /// The basis is stored as a set of coefficients, which are applied to the
   /// underlying expansion set for that cell type, when tabulating.
 
+  // Plans share the coefficient blocks of the element
+  friend class TabulationPlan;
+
+  // The DG operators are cached on the element
+  friend std::shared_ptr<const dg::Operators>
+  dg::operators(const FiniteElement& element);
+
 public:
   /// A finite element
+  ///
+  /// If the dofs are point evaluations of a scalar element, the points can
+  /// be given, in the order of the dofs. The nodal differentiation
+  /// matrices are then computed when they are first used.
+  ///
+  /// If symmetric is set, the values are symmetric tensors of shape
+  /// value_shape = {n, n}, and coeffs only has a block for each of their
+  /// independent components (see symmetric_tensor).
   FiniteElement(std::string family_name, cell::type cell_type, int degree,
                 const std::vector<int>& value_shape,
                 const Eigen::ArrayXXd& coeffs,
                 const std::vector<std::vector<int>>& entity_dofs,
-                const std::vector<Eigen::MatrixXd>& base_permutations);
+                const std::vector<Eigen::MatrixXd>& base_permutations,
+                const Eigen::ArrayXXd& points = Eigen::ArrayXXd(),
+                bool symmetric = false);
 
   /// Copy constructor
   FiniteElement(const FiniteElement& element) = default;
@@ -184,7 +249,108 @@ public:
   /// If a vector result is expected, it will be stacked with all x values,
   /// followed by all y-values (and then z, if any), likewise tensor-valued
   /// results will be stacked in index order.
-  std::vector<Eigen::ArrayXXd> tabulate(int nd, const Eigen::ArrayXXd& x) const;
+  ///
+  /// For large numbers of points, the expansion set is tabulated for one
+  /// tile of points at a time and multiplied by the coefficients straight
+  /// away, so that the expansion set tables stay in cache and only the
+  /// result is written to memory.
+  ///
+  /// @param[in] nthreads The number of threads used for the tables of the
+  /// expansion set (see polyset::tabulate) and for applying the
+  /// coefficients to each derivative, or for the tiles of points. The
+  /// result does not depend on it.
+  /// @param[in] block_size The number of points in each tile. Use 0 to
+  /// tabulate all points at once. The default, -1, chooses tiles for which
+  /// the expansion set tables fit in the L2 cache.
+  /// @param[in] coords The coordinates in which the points are given. On a
+  /// simplex, x may hold the barycentric coordinates of the points, one
+  /// column per vertex, which are passed to the recurrences directly (see
+  /// polyset::tabulate). The derivatives are with respect to the reference
+  /// Cartesian coordinates in either case.
+  std::vector<Eigen::ArrayXXd>
+  tabulate(int nd, const Eigen::ArrayXXd& x, int nthreads = 1,
+           int block_size = -1,
+           polyset::coordinates coords = polyset::coordinates::cartesian) const;
+
+  /// Compute basis values and derivatives at set of points, as
+  /// FiniteElement::tabulate, but with a block only for each stored value
+  /// component (see FiniteElement::value_map). For an element with
+  /// symmetric tensor values, these are the independent components, which
+  /// can be viewed as the full tensor without copying with
+  /// SymmetricTableView. For other elements this is the same as
+  /// FiniteElement::tabulate.
+  /// @return The basis functions (and derivatives), each of shape
+  /// (number of points, stored_value_size * dim)
+  std::vector<Eigen::ArrayXXd> tabulate_compact(int nd,
+                                                const Eigen::ArrayXXd& x,
+                                                int nthreads = 1,
+                                                int block_size = -1) const;
+
+  /// Compute basis values at points with coordinates of scalar type T
+  /// (e.g. double, DoubleDouble or dual numbers, see
+  /// polyset::tabulate_values)
+  ///
+  /// With T = Dual<tdim> and the points seeded by dual::variables, the
+  /// derivatives of the result are the first derivatives of the basis
+  /// functions, as given by tabulate(1, x). With T = Dual<tdim, Dual<tdim>>
+  /// and dual::second_order_variables, the nested derivatives are the
+  /// second derivatives, as given by tabulate(2, x). If the points are instead
+  /// seeded with derivatives with respect to other parameters (e.g. of the
+  /// geometry), the derivatives of the values with respect to these are
+  /// given by the chain rule, exactly rather than with the truncation
+  /// error of finite differences.
+  ///
+  /// @param[in] x The points, of shape (number of points, topological
+  /// dimension)
+  /// @return The basis functions, of shape (number of points, value_size *
+  /// dim), in the same layout as the first table of tabulate
+  template <typename T>
+  polyset::Table<T> tabulate_values(const polyset::Table<T>& x) const;
+
+  /// Compute basis values at points of dual numbers, as above, from the
+  /// values and first derivatives given by tabulate(1, x) by the chain
+  /// rule. This is a faster path than the dual number recurrences for the
+  /// first derivatives.
+  template <int N>
+  polyset::Table<Dual<N>>
+  tabulate_values(const polyset::Table<Dual<N>>& x) const;
+
+  /// Compute basis values and derivatives at set of points, as
+  /// FiniteElement::tabulate, reusing the tables from an earlier call with
+  /// identical points (see tabulation_cache). The tables are shared with
+  /// the cache and with other callers, so they cannot be modified.
+  ///
+  /// @param[in] nd The order of derivatives, up to and including,
+  /// to compute. Use 0 for the basis functions only.
+  /// @param[in] x The points at which to compute the basis functions.
+  /// The shape of x is (number of points, geometric dimension).
+  /// @param[in] nthreads The number of threads used if the tables are
+  /// computed
+  /// @return The basis functions (and derivatives)
+  tabulation_cache::tables tabulate_cached(int nd, const Eigen::ArrayXXd& x,
+                                           int nthreads = 1) const;
+
+  /// Compute basis values and derivatives at set of points, as
+  /// FiniteElement::tabulate_cached, with the tables stored in a 16-bit
+  /// format in the cache (see CompressedTable). Only the compressed tables
+  /// are kept, and they are contracted with coefficients directly.
+  ///
+  /// @param[in] nd The order of derivatives, up to and including,
+  /// to compute. Use 0 for the basis functions only.
+  /// @param[in] x The points at which to compute the basis functions.
+  /// The shape of x is (number of points, geometric dimension).
+  /// @param[in] storage The format of the stored values
+  /// @param[in] nthreads The number of threads used if the tables are
+  /// computed
+  /// @return The compressed basis functions (and derivatives)
+  tabulation_cache::compressed_tables
+  tabulate_cached(int nd, const Eigen::ArrayXXd& x,
+                  CompressedTable::format storage, int nthreads = 1) const;
+
+  /// Get an identifier of the element, which is unique to each element
+  /// created in this process and shared by its copies
+  /// @return The identifier
+  std::size_t id() const;
 
   /// Get the element cell type
   /// @return The cell type
@@ -203,11 +369,31 @@ public:
   /// @return Value shape
   const std::vector<int>& value_shape() const;
 
+  /// Whether the values are symmetric tensors, of which only the
+  /// independent components are stored
+  bool symmetric() const;
+
+  /// Get the number of value components which are stored, i.e. the
+  /// number of blocks of the coefficients. This is value_size, or
+  /// n(n+1)/2 for symmetric n x n tensors.
+  int stored_value_size() const;
+
+  /// Get the stored component holding each value component
+  /// @return Vector of size value_size
+  const std::vector<int>& value_map() const;
+
   /// Dimension of the finite element space (number of degrees of
   /// freedom for the element)
   /// @return Number of degrees of freedom
   int dim() const;
 
+  /// Get the expansion coefficients of the basis functions. Row i holds
+  /// the coefficients of basis function i, for each stored value
+  /// component in turn, in the expansion set of the cell (see
+  /// polyset::tabulate).
+  /// @return Matrix of shape (dim, stored_value_size * polyset::dim)
+  const Eigen::MatrixXd& coefficients() const;
+
   /// Get the name of the finite element family
   /// @return The family name
   std::string family_name() const;
@@ -218,7 +404,71 @@ public:
   /// The sum of the entity dofs must match the total number of dofs
   /// reported by FiniteElement::dim,
   /// @return List of entity dof counts on each dimension
-  std::vector<std::vector<int>> entity_dofs() const;
+  const std::vector<std::vector<int>>& entity_dofs() const;
+
+  /// Get the offsets into FiniteElement::entity_dof_indices of the dofs of
+  /// each entity of dimension dim, in compressed sparse row (CSR) format:
+  /// the dofs of entity i are entity_dof_indices(dim)[j] for offsets[i] <=
+  /// j < offsets[i + 1].
+  /// @param[in] dim Topological dimension of the entities
+  /// @return Offsets, with one more entry than the number of entities
+  const std::vector<int>& entity_dof_offsets(int dim) const;
+
+  /// Get the dofs associated with each entity of dimension dim, in the
+  /// order of the entities (see FiniteElement::entity_dof_offsets)
+  /// @param[in] dim Topological dimension of the entities
+  /// @return Dof indices
+  const std::vector<int>& entity_dof_indices(int dim) const;
+
+  /// Get the offsets into FiniteElement::entity_closure_dof_indices of the
+  /// dofs of the closure of each entity of dimension dim (CSR format, as
+  /// FiniteElement::entity_dof_offsets). The closure of an entity includes
+  /// the entity and all its sub-entities, e.g. an edge and its vertices.
+  /// @param[in] dim Topological dimension of the entities
+  /// @return Offsets, with one more entry than the number of entities
+  const std::vector<int>& entity_closure_dof_offsets(int dim) const;
+
+  /// Get the dofs associated with the closure of each entity of dimension
+  /// dim, in increasing order for each entity
+  /// @param[in] dim Topological dimension of the entities
+  /// @return Dof indices
+  const std::vector<int>& entity_closure_dof_indices(int dim) const;
+
+  /// Get the dofs associated with the interior of the cell, which are not
+  /// shared with neighbouring cells and can be eliminated by static
+  /// condensation
+  /// @return Dof indices, in increasing order
+  const std::vector<int>& interior_dofs() const;
+
+  /// Get the dofs associated with the boundary of the cell (all dofs which
+  /// are not interior dofs)
+  /// @return Dof indices, in increasing order
+  const std::vector<int>& interface_dofs() const;
+
+  /// Get the points at which the dofs are evaluated, for elements whose
+  /// dofs are point evaluations
+  /// @return The points, of shape (dim, tdim), or an empty array if the
+  /// element does not have dof points
+  const Eigen::ArrayXXd& points() const;
+
+  /// Get the nodal differentiation matrices, D_i(a, b) = the derivative
+  /// of basis function b in direction i at dof point a, for each direction
+  /// i. Applied to the values of a function at the dof points, D_i gives
+  /// the values of its derivative at the dof points. The matrices are
+  /// computed on the first call, and then shared by copies of the element.
+  /// @return A matrix of shape (dim, dim) for each direction, or no
+  /// matrices if the element does not have dof points
+  const std::vector<Eigen::MatrixXd>& differentiation_matrices() const;
+
+  /// Differentiate functions given by their values at the dof points of
+  /// many cells at once (a single matrix product)
+  /// @param[in] direction The direction of the derivative
+  /// @param[in] u The values at the dof points, of shape (dim, number of
+  /// functions), with one column per cell
+  /// @param[out] du The derivatives at the dof points, of the same shape
+  /// as u
+  void differentiate(int direction, const Eigen::Ref<const Eigen::MatrixXd>& u,
+                     Eigen::Ref<Eigen::MatrixXd> du) const;
 
   /// Get the base permutations
   /// The base permutations represent the effect of rotating or reflecting
@@ -301,6 +551,9 @@ public:
   std::vector<Eigen::MatrixXd> base_permutations() const;
 
 private:
+  // Identifier, shared by copies
+  std::size_t _id;
+
   // Cell type
   cell::type _cell_type;
 
@@ -310,12 +563,31 @@ private:
   // Value shape
   std::vector<int> _value_shape;
 
+  // Stored component of each value component
+  std::vector<int> _value_map;
+
   // Shape function coefficient of expansion sets on cell. If shape
   // function is given by @f$\psi_i = \sum_{k} \phi_{k} \alpha^{i}_{k}@f$,
   // then _coeffs(i, j) = @f$\alpha^i_k@f$. i.e., _coeffs.row(i) are the
   // expansion coefficients for shape function i (@f$\psi_{i}@f$).
   Eigen::MatrixXd _coeffs;
 
+  // The coefficients of each stored value component, of shape (dim,
+  // polyset::dim), and their transposes, in the form used by the kernels.
+  // These are shared by copies of the element and by its tabulation plans,
+  // so that creating a plan does not copy them.
+  std::shared_ptr<const std::vector<Eigen::MatrixXd>> _coeff_blocks,
+      _coeff_blocks_t;
+
+  // DG operators of the element (see dg::operators), computed on first use
+  // and shared by copies of the element
+  struct DGOperators
+  {
+    std::once_flag computed;
+    std::shared_ptr<const dg::Operators> operators;
+  };
+  std::shared_ptr<DGOperators> _dg_operators;
+
   // Number of dofs associated each subentity
   // The dofs of an element are associated with entities of different
   // topological dimension (vertices, edges, faces, cells). The dofs are listed
@@ -323,15 +595,94 @@ private:
   // associated entity, as listed by cell::topology.
   std::vector<std::vector<int>> _entity_dofs;
 
+  // Dofs of each entity, and of the closure of each entity, of each
+  // dimension in CSR format (offsets and indices)
+  std::vector<std::vector<int>> _entity_dof_offsets, _entity_dof_indices;
+  std::vector<std::vector<int>> _closure_dof_offsets, _closure_dof_indices;
+
+  // Dofs associated with the interior and with the boundary of the cell
+  std::vector<int> _interior_dofs, _interface_dofs;
+
   // Base permutations
   std::vector<Eigen::MatrixXd> _base_permutations;
 
   // The name of the finite element family
   std::string _family_name;
+
+  // Points at which the dofs are evaluated (if they are point
+  // evaluations)
+  Eigen::ArrayXXd _points;
+
+  // Nodal differentiation matrices in each direction, computed on first
+  // use and shared by copies of the element
+  struct DiffMatrices
+  {
+    std::once_flag computed;
+    std::vector<Eigen::MatrixXd> matrices;
+  };
+  std::shared_ptr<DiffMatrices> _diff_matrices;
+};
+
+//-----------------------------------------------------------------------------
+template <typename T>
+polyset::Table<T>
+FiniteElement::tabulate_values(const polyset::Table<T>& x) const
+{
+  const polyset::Table<T> basis
+      = polyset::tabulate_values(_cell_type, _degree, x);
+  const int psize = basis.cols();
+  const int ndofs = dim();
+  const int vs = value_size();
+
+  polyset::Table<T> result(x.rows(), vs * ndofs);
+  std::vector<T> row(psize);
+  for (int p = 0; p < x.rows(); ++p)
+  {
+    for (int k = 0; k < psize; ++k)
+      row[k] = basis(p, k);
+    for (int v = 0; v < vs; ++v)
+    {
+      const int offset = _value_map[v] * psize;
+      for (int i = 0; i < ndofs; ++i)
+      {
+        T s(0.0);
+        for (int k = 0; k < psize; ++k)
+          s += row[k] * _coeffs(i, offset + k);
+        result(p, v * ndofs + i) = s;
+      }
+    }
+  }
+
+  return result;
+}
+//-----------------------------------------------------------------------------
+template <int N>
+polyset::Table<Dual<N>>
+FiniteElement::tabulate_values(const polyset::Table<Dual<N>>& x) const
+{
+  if (x.cols() != cell::topological_dimension(_cell_type))
+    throw std::runtime_error("Point dim does not match element dim.");
+
+  const Eigen::ArrayXXd v = dual::component(x, 0);
+  return dual::chain_rule(x, tabulate(1, v));
+}
+//-----------------------------------------------------------------------------
+
+/// Arithmetic in which the expansion coefficients of an element are
+/// computed
+enum class precision
+{
+  /// Double precision
+  standard,
+
+  /// Double-double precision, rounded to double at the end (see
+  /// extended_precision)
+  double_double
 };
 
 /// Create an element by name
-FiniteElement create_element(std::string family, std::string cell, int degree);
+FiniteElement create_element(std::string family, std::string cell, int degree,
+                             precision p = precision::standard);
 
 /// Return the version number of libtab across projects
 /// @return version string
@@ -2,7 +2,18 @@ import os
 
 # Public interface
 from ._libtabcpp import __version__
-from ._libtabcpp import create_element, CellType
+from ._libtabcpp import (create_element, CellType, Coordinates, Precision, TabulationPlan, SymmetricTableView,
+                         CompressedTable, tabulate_polynomial_set_by_order, set_executor, has_blas,
+                         linalg_backends, linalg_autotune, LinalgBackend, tabulation_cache_capacity,
+                         set_tabulation_cache_capacity, tabulation_cache_memory_usage, tabulation_cache_hits,
+                         tabulation_cache_misses, clear_tabulation_cache, pack_orientation, compute_orientation,
+                         realisable_orientations, orientation_transformation, OrientationTables,
+                         dg_mass_matrix, dg_facet_mass_matrices, dg_lift_matrices, TripleProductTensor,
+                         triple_product_polyset, triple_product_element, contract_triple_product,
+                         QuadratureType, compute_gauss_jacobi_rule, compute_gauss_radau_rule,
+                         clear_quadrature_cache, make_reduced_quadrature, MomentFitting,
+                         make_moment_fitted_quadrature, NumaPolicy, has_numa, num_numa_nodes, numa_empty,
+                         numa_page_nodes, page_size, HugePagePolicy, set_huge_page_policy, get_huge_page_policy)
 
 
 # To possibly be removed
@@ -0,0 +1,245 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "linalg.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+using namespace libtab;
+
+#ifdef LIBTAB_HAS_BLAS
+extern "C"
+{
+  void dgemm_(const char* transa, const char* transb, const int* m,
+              const int* n, const int* k, const double* alpha,
+              const double* a, const int* lda, const double* b,
+              const int* ldb, const double* beta, double* c, const int* ldc);
+  void dgelsy_(const int* m, const int* n, const int* nrhs, double* a,
+               const int* lda, double* b, const int* ldb, int* jpvt,
+               const double* rcond, int* rank, double* work,
+               const int* lwork, int* info);
+}
+#endif
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Backend for each shape class. Without tuning, BLAS is used for the
+// largest products only.
+struct Choices
+{
+  Choices()
+  {
+    for (int i = 0; i < linalg::num_shape_classes; ++i)
+    {
+      const bool large = (i % 5) > 2;
+      c[i] = static_cast<int>((linalg::has_blas() and large)
+                                  ? linalg::backend::blas
+                                  : linalg::backend::eigen);
+    }
+  }
+  std::array<std::atomic<int>, linalg::num_shape_classes> c;
+};
+//-----------------------------------------------------------------------------
+std::array<std::atomic<int>, linalg::num_shape_classes>& choices()
+{
+  static Choices c;
+  return c.c;
+}
+//-----------------------------------------------------------------------------
+void matmul_eigen(const Eigen::Ref<const Eigen::MatrixXd>& A,
+                  const Eigen::Ref<const Eigen::MatrixXd>& B,
+                  Eigen::Ref<Eigen::MatrixXd> C, bool transpose_b)
+{
+  if (transpose_b)
+    C.noalias() = A * B.transpose();
+  else
+    C.noalias() = A * B;
+}
+//-----------------------------------------------------------------------------
+#ifdef LIBTAB_HAS_BLAS
+linalg::backend choice(int shape)
+{
+  static const bool tuned = std::getenv("LIBTAB_AUTOTUNE") != nullptr
+                            and (linalg::autotune(), true);
+  (void)tuned;
+  return static_cast<linalg::backend>(choices()[shape].load());
+}
+//-----------------------------------------------------------------------------
+void matmul_blas(const Eigen::Ref<const Eigen::MatrixXd>& A,
+                 const Eigen::Ref<const Eigen::MatrixXd>& B,
+                 Eigen::Ref<Eigen::MatrixXd> C, bool transpose_b)
+{
+  const char ta = 'N';
+  const char tb = transpose_b ? 'T' : 'N';
+  const int m = C.rows();
+  const int n = C.cols();
+  const int k = A.cols();
+  const double alpha = 1.0;
+  const double beta = 0.0;
+  // Leading dimensions must be at least 1, even for empty matrices
+  const int lda = std::max<int>(1, A.outerStride());
+  const int ldb = std::max<int>(1, B.outerStride());
+  const int ldc = std::max<int>(1, C.outerStride());
+  dgemm_(&ta, &tb, &m, &n, &k, &alpha, A.data(), &lda, B.data(), &ldb, &beta,
+         C.data(), &ldc);
+}
+//-----------------------------------------------------------------------------
+Eigen::MatrixXd solve_lapack(const Eigen::MatrixXd& A,
+                             const Eigen::MatrixXd& B)
+{
+  const int m = A.rows();
+  const int n = A.cols();
+  const int nrhs = B.cols();
+  const int lda = std::max(1, m);
+  const int ldb = std::max(1, std::max(m, n));
+
+  Eigen::MatrixXd a = A;
+  Eigen::MatrixXd b = Eigen::MatrixXd::Zero(ldb, nrhs);
+  b.topRows(m) = B;
+
+  std::vector<int> jpvt(n, 0);
+  const double rcond
+      = std::numeric_limits<double>::epsilon() * std::max(m, n);
+  int rank, info;
+
+  // Workspace query
+  int lwork = -1;
+  double wsize;
+  dgelsy_(&m, &n, &nrhs, a.data(), &lda, b.data(), &ldb, jpvt.data(), &rcond,
+          &rank, &wsize, &lwork, &info);
+  lwork = static_cast<int>(wsize);
+  std::vector<double> work(lwork);
+  dgelsy_(&m, &n, &nrhs, a.data(), &lda, b.data(), &ldb, jpvt.data(), &rcond,
+          &rank, work.data(), &lwork, &info);
+  if (info != 0)
+    throw std::runtime_error("LAPACK dgelsy failed");
+
+  // A rank deficient A would give the minimum norm solution, which is not
+  // the solution of the Eigen backend
+  if (rank < n)
+    throw std::runtime_error("Rank deficient matrix in linalg::solve");
+
+  return b.topRows(n);
+}
+#endif
+//-----------------------------------------------------------------------------
+// Best of three timings of f, in seconds
+template <typename F>
+double time(F f)
+{
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < 3; ++i)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(end - start).count());
+  }
+  return best;
+}
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+int linalg::shape_class(int m, int n, int k)
+{
+  // Five classes by operation count, from below 1e4 to above 1e7, for each
+  // of square-ish and skinny products
+  const double flops = 2.0 * m * n * k;
+  const int size = std::clamp(static_cast<int>(std::log10(flops + 1.0)) - 3,
+                              0, 4);
+  const bool skinny = std::min(m, std::min(n, k)) <= 8;
+  return size + (skinny ? 5 : 0);
+}
+//-----------------------------------------------------------------------------
+void linalg::matmul(const Eigen::Ref<const Eigen::MatrixXd>& A,
+                    const Eigen::Ref<const Eigen::MatrixXd>& B,
+                    Eigen::Ref<Eigen::MatrixXd> C, bool transpose_b)
+{
+  assert(A.rows() == C.rows());
+  assert((transpose_b ? B.rows() : B.cols()) == C.cols());
+#ifdef LIBTAB_HAS_BLAS
+  if (choice(shape_class(C.rows(), C.cols(), A.cols())) == backend::blas)
+  {
+    matmul_blas(A, B, C, transpose_b);
+    return;
+  }
+#endif
+  matmul_eigen(A, B, C, transpose_b);
+}
+//-----------------------------------------------------------------------------
+Eigen::MatrixXd linalg::solve(const Eigen::MatrixXd& A,
+                              const Eigen::MatrixXd& B)
+{
+#ifdef LIBTAB_HAS_BLAS
+  if (choice(shape_class(A.cols(), B.cols(), A.rows())) == backend::blas)
+    return solve_lapack(A, B);
+#endif
+  const Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(A);
+  if (qr.rank() < A.cols())
+    throw std::runtime_error("Rank deficient matrix in linalg::solve");
+  return qr.solve(B);
+}
+//-----------------------------------------------------------------------------
+bool linalg::has_blas()
+{
+#ifdef LIBTAB_HAS_BLAS
+  return true;
+#else
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+std::vector<linalg::backend> linalg::backends()
+{
+  std::vector<backend> b;
+  for (const std::atomic<int>& c : choices())
+    b.push_back(static_cast<backend>(c.load()));
+  return b;
+}
+//-----------------------------------------------------------------------------
+void linalg::set_backend(int shape, backend b)
+{
+  if (shape < 0 or shape >= num_shape_classes)
+    throw std::runtime_error("Invalid shape class");
+  if (b == backend::blas and !has_blas())
+    throw std::runtime_error("libtab was built without BLAS");
+  choices()[shape] = static_cast<int>(b);
+}
+//-----------------------------------------------------------------------------
+std::vector<linalg::backend> linalg::autotune()
+{
+#ifdef LIBTAB_HAS_BLAS
+  for (int shape = 0; shape < num_shape_classes; ++shape)
+  {
+    // Representative product for the class: points x dofs x psize for the
+    // skinny classes, and a square product otherwise
+    const double flops = 2.0 * std::pow(10.0, shape % 5 + 3.5);
+    int m, n, k;
+    if (shape < 5)
+      m = n = k = std::max(9, static_cast<int>(std::cbrt(flops / 2.0)));
+    else
+    {
+      n = 4;
+      m = k = std::max(1, static_cast<int>(std::sqrt(flops / (2.0 * n))));
+    }
+
+    const Eigen::MatrixXd A = Eigen::MatrixXd::Random(m, k);
+    const Eigen::MatrixXd B = Eigen::MatrixXd::Random(n, k);
+    Eigen::MatrixXd C(m, n);
+    const double t_eigen = time([&]() { matmul_eigen(A, B, C, true); });
+    const double t_blas = time([&]() { matmul_blas(A, B, C, true); });
+    choices()[shape] = static_cast<int>(t_blas < t_eigen ? backend::blas
+                                                          : backend::eigen);
+  }
+#endif
+  return backends();
+}
+//-----------------------------------------------------------------------------
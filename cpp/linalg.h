@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <vector>
+
+namespace libtab
+{
+
+/// ## Dense linear algebra kernels
+/// The large matrix products and solves in libtab go through these
+/// functions. When libtab is built with LIBTAB_USE_BLAS, each call is
+/// executed either by Eigen or by the external BLAS/LAPACK library,
+/// depending on the backend chosen for its shape class. The shape classes
+/// group calls by the number of floating point operations, and by whether
+/// the smallest dimension is small (skinny products), as these are the
+/// factors which decide which implementation is faster.
+namespace linalg
+{
+
+/// Implementation of the kernels
+enum class backend
+{
+  eigen,
+  blas
+};
+
+/// Number of shape classes
+constexpr int num_shape_classes = 10;
+
+/// Shape class of a product of an (m x k) and a (k x n) matrix
+/// @param m Number of rows of the result
+/// @param n Number of columns of the result
+/// @param k Inner dimension
+/// @return Index of the shape class
+int shape_class(int m, int n, int k);
+
+/// Compute C = A B, or C = A B^T if transpose_b is set
+/// @param[in] A Left hand matrix
+/// @param[in] B Right hand matrix
+/// @param[out] C Result, which must have the correct size and must not
+/// alias A or B
+/// @param[in] transpose_b Use the transpose of B
+void matmul(const Eigen::Ref<const Eigen::MatrixXd>& A,
+            const Eigen::Ref<const Eigen::MatrixXd>& B,
+            Eigen::Ref<Eigen::MatrixXd> C, bool transpose_b = false);
+
+/// Solve A X = B in the least squares sense, using QR factorisation with
+/// column pivoting. Both backends throw if A does not have full column
+/// rank, so that they give the same solution.
+/// @param[in] A Matrix
+/// @param[in] B Right hand sides
+/// @return The solution X
+Eigen::MatrixXd solve(const Eigen::MatrixXd& A, const Eigen::MatrixXd& B);
+
+/// Whether libtab was built with an external BLAS/LAPACK
+bool has_blas();
+
+/// Get the backend used for each shape class
+/// @return The backend for each shape class
+std::vector<backend> backends();
+
+/// Set the backend used for a shape class
+/// @param[in] shape The shape class
+/// @param[in] b The backend. Requesting blas when libtab was not built
+/// with BLAS is an error.
+void set_backend(int shape, backend b);
+
+/// Time Eigen and BLAS on a representative product for each shape class,
+/// and use the faster one for that class from now on. This is run at
+/// startup if the environment variable LIBTAB_AUTOTUNE is set. Without
+/// BLAS, all classes use Eigen.
+/// @return The backend chosen for each shape class
+std::vector<backend> autotune();
+
+} // namespace linalg
+} // namespace libtab
@@ -0,0 +1,91 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace libtab
+{
+
+/// A map holding at most a given number of entries, which discards the
+/// least recently used entry when a new entry does not fit. It is safe to
+/// use from several threads.
+template <typename Key, typename Value>
+class LRUCache
+{
+public:
+  /// Create an empty cache
+  /// @param[in] capacity Maximum number of entries
+  explicit LRUCache(std::size_t capacity) : _capacity(capacity) {}
+
+  /// Find the value of a key, which becomes the most recently used entry
+  /// @param[in] key The key
+  /// @return The value, or nothing if there is no entry for the key
+  std::optional<Value> find(const Key& key)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _index.find(key);
+    if (it == _index.end())
+      return std::nullopt;
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return it->second->second;
+  }
+
+  /// Insert a value, unless there is already an entry for the key (e.g.
+  /// inserted by another thread)
+  /// @param[in] key The key
+  /// @param[in] value The value
+  /// @return The value of the entry for the key
+  Value insert(const Key& key, Value value)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _index.find(key);
+    if (it != _index.end())
+    {
+      _entries.splice(_entries.begin(), _entries, it->second);
+      return it->second->second;
+    }
+    if (_capacity == 0)
+      return value;
+
+    _entries.emplace_front(key, std::move(value));
+    _index.emplace(key, _entries.begin());
+    evict();
+    return _entries.front().second;
+  }
+
+  /// Discard all entries
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _index.clear();
+  }
+
+private:
+  // Discard the least recently used entries until the cache fits
+  void evict()
+  {
+    while (_entries.size() > _capacity)
+    {
+      _index.erase(_entries.back().first);
+      _entries.pop_back();
+    }
+  }
+
+  std::mutex _mutex;
+  std::size_t _capacity;
+
+  // Entries, most recently used first, and the entry of each key
+  std::list<std::pair<Key, Value>> _entries;
+  std::map<Key, typename std::list<std::pair<Key, Value>>::iterator> _index;
+};
+
+} // namespace libtab
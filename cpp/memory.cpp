@@ -0,0 +1,284 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <utility>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define LIBTAB_HAS_MMAP
+#endif
+
+#ifdef LIBTAB_HAS_NUMA
+#include <numa.h>
+#endif
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Size in bytes of a buffer of n doubles, rounded up to whole pages, or to
+// whole huge pages for large buffers. This does not depend on the huge
+// page policy, so that a buffer is released with the size it was
+// allocated with.
+std::size_t num_bytes(std::size_t n)
+{
+  const std::size_t bytes = std::max<std::size_t>(n * sizeof(double), 1);
+  const std::size_t unit
+      = bytes < memory::huge_page_size ? memory::page_size()
+                                       : memory::huge_page_size;
+  return (bytes + unit - 1) / unit * unit;
+}
+//-----------------------------------------------------------------------------
+// Policy given by LIBTAB_HUGE_PAGES, and the value of the variable if it
+// is not a valid policy (in which case the policy is the default)
+struct Environment
+{
+  memory::huge_page_policy policy = memory::huge_page_policy::none;
+  std::string invalid;
+};
+//-----------------------------------------------------------------------------
+// The environment is read once, when the policy is first needed
+const Environment& environment()
+{
+  static const Environment env = []() {
+    const char* var = std::getenv("LIBTAB_HUGE_PAGES");
+    const std::string value = var ? var : "none";
+    Environment e;
+    if (value == "transparent")
+      e.policy = memory::huge_page_policy::transparent;
+    else if (value == "hugetlb")
+      e.policy = memory::huge_page_policy::hugetlb;
+    else if (value != "none" and !value.empty())
+      e.invalid = value;
+    return e;
+  }();
+  return env;
+}
+//-----------------------------------------------------------------------------
+std::atomic<memory::huge_page_policy>& huge_pages()
+{
+  static std::atomic<memory::huge_page_policy> policy = environment().policy;
+  return policy;
+}
+//-----------------------------------------------------------------------------
+#ifdef LIBTAB_HAS_MMAP
+// Map untouched anonymous memory aligned to a huge page, by mapping an
+// extra huge page and unmapping the ends
+void* map_aligned(std::size_t bytes)
+{
+  const std::size_t align = memory::huge_page_size;
+  void* p = mmap(nullptr, bytes + align, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    return nullptr;
+
+  char* start = static_cast<char*>(p);
+  char* aligned = reinterpret_cast<char*>(
+      (reinterpret_cast<std::uintptr_t>(start) + align - 1) & ~(align - 1));
+  if (aligned > start)
+    munmap(start, aligned - start);
+  if (start + align > aligned)
+    munmap(aligned + bytes, start + align - aligned);
+  return aligned;
+}
+#endif
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+std::size_t memory::page_size()
+{
+  static const std::size_t size = []() -> std::size_t {
+#ifdef _SC_PAGESIZE
+    const long n = sysconf(_SC_PAGESIZE);
+    if (n > 0)
+      return n;
+#endif
+    return 4096;
+  }();
+  return size;
+}
+//-----------------------------------------------------------------------------
+bool memory::has_numa()
+{
+#ifdef LIBTAB_HAS_NUMA
+  static const bool available = numa_available() >= 0;
+  return available;
+#else
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+int memory::num_numa_nodes()
+{
+#ifdef LIBTAB_HAS_NUMA
+  if (has_numa())
+    return numa_num_configured_nodes();
+#endif
+
+  // Count the nodes listed by Linux
+  int n = 0;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(
+           "/sys/devices/system/node", ec))
+  {
+    const std::string name = entry.path().filename().string();
+    if (name.size() > 4 and name.compare(0, 4, "node") == 0
+        and std::isdigit(static_cast<unsigned char>(name[4])))
+    {
+      ++n;
+    }
+  }
+  return std::max(n, 1);
+}
+//-----------------------------------------------------------------------------
+int memory::numa_node([[maybe_unused]] const void* p)
+{
+#ifdef LIBTAB_HAS_NUMA
+  if (has_numa())
+  {
+    // Query the placement without moving (or touching) the page
+    void* page = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(p)
+                                         & ~(page_size() - 1));
+    int status = -1;
+    if (numa_move_pages(0, 1, &page, nullptr, &status, 0) == 0
+        and status >= 0)
+    {
+      return status;
+    }
+  }
+#endif
+  return -1;
+}
+//-----------------------------------------------------------------------------
+void memory::set_huge_page_policy(huge_page_policy policy)
+{
+  huge_pages() = policy;
+}
+//-----------------------------------------------------------------------------
+memory::huge_page_policy memory::get_huge_page_policy() { return huge_pages(); }
+//-----------------------------------------------------------------------------
+std::string memory::invalid_huge_page_environment()
+{
+  return environment().invalid;
+}
+//-----------------------------------------------------------------------------
+void memory::advise_huge_pages([[maybe_unused]] void* p,
+                               [[maybe_unused]] std::size_t bytes)
+{
+#if defined(LIBTAB_HAS_MMAP) and defined(MADV_HUGEPAGE)
+  if (huge_pages() == huge_page_policy::none)
+    return;
+
+  // Only whole huge pages can be backed by a huge page
+  const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(p);
+  const std::uintptr_t first
+      = (start + huge_page_size - 1) & ~(huge_page_size - 1);
+  const std::uintptr_t last = (start + bytes) & ~(huge_page_size - 1);
+  if (last > first)
+    madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE);
+#endif
+}
+//-----------------------------------------------------------------------------
+double* memory::allocate(std::size_t n, [[maybe_unused]] numa_policy policy)
+{
+  const std::size_t bytes = num_bytes(n);
+  const bool huge = bytes >= huge_page_size;
+  void* p = nullptr;
+
+#ifdef LIBTAB_HAS_MMAP
+  // Anonymous pages are not placed until they are first written
+#ifdef MAP_HUGETLB
+  if (huge and huge_pages() == huge_page_policy::hugetlb)
+  {
+    p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED)
+      p = nullptr;
+  }
+#endif
+  if (!p and huge)
+  {
+    p = map_aligned(bytes);
+    if (p)
+      advise_huge_pages(p, bytes);
+  }
+  else if (!p)
+  {
+    p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+      p = nullptr;
+  }
+#else
+  p = std::aligned_alloc(huge ? huge_page_size : page_size(), bytes);
+#endif
+  if (!p)
+    throw std::bad_alloc();
+
+#ifdef LIBTAB_HAS_NUMA
+  // Set the placement before the pages are touched
+  if (has_numa() and policy == numa_policy::local)
+    numa_setlocal_memory(p, bytes);
+  else if (has_numa() and policy == numa_policy::interleave)
+    numa_interleave_memory(p, bytes, numa_all_nodes_ptr);
+#endif
+
+  return static_cast<double*>(p);
+}
+//-----------------------------------------------------------------------------
+void memory::deallocate(double* p, std::size_t n)
+{
+  if (!p)
+    return;
+
+#ifdef LIBTAB_HAS_MMAP
+  munmap(p, num_bytes(n));
+#else
+  std::free(p);
+#endif
+}
+//-----------------------------------------------------------------------------
+memory::Buffer::Buffer(std::size_t n, numa_policy policy)
+    : _data(allocate(n, policy)), _size(n)
+{
+}
+//-----------------------------------------------------------------------------
+memory::Buffer::Buffer(Buffer&& other)
+    : _data(std::exchange(other._data, nullptr)),
+      _size(std::exchange(other._size, 0))
+{
+}
+//-----------------------------------------------------------------------------
+memory::Buffer& memory::Buffer::operator=(Buffer&& other)
+{
+  if (this != &other)
+  {
+    deallocate(_data, _size);
+    _data = std::exchange(other._data, nullptr);
+    _size = std::exchange(other._size, 0);
+  }
+  return *this;
+}
+//-----------------------------------------------------------------------------
+memory::Buffer::~Buffer() { deallocate(_data, _size); }
+//-----------------------------------------------------------------------------
+double* memory::Buffer::data() const { return _data; }
+//-----------------------------------------------------------------------------
+std::size_t memory::Buffer::size() const { return _size; }
+//-----------------------------------------------------------------------------
@@ -0,0 +1,156 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace libtab
+{
+
+/// ## Placement of large buffers
+/// On a machine with several NUMA nodes (e.g. a dual-socket node), the
+/// operating system places a page of memory on the node of the thread
+/// which first writes to it. A buffer which is allocated and initialised
+/// by one thread therefore ends up on one node, and threads on the other
+/// nodes fill it through the (slower) link between the sockets.
+///
+/// The buffers allocated here are left untouched, so that each page is
+/// placed on the node of the thread which first writes to it. For the
+/// output of a parallel tabulation (see TabulationPlan::execute and
+/// TabulationPlan::first_touch) this is the thread which computes the
+/// points of that page. If libtab is built with libnuma (the CMake option
+/// LIBTAB_USE_NUMA), a buffer can instead be placed on the node of the
+/// calling thread, or interleaved over all nodes.
+///
+/// Large buffers (tabulation outputs and the tables held by libtab) can
+/// also be backed by huge pages, which reduces the number of TLB misses
+/// when the tables are read with large strides, e.g. all dofs at one
+/// point in the default layout. This is off by default, and is set at
+/// runtime by memory::set_huge_page_policy or by the environment variable
+/// LIBTAB_HUGE_PAGES (none, transparent or hugetlb). An invalid value of
+/// the variable is ignored, and is given by
+/// memory::invalid_huge_page_environment (the Python module warns about
+/// it when it is imported).
+namespace memory
+{
+
+/// Placement of the pages of a buffer
+enum class numa_policy
+{
+  /// On the node of the thread which first writes to the page
+  first_touch,
+
+  /// On the node of the allocating thread
+  local,
+
+  /// Round-robin over all nodes
+  interleave
+};
+
+/// Use of huge pages for large buffers
+enum class huge_page_policy
+{
+  /// Normal pages only
+  none,
+
+  /// Ask the kernel for transparent huge pages (madvise)
+  transparent,
+
+  /// Map huge pages from the pool reserved by the administrator
+  /// (hugetlbfs), with transparent huge pages if the pool is exhausted
+  hugetlb
+};
+
+/// Size of a huge page. Buffers smaller than this use normal pages.
+constexpr std::size_t huge_page_size = 2 << 20;
+
+/// Set the use of huge pages for buffers allocated from now on
+/// @param[in] policy The policy
+void set_huge_page_policy(huge_page_policy policy);
+
+/// The use of huge pages for large buffers
+huge_page_policy get_huge_page_policy();
+
+/// The value of the environment variable LIBTAB_HUGE_PAGES, if it is not a
+/// valid policy and has been ignored
+/// @return The value, or an empty string if it is valid or not set
+std::string invalid_huge_page_environment();
+
+/// Ask for transparent huge pages for the whole huge pages within memory
+/// which has already been allocated (e.g. by Eigen), if the huge page
+/// policy is not huge_page_policy::none. This has most effect before the
+/// memory is first written.
+/// @param[in] p Start of the memory
+/// @param[in] bytes Size of the memory in bytes
+void advise_huge_pages(void* p, std::size_t bytes);
+
+/// Size of a (normal) page, from the operating system
+std::size_t page_size();
+
+/// Whether libtab was built with libnuma and the system supports it. If
+/// not, all policies behave as numa_policy::first_touch.
+bool has_numa();
+
+/// The number of NUMA nodes, or 1 if this is not known
+int num_numa_nodes();
+
+/// The NUMA node on which the page containing an address is placed
+/// @param[in] p The address
+/// @return The node, or -1 if the page has not been touched yet or the
+/// node is not known
+int numa_node(const void* p);
+
+/// Allocate an uninitialised buffer of doubles, aligned to a page, whose
+/// pages have not been touched. Buffers of at least a huge page are
+/// aligned to a huge page and backed by huge pages according to the huge
+/// page policy.
+/// @param[in] n The number of values
+/// @param[in] policy Placement of the pages
+/// @return The buffer, which must be released with memory::deallocate
+double* allocate(std::size_t n, numa_policy policy = numa_policy::first_touch);
+
+/// Release a buffer from memory::allocate
+/// @param[in] p The buffer
+/// @param[in] n The number of values it was allocated with
+void deallocate(double* p, std::size_t n);
+
+/// A buffer of doubles from memory::allocate which owns its memory
+class Buffer
+{
+public:
+  /// Empty buffer
+  Buffer() = default;
+
+  /// Allocate a buffer with untouched pages
+  /// @param[in] n The number of values
+  /// @param[in] policy Placement of the pages
+  explicit Buffer(std::size_t n,
+                  numa_policy policy = numa_policy::first_touch);
+
+  Buffer(const Buffer&) = delete;
+  Buffer& operator=(const Buffer&) = delete;
+
+  /// Move constructor
+  Buffer(Buffer&& other);
+
+  /// Move assignment
+  Buffer& operator=(Buffer&& other);
+
+  ~Buffer();
+
+  /// The values
+  double* data() const;
+
+  /// The number of values
+  std::size_t size() const;
+
+private:
+  double* _data = nullptr;
+  std::size_t _size = 0;
+};
+
+} // namespace memory
+} // namespace libtab
@@ -0,0 +1,278 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "moment-fitting.h"
+#include "polyset.h"
+#include "quadrature.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Relative residual below which a rule reproduces the moments
+constexpr double residual_tol = 1e-12;
+//-----------------------------------------------------------------------------
+// Total degree of the polynomial set of a cell
+int total_degree(cell::type celltype, int degree)
+{
+  switch (celltype)
+  {
+  case cell::type::interval:
+  case cell::type::triangle:
+  case cell::type::tetrahedron:
+    return degree;
+  case cell::type::quadrilateral:
+  case cell::type::prism:
+    return 2 * degree;
+  case cell::type::hexahedron:
+    return 3 * degree;
+  default:
+    throw std::runtime_error("Unsupported cell type for moment fitting");
+  }
+}
+//-----------------------------------------------------------------------------
+// Least squares solution using the columns of A given by cols
+Eigen::VectorXd lstsq(const Eigen::MatrixXd& A, const std::vector<int>& cols,
+                      const Eigen::VectorXd& b)
+{
+  Eigen::MatrixXd Ap(A.rows(), cols.size());
+  for (std::size_t k = 0; k < cols.size(); ++k)
+    Ap.col(k) = A.col(cols[k]);
+  return Ap.colPivHouseholderQr().solve(b);
+}
+//-----------------------------------------------------------------------------
+// Solve min |Ax - b| subject to x >= 0 with the active set algorithm of
+// Lawson and Hanson, "Solving Least Squares Problems" (1974), chapter 23.
+// On return, passive holds the indices of the nonzero entries of x.
+Eigen::VectorXd nnls(const Eigen::MatrixXd& A, const Eigen::VectorXd& b,
+                     std::vector<int>& passive)
+{
+  const int n = A.cols();
+  Eigen::VectorXd x = Eigen::VectorXd::Zero(n);
+  std::vector<bool> is_passive(n, false);
+  passive.clear();
+
+  const double tol = 1e-14 * A.cwiseAbs().maxCoeff() * std::max(1.0, b.norm())
+                     * std::max(A.rows(), A.cols());
+  for (int iter = 0; iter < 3 * n; ++iter)
+  {
+    // Add the index with the most negative gradient of the residual
+    const Eigen::VectorXd g = A.transpose() * (b - A * x);
+    int j = -1;
+    double gmax = tol;
+    for (int i = 0; i < n; ++i)
+    {
+      if (!is_passive[i] and g[i] > gmax)
+      {
+        gmax = g[i];
+        j = i;
+      }
+    }
+    if (j == -1)
+      break;
+    passive.push_back(j);
+    is_passive[j] = true;
+
+    while (!passive.empty())
+    {
+      const Eigen::VectorXd s = lstsq(A, passive, b);
+      if (s.minCoeff() > 0.0)
+      {
+        for (std::size_t k = 0; k < passive.size(); ++k)
+          x[passive[k]] = s[k];
+        break;
+      }
+
+      // Move towards s until the first entry reaches zero, and remove it
+      // (and any others that reached zero) from the passive set
+      double alpha = 1.0;
+      std::size_t kmin = 0;
+      for (std::size_t k = 0; k < passive.size(); ++k)
+      {
+        const double xk = x[passive[k]];
+        if (s[k] <= 0.0 and xk / (xk - s[k]) < alpha)
+        {
+          alpha = xk / (xk - s[k]);
+          kmin = k;
+        }
+      }
+      for (std::size_t k = 0; k < passive.size(); ++k)
+        x[passive[k]] += alpha * (s[k] - x[passive[k]]);
+      x[passive[kmin]] = 0.0;
+
+      std::vector<int> keep;
+      for (int p : passive)
+      {
+        if (x[p] > 0.0)
+          keep.push_back(p);
+        else
+        {
+          x[p] = 0.0;
+          is_passive[p] = false;
+        }
+      }
+      passive = keep;
+    }
+  }
+
+  return x;
+}
+//-----------------------------------------------------------------------------
+bool reproduces(const Eigen::MatrixXd& A, const std::vector<int>& cols,
+                const Eigen::VectorXd& w, const Eigen::VectorXd& b)
+{
+  Eigen::VectorXd r = -b;
+  for (std::size_t k = 0; k < cols.size(); ++k)
+    r += w[k] * A.col(cols[k]);
+  return r.norm() <= residual_tol * std::max(1.0, b.norm());
+}
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+MomentFitting::MomentFitting(cell::type celltype, int degree)
+    : _cell_type(celltype), _degree(degree),
+      _num_moments(polyset::dim(celltype, degree))
+{
+  // Throws if the cell type is not supported
+  total_degree(celltype, degree);
+}
+//-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd> MomentFitting::subdivision_rule(
+    const std::vector<Eigen::ArrayXXd>& simplices) const
+{
+  const int tdim = cell::topological_dimension(_cell_type);
+  std::vector<std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>> rules;
+  int npoints = 0;
+  for (const Eigen::ArrayXXd& simplex : simplices)
+  {
+    if (simplex.rows() != tdim + 1 or simplex.cols() != tdim)
+      throw std::runtime_error("Invalid simplex in subdivision");
+
+    // The rule with m points in each direction is exact for degree 2m - 1
+    rules.push_back(quadrature::make_quadrature(
+        simplex, total_degree(_cell_type, _degree) / 2 + 1));
+    npoints += rules.back().first.rows();
+  }
+  if (npoints == 0)
+    throw std::runtime_error("Empty subdivision");
+
+  Eigen::ArrayXXd pts(npoints, tdim);
+  Eigen::ArrayXd wts(npoints);
+  int offset = 0;
+  for (const auto& [p, w] : rules)
+  {
+    pts.middleRows(offset, p.rows()) = p;
+    // The simplices may have either orientation
+    wts.segment(offset, w.rows()) = w.abs();
+    offset += p.rows();
+  }
+
+  return {pts, wts};
+}
+//-----------------------------------------------------------------------------
+Eigen::VectorXd
+MomentFitting::moments(const std::vector<Eigen::ArrayXXd>& simplices) const
+{
+  auto [pts, wts] = subdivision_rule(simplices);
+  const Eigen::MatrixXd P = polyset::tabulate(_cell_type, _degree, 0, pts)[0];
+  return P.transpose() * wts.matrix();
+}
+//-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+MomentFitting::fit(const Eigen::VectorXd& moments,
+                   const Eigen::ArrayXXd& candidates)
+{
+  if (moments.rows() != _num_moments)
+    throw std::runtime_error("Wrong number of moments");
+  if (candidates.cols() != cell::topological_dimension(_cell_type))
+    throw std::runtime_error("Candidate points have the wrong dimension");
+
+  // Try the points of the previous fit, then run the full algorithm
+  Eigen::VectorXd w = refit(moments, candidates);
+  if (w.size() == 0)
+  {
+    const Eigen::MatrixXd basis
+        = polyset::tabulate(_cell_type, _degree, 0, candidates)[0]
+              .transpose();
+
+    // The polynomial set is only orthonormal on its own cell, so fit
+    // combinations of the moments which are orthonormal over the
+    // candidates: with basis = U S V^T, fit S^-1 U^T basis = V^T
+    Eigen::JacobiSVD<Eigen::MatrixXd> svd(basis, Eigen::ComputeThinU);
+    const Eigen::VectorXd& sigma = svd.singularValues();
+    int rank = 0;
+    while (rank < sigma.size() and sigma[rank] > 1e-13 * sigma[0])
+      ++rank;
+    const Eigen::MatrixXd transform
+        = sigma.head(rank).cwiseInverse().asDiagonal()
+          * svd.matrixU().leftCols(rank).transpose();
+
+    const Eigen::VectorXd x
+        = nnls(transform * basis, transform * moments, _support);
+    std::sort(_support.begin(), _support.end());
+    _num_candidates = candidates.rows();
+    w.resize(_support.size());
+    for (std::size_t k = 0; k < _support.size(); ++k)
+      w[k] = x[_support[k]];
+    if (!reproduces(basis, _support, w, moments))
+    {
+      _support.clear();
+      throw std::runtime_error("Moment fitting failed: the moments cannot be "
+                               "reproduced by the candidate points");
+    }
+  }
+
+  Eigen::ArrayXXd pts(_support.size(), candidates.cols());
+  for (std::size_t k = 0; k < _support.size(); ++k)
+    pts.row(k) = candidates.row(_support[k]);
+
+  return {pts, w.array()};
+}
+//-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+MomentFitting::fit(const std::vector<Eigen::ArrayXXd>& simplices)
+{
+  auto [pts, wts] = subdivision_rule(simplices);
+  const Eigen::MatrixXd P = polyset::tabulate(_cell_type, _degree, 0, pts)[0];
+  return fit(P.transpose() * wts.matrix(), pts);
+}
+//-----------------------------------------------------------------------------
+Eigen::VectorXd MomentFitting::refit(const Eigen::VectorXd& moments,
+                                     const Eigen::ArrayXXd& candidates) const
+{
+  if (_support.empty() or candidates.rows() != _num_candidates)
+    return Eigen::VectorXd();
+
+  Eigen::ArrayXXd pts(_support.size(), candidates.cols());
+  for (std::size_t k = 0; k < _support.size(); ++k)
+    pts.row(k) = candidates.row(_support[k]);
+  const Eigen::MatrixXd basis
+      = polyset::tabulate(_cell_type, _degree, 0, pts)[0].transpose();
+
+  std::vector<int> cols(_support.size());
+  std::iota(cols.begin(), cols.end(), 0);
+  const Eigen::VectorXd w = lstsq(basis, cols, moments);
+  if (w.minCoeff() > 0.0 and reproduces(basis, cols, w, moments))
+    return w;
+  else
+    return Eigen::VectorXd();
+}
+//-----------------------------------------------------------------------------
+int MomentFitting::num_moments() const { return _num_moments; }
+//-----------------------------------------------------------------------------
+const std::vector<int>& MomentFitting::support() const { return _support; }
+//-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+libtab::make_moment_fitted_quadrature(
+    cell::type celltype, int degree,
+    const std::vector<Eigen::ArrayXXd>& simplices)
+{
+  return MomentFitting(celltype, degree).fit(simplices);
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "cell.h"
+#include <Eigen/Dense>
+#include <utility>
+#include <vector>
+
+namespace libtab
+{
+
+/// ## Moment-fitting quadrature
+/// Quadrature rules for a region, such as a cell cut by a level set, found
+/// by choosing nonnegative weights for a set of candidate points so that
+/// the rule reproduces the integrals (moments) of a polynomial set over the
+/// region. The weights are found with the Lawson-Hanson nonnegative least
+/// squares algorithm, which gives a rule with at most as many points as
+/// there are moments.
+///
+/// The polynomials integrated exactly are the polynomial set of a cell
+/// type (see polyset::tabulate). This need not be the cell containing the
+/// region: the polynomial set of a triangle gives the complete polynomials
+/// of the degree, which needs fewer moments (and so fewer points) than the
+/// tensor-product set of a quadrilateral.
+///
+/// A MomentFitting can be reused for all cells with the same cut topology.
+/// Subdivisions with the same number of simplices give the same number of
+/// candidate points, in corresponding positions, so the candidates used by
+/// the previous fit are tried first. The full algorithm only runs if they
+/// do not give nonnegative weights.
+class MomentFitting
+{
+public:
+  /// Prepare to fit rules for a polynomial set
+  /// @param[in] celltype The cell type whose polynomial set is integrated
+  /// exactly
+  /// @param[in] degree The degree of the polynomial set
+  MomentFitting(cell::type celltype, int degree);
+
+  /// Compute the moments of the polynomial set over a region given by a
+  /// subdivision into simplices
+  /// @param[in] simplices The vertices of each simplex (one per row)
+  /// @return The moments
+  Eigen::VectorXd moments(const std::vector<Eigen::ArrayXXd>& simplices) const;
+
+  /// Fit a rule to given moments
+  /// @param[in] moments The integral of each member of the polynomial set
+  /// over the region
+  /// @param[in] candidates The points from which the points of the rule
+  /// are chosen
+  /// @return Points and (positive) weights
+  std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+  fit(const Eigen::VectorXd& moments, const Eigen::ArrayXXd& candidates);
+
+  /// Fit a rule to a region given by a subdivision into simplices. The
+  /// candidates are the points of the Gauss-Jacobi rules on the simplices
+  /// which integrate the polynomial set exactly, so they lie in the region.
+  /// @param[in] simplices The vertices of each simplex (one per row)
+  /// @return Points and (positive) weights
+  std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+  fit(const std::vector<Eigen::ArrayXXd>& simplices);
+
+  /// The number of moments, i.e. the size of the polynomial set
+  int num_moments() const;
+
+  /// The indices of the candidate points used by the last fit
+  const std::vector<int>& support() const;
+
+private:
+  // Nonnegative weights for the candidates in the previous support, or an
+  // empty vector if they do not reproduce the moments
+  Eigen::VectorXd refit(const Eigen::VectorXd& moments,
+                        const Eigen::ArrayXXd& candidates) const;
+
+  // Candidate points and the moment quadrature for a subdivision
+  std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+  subdivision_rule(const std::vector<Eigen::ArrayXXd>& simplices) const;
+
+  cell::type _cell_type;
+  int _degree;
+  int _num_moments;
+
+  // The support of the last fit, and its number of candidates
+  std::vector<int> _support;
+  int _num_candidates = 0;
+};
+
+/// Compute a compact quadrature rule for a region given by a subdivision
+/// into simplices (see MomentFitting::fit)
+/// @param[in] celltype The cell type whose polynomial set is integrated
+/// exactly
+/// @param[in] degree The degree of the polynomial set
+/// @param[in] simplices The vertices of each simplex (one per row)
+/// @return Points and weights
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+make_moment_fitted_quadrature(cell::type celltype, int degree,
+                              const std::vector<Eigen::ArrayXXd>& simplices);
+
+} // namespace libtab
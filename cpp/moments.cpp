@@ -4,27 +4,110 @@
 
 #include "moments.h"
 #include "cell.h"
+#include "double-double.h"
 #include "libtab.h"
+#include "linalg.h"
+#include "polyset-scalar.h"
 #include "polyset.h"
 #include "quadrature.h"
+#include <cmath>
 
 using namespace libtab;
 
 namespace
 {
+template <typename T>
+using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
 //----------------------------------------------------------------------------
-double integral_jacobian(const Eigen::MatrixXd& axes)
+// The integral Jacobian in the arithmetic of T. The vertices of the
+// reference cells have integer coordinates, so the squared lengths and
+// areas are exact in double precision, and only the square root is taken
+// in T.
+template <typename T>
+T integral_jacobian(const Eigen::MatrixXd& axes)
 {
+  using std::sqrt;
   if (axes.rows() == 1)
-    return axes.row(0).norm();
+    return sqrt(T(axes.row(0).squaredNorm()));
   else if (axes.rows() == 2 and axes.cols() == 3)
   {
     Eigen::Vector3d a0 = axes.row(0);
     Eigen::Vector3d a1 = axes.row(1);
-    return a0.cross(a1).norm();
+    return sqrt(T(a0.cross(a1).squaredNorm()));
   }
   else
-    return axes.determinant();
+    return T(axes.determinant());
+}
+//----------------------------------------------------------------------------
+// The scalar moment space of an element
+moments::MomentSpace<double> scalar_space(const FiniteElement& moment_space)
+{
+  if (moment_space.value_size() != 1)
+    throw std::runtime_error("Moment space must be scalar");
+  return {moment_space.cell_type(), moment_space.degree(),
+          moment_space.coefficients()};
+}
+//----------------------------------------------------------------------------
+// Values of a moment space at points, of shape (npoints, dim)
+template <typename T>
+polyset::Table<T> tabulate(const moments::MomentSpace<T>& moment_space,
+                           const polyset::Table<T>& x)
+{
+  const Matrix<T> P = polyset::tabulate_values(moment_space.celltype,
+                                               moment_space.degree, x)
+                          .matrix();
+  return (P * moment_space.coeffs.transpose()).array();
+}
+//----------------------------------------------------------------------------
+// Map points on the reference sub-entity to the entity of a cell with the
+// given vertices
+template <typename T>
+polyset::Table<T> map_points(const Eigen::ArrayXXd& entity,
+                             const polyset::Table<T>& Qpts)
+{
+  polyset::Table<T> x(Qpts.rows(), entity.cols());
+  for (int q = 0; q < Qpts.rows(); ++q)
+  {
+    for (int k = 0; k < entity.cols(); ++k)
+    {
+      x(q, k) = T(entity(0, k));
+      for (int d = 0; d < Qpts.cols(); ++d)
+        x(q, k) += Qpts(q, d) * T(entity(d + 1, k) - entity(0, k));
+    }
+  }
+  return x;
+}
+//----------------------------------------------------------------------------
+// Matrix product, with linalg::matmul in double precision
+template <typename T>
+Matrix<T> product(const Matrix<T>& A, const Matrix<T>& B)
+{
+  return A * B;
+}
+Eigen::MatrixXd product(const Eigen::MatrixXd& A, const Eigen::MatrixXd& B)
+{
+  Eigen::MatrixXd C(A.rows(), B.cols());
+  linalg::matmul(A, B, C);
+  return C;
+}
+//----------------------------------------------------------------------------
+// Integrals of each function of the polynomial set against each function of
+// the moment space, given the moment space tabulated at the quadrature
+// points. Returns a (psize x number of moment space functions) matrix.
+template <typename T>
+Matrix<T> integrate_polyset(cell::type celltype, int poly_deg,
+                            const polyset::Table<T>& Qpts,
+                            const quadrature::Weights<T>& Qwts,
+                            const polyset::Table<T>& moment_space_at_Qpts)
+{
+  // Tabulate polynomial set at quadrature points
+  const Matrix<T> poly_set_at_Qpts
+      = polyset::tabulate_values(celltype, poly_deg, Qpts)
+            .matrix()
+            .transpose();
+
+  const Matrix<T> weighted = (moment_space_at_Qpts.colwise() * Qwts).matrix();
+  return product(poly_set_at_Qpts, weighted);
 }
 //----------------------------------------------------------------------------
 } // namespace
@@ -35,27 +118,38 @@ moments::make_integral_moments(const FiniteElement& moment_space,
                                const cell::type celltype, const int value_size,
                                const int poly_deg, const int q_deg)
 {
+  return make_integral_moments(scalar_space(moment_space), celltype,
+                               value_size, poly_deg, q_deg);
+}
+//----------------------------------------------------------------------------
+template <typename T>
+Matrix<T> moments::make_integral_moments(const MomentSpace<T>& moment_space,
+                                         const cell::type celltype,
+                                         const int value_size,
+                                         const int poly_deg, const int q_deg)
+{
+  using std::sqrt;
   const int psize = polyset::dim(celltype, poly_deg);
 
-  const cell::type sub_celltype = moment_space.cell_type();
+  const cell::type sub_celltype = moment_space.celltype;
   const int sub_entity_dim = cell::topological_dimension(sub_celltype);
   if (sub_entity_dim == 0)
     throw std::runtime_error("Cannot integrate over a dimension 0 entity.");
 
   const int sub_entity_count = cell::sub_entity_count(celltype, sub_entity_dim);
 
-  auto [Qpts, Qwts] = quadrature::make_quadrature(sub_celltype, q_deg);
+  auto [Qpts, Qwts] = quadrature::make_quadrature<T>(sub_celltype, q_deg);
   const int tdim = cell::topological_dimension(celltype);
 
   // If this is always true, value_size input can be removed
   assert(tdim == value_size);
 
   // Evaluate moment space at quadrature points
-  Eigen::ArrayXXd moment_space_at_Qpts = moment_space.tabulate(0, Qpts)[0];
+  const polyset::Table<T> moment_space_at_Qpts = tabulate(moment_space, Qpts);
 
-  Eigen::MatrixXd dual(moment_space_at_Qpts.cols() * sub_entity_dim
-                           * sub_entity_count,
-                       psize * value_size);
+  Matrix<T> dual(moment_space_at_Qpts.cols() * sub_entity_dim
+                     * sub_entity_count,
+                 psize * value_size);
 
   int c = 0;
   // Iterate over sub entities
@@ -65,34 +159,31 @@ moments::make_integral_moments(const FiniteElement& moment_space,
         = cell::sub_entity_geometry(celltype, sub_entity_dim, i);
 
     // Parametrise entity coordinates
-    Eigen::ArrayXXd axes(sub_entity_dim, tdim);
+    Eigen::MatrixXd axes(sub_entity_dim, tdim);
     for (int j = 0; j < sub_entity_dim; ++j)
-      axes.row(j) = entity.row(j + 1) - entity.row(0);
+      axes.row(j) = (entity.row(j + 1) - entity.row(0)).matrix();
 
     // Map quadrature points onto entity
-    Eigen::ArrayXXd Qpts_scaled = entity.row(0).replicate(Qpts.rows(), 1)
-                                  + (Qpts.matrix() * axes.matrix()).array();
+    const polyset::Table<T> Qpts_scaled = map_points(entity, Qpts);
 
-    const double integral_jac = integral_jacobian(axes);
+    const T integral_jac = integral_jacobian<T>(axes);
 
-    // Tabulate polynomial set at entity quadrature points
-    Eigen::MatrixXd poly_set_at_Qpts
-        = polyset::tabulate(celltype, poly_deg, 0, Qpts_scaled)[0].transpose();
+    // Integrals of the polynomial set against each moment space function
+    const Matrix<T> integrals = integrate_polyset(
+        celltype, poly_deg, Qpts_scaled, Qwts, moment_space_at_Qpts);
 
     // Compute entity integral moments
     for (int j = 0; j < moment_space_at_Qpts.cols(); ++j)
     {
-      Eigen::ArrayXd phi = moment_space_at_Qpts.col(j);
       for (int d = 0; d < sub_entity_dim; ++d)
       {
         Eigen::VectorXd axis = axes.row(d);
+        const T norm = sqrt(T(axis.squaredNorm()));
         for (int k = 0; k < value_size; ++k)
         {
-          Eigen::VectorXd q
-              = phi * Qwts * (integral_jac * axis(k) / axis.norm());
-          Eigen::RowVectorXd qcoeffs = poly_set_at_Qpts * q;
-          assert(qcoeffs.size() == psize);
-          dual.block(c, psize * k, 1, psize) = qcoeffs;
+          dual.block(c, psize * k, 1, psize)
+              = integrals.col(j).transpose()
+                * (integral_jac * T(axis(k)) / norm);
         }
         ++c;
       }
@@ -144,29 +235,24 @@ Eigen::MatrixXd moments::make_dot_integral_moments(
     Eigen::ArrayXXd Qpts_scaled = entity.row(0).replicate(Qpts.rows(), 1)
                                   + (Qpts.matrix() * axes.matrix()).array();
 
-    const double integral_jac = integral_jacobian(axes);
+    const double integral_jac = integral_jacobian<double>(axes);
 
-    // Tabulate polynomial set at entity quadrature points
-    Eigen::MatrixXd poly_set_at_Qpts
-        = polyset::tabulate(celltype, poly_deg, 0, Qpts_scaled)[0].transpose();
+    // Integrals of the polynomial set against each moment space function
+    const Eigen::MatrixXd integrals = integrate_polyset(
+        celltype, poly_deg, Qpts_scaled, Qwts, moment_space_at_Qpts);
 
     // Compute entity integral moments
     for (int j = 0; j < moment_space_size; ++j)
     {
       for (int k = 0; k < value_size; ++k)
       {
-        Eigen::VectorXd q = Eigen::VectorXd::Zero(Qwts.rows());
+        Eigen::RowVectorXd qcoeffs = Eigen::RowVectorXd::Zero(psize);
         for (int d = 0; d < sub_entity_dim; ++d)
         {
-          Eigen::ArrayXd phi
-              = moment_space_at_Qpts.col(d * moment_space_size + j);
           Eigen::VectorXd axis = axes.row(d);
-          Eigen::VectorXd qpart
-              = phi * Qwts * (integral_jac * axis(k) / axis.norm());
-          q += qpart;
+          qcoeffs += integrals.col(d * moment_space_size + j).transpose()
+                     * (integral_jac * axis(k) / axis.norm());
         }
-        Eigen::RowVectorXd qcoeffs = poly_set_at_Qpts * q;
-        assert(qcoeffs.size() == psize);
         dual.block(c, psize * k, 1, psize) = qcoeffs;
       }
       ++c;
@@ -179,26 +265,35 @@ Eigen::MatrixXd moments::make_dot_integral_moments(
 Eigen::MatrixXd moments::make_tangent_integral_moments(
     const FiniteElement& moment_space, const cell::type celltype,
     const int value_size, const int poly_deg, const int q_deg)
+{
+  return make_tangent_integral_moments(scalar_space(moment_space), celltype,
+                                       value_size, poly_deg, q_deg);
+}
+//----------------------------------------------------------------------------
+template <typename T>
+Matrix<T> moments::make_tangent_integral_moments(
+    const MomentSpace<T>& moment_space, const cell::type celltype,
+    const int value_size, const int poly_deg, const int q_deg)
 {
   const int psize = polyset::dim(celltype, poly_deg);
-  const cell::type sub_celltype = moment_space.cell_type();
+  const cell::type sub_celltype = moment_space.celltype;
   const int sub_entity_dim = cell::topological_dimension(sub_celltype);
   const int sub_entity_count = cell::sub_entity_count(celltype, sub_entity_dim);
-  const int tdim = cell::topological_dimension(celltype);
 
   if (sub_entity_dim != 1)
     throw std::runtime_error("Tangent is only well-defined on an edge.");
 
-  auto [Qpts, Qwts] = quadrature::make_quadrature(cell::type::interval, q_deg);
+  auto [Qpts, Qwts]
+      = quadrature::make_quadrature<T>(cell::type::interval, q_deg);
 
   // If this is always true, value_size input can be removed
-  assert(tdim == value_size);
+  assert(cell::topological_dimension(celltype) == value_size);
 
   // Evaluate moment space at quadrature points
-  Eigen::ArrayXXd moment_space_at_Qpts = moment_space.tabulate(0, Qpts)[0];
+  const polyset::Table<T> moment_space_at_Qpts = tabulate(moment_space, Qpts);
 
-  Eigen::MatrixXd dual(moment_space_at_Qpts.cols() * sub_entity_count,
-                       psize * value_size);
+  Matrix<T> dual(moment_space_at_Qpts.cols() * sub_entity_count,
+                 psize * value_size);
 
   int c = 0;
 
@@ -211,27 +306,18 @@ Eigen::MatrixXd moments::make_tangent_integral_moments(
     // integral jacobian
 
     // Map quadrature points onto triangle edge
-    Eigen::ArrayXXd Qpts_scaled(Qpts.rows(), tdim);
-    for (int j = 0; j < Qpts.rows(); ++j)
-    {
-      Qpts_scaled.row(j)
-          = edge.row(0) + Qpts(j, 0) * (edge.row(1) - edge.row(0));
-    }
+    const polyset::Table<T> Qpts_scaled = map_points(edge, Qpts);
 
-    // Tabulate polynomial set at edge quadrature points
-    Eigen::MatrixXd poly_set_at_Qpts
-        = polyset::tabulate(celltype, poly_deg, 0, Qpts_scaled)[0].transpose();
+    // Integrals of the polynomial set against each moment space function
+    const Matrix<T> integrals = integrate_polyset(
+        celltype, poly_deg, Qpts_scaled, Qwts, moment_space_at_Qpts);
 
     // Compute edge tangent integral moments
     for (int j = 0; j < moment_space_at_Qpts.cols(); ++j)
     {
-      Eigen::ArrayXd phi = moment_space_at_Qpts.col(j);
       for (int k = 0; k < value_size; ++k)
-      {
-        Eigen::VectorXd q = phi * Qwts * tangent[k];
-        Eigen::RowVectorXd qcoeffs = poly_set_at_Qpts * q;
-        dual.block(c, psize * k, 1, psize) = qcoeffs;
-      }
+        dual.block(c, psize * k, 1, psize)
+            = integrals.col(j).transpose() * T(tangent[k]);
       ++c;
     }
   }
@@ -242,9 +328,18 @@ Eigen::MatrixXd moments::make_tangent_integral_moments(
 Eigen::MatrixXd moments::make_normal_integral_moments(
     const FiniteElement& moment_space, const cell::type celltype,
     const int value_size, const int poly_deg, const int q_deg)
+{
+  return make_normal_integral_moments(scalar_space(moment_space), celltype,
+                                      value_size, poly_deg, q_deg);
+}
+//----------------------------------------------------------------------------
+template <typename T>
+Matrix<T> moments::make_normal_integral_moments(
+    const MomentSpace<T>& moment_space, const cell::type celltype,
+    const int value_size, const int poly_deg, const int q_deg)
 {
   const int psize = polyset::dim(celltype, poly_deg);
-  const cell::type sub_celltype = moment_space.cell_type();
+  const cell::type sub_celltype = moment_space.celltype;
   const int sub_entity_dim = cell::topological_dimension(sub_celltype);
   const int sub_entity_count = cell::sub_entity_count(celltype, sub_entity_dim);
   const int tdim = cell::topological_dimension(celltype);
@@ -252,22 +347,21 @@ Eigen::MatrixXd moments::make_normal_integral_moments(
   if (sub_entity_dim != tdim - 1)
     throw std::runtime_error("Normal is only well-defined on a facet.");
 
-  auto [Qpts, Qwts] = quadrature::make_quadrature(sub_celltype, q_deg);
+  auto [Qpts, Qwts] = quadrature::make_quadrature<T>(sub_celltype, q_deg);
 
   // If this is always true, value_size input can be removed
   assert(tdim == value_size);
 
   // Evaluate moment space at quadrature points
-  Eigen::ArrayXXd moment_space_at_Qpts = moment_space.tabulate(0, Qpts)[0];
+  const polyset::Table<T> moment_space_at_Qpts = tabulate(moment_space, Qpts);
 
-  Eigen::MatrixXd dual(moment_space_at_Qpts.cols() * sub_entity_count,
-                       psize * value_size);
+  Matrix<T> dual(moment_space_at_Qpts.cols() * sub_entity_count,
+                 psize * value_size);
 
   int c = 0;
 
   // Iterate over sub entities
   Eigen::VectorXd normal(tdim);
-  Eigen::ArrayXXd Qpts_scaled(Qpts.rows(), tdim);
   for (int i = 0; i < sub_entity_count; ++i)
   {
     Eigen::ArrayXXd facet = cell::sub_entity_geometry(celltype, tdim - 1, i);
@@ -275,50 +369,31 @@ Eigen::MatrixXd moments::make_normal_integral_moments(
     {
       Eigen::Vector2d tangent = facet.row(1) - facet.row(0);
       normal << -tangent(1), tangent(0);
-      // No need to normalise the normal, as the size of this is equal to the
-      // integral jacobian
-
-      // Map quadrature points onto facet
-      for (int j = 0; j < Qpts.rows(); ++j)
-      {
-        Qpts_scaled.row(j)
-            = facet.row(0) + Qpts(j, 0) * (facet.row(1) - facet.row(0));
-      }
     }
     else if (tdim == 3)
     {
       Eigen::Vector3d t0 = facet.row(1) - facet.row(0);
       Eigen::Vector3d t1 = facet.row(2) - facet.row(0);
       normal = t0.cross(t1);
-
-      // No need to normalise the normal, as the size of this is equal to the
-      // integral jacobian
-
-      // Map quadrature points onto facet
-      for (int j = 0; j < Qpts.rows(); ++j)
-      {
-        Qpts_scaled.row(j) = facet.row(0)
-                             + Qpts(j, 0) * (facet.row(1) - facet.row(0))
-                             + Qpts(j, 1) * (facet.row(2) - facet.row(0));
-      }
     }
     else
       throw std::runtime_error("Normal on this cell cannot be computed.");
+    // No need to normalise the normal, as the size of this is equal to the
+    // integral jacobian
+
+    // Map quadrature points onto facet
+    const polyset::Table<T> Qpts_scaled = map_points(facet, Qpts);
 
-    // Tabulate polynomial set at facet quadrature points
-    Eigen::MatrixXd poly_set_at_Qpts
-        = polyset::tabulate(celltype, poly_deg, 0, Qpts_scaled)[0].transpose();
+    // Integrals of the polynomial set against each moment space function
+    const Matrix<T> integrals = integrate_polyset(
+        celltype, poly_deg, Qpts_scaled, Qwts, moment_space_at_Qpts);
 
     // Compute facet normal integral moments
     for (int j = 0; j < moment_space_at_Qpts.cols(); ++j)
     {
-      Eigen::ArrayXd phi = moment_space_at_Qpts.col(j);
       for (int k = 0; k < value_size; ++k)
-      {
-        Eigen::VectorXd q = phi * Qwts * normal[k];
-        Eigen::RowVectorXd qcoeffs = poly_set_at_Qpts * q;
-        dual.block(c, psize * k, 1, psize) = qcoeffs;
-      }
+        dual.block(c, psize * k, 1, psize)
+            = integrals.col(j).transpose() * T(normal[k]);
       ++c;
     }
   }
@@ -326,3 +401,27 @@ Eigen::MatrixXd moments::make_normal_integral_moments(
   return dual;
 }
 //----------------------------------------------------------------------------
+template Matrix<double>
+moments::make_integral_moments(const MomentSpace<double>&, const cell::type,
+                               const int, const int, const int);
+template Matrix<DoubleDouble>
+moments::make_integral_moments(const MomentSpace<DoubleDouble>&,
+                               const cell::type, const int, const int,
+                               const int);
+template Matrix<double>
+moments::make_tangent_integral_moments(const MomentSpace<double>&,
+                                       const cell::type, const int, const int,
+                                       const int);
+template Matrix<DoubleDouble>
+moments::make_tangent_integral_moments(const MomentSpace<DoubleDouble>&,
+                                       const cell::type, const int, const int,
+                                       const int);
+template Matrix<double>
+moments::make_normal_integral_moments(const MomentSpace<double>&,
+                                      const cell::type, const int, const int,
+                                      const int);
+template Matrix<DoubleDouble>
+moments::make_normal_integral_moments(const MomentSpace<DoubleDouble>&,
+                                      const cell::type, const int, const int,
+                                      const int);
+//----------------------------------------------------------------------------
@@ -17,6 +17,23 @@ class FiniteElement;
 /// against spaces on a subentity of the cell
 namespace moments
 {
+/// A scalar moment space in the arithmetic of T, given by its expansion
+/// coefficients in the orthonormal polynomial set of its cell (see
+/// FiniteElement::coefficients)
+template <typename T>
+struct MomentSpace
+{
+  /// Cell type of the space
+  cell::type celltype;
+
+  /// Degree of the polynomial set of the space
+  int degree;
+
+  /// Expansion coefficients, of shape (dim, polyset::dim(celltype,
+  /// degree))
+  Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> coeffs;
+};
+
 /// Make simple integral moments
 ///
 /// This will compute the integral of each function in the moment space
@@ -36,6 +53,14 @@ Eigen::MatrixXd make_integral_moments(const FiniteElement& moment_space,
                                       const int value_size, const int poly_deg,
                                       const int q_deg);
 
+/// Make simple integral moments, as above, in the arithmetic of T (double
+/// or DoubleDouble)
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+make_integral_moments(const MomentSpace<T>& moment_space,
+                      const cell::type celltype, const int value_size,
+                      const int poly_deg, const int q_deg);
+
 /// Make dot product integral moments
 ///
 /// This will compute the integral of each function in the moment space over
@@ -73,6 +98,14 @@ Eigen::MatrixXd make_tangent_integral_moments(const FiniteElement& moment_space,
                                               const int poly_deg,
                                               const int q_deg);
 
+/// Make tangential integral moments, as above, in the arithmetic of T
+/// (double or DoubleDouble)
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+make_tangent_integral_moments(const MomentSpace<T>& moment_space,
+                              const cell::type celltype, const int value_size,
+                              const int poly_deg, const int q_deg);
+
 /// Make normal integral moments
 ///
 /// These can only be used when the moment space is defined on facets of
@@ -92,5 +125,13 @@ Eigen::MatrixXd make_normal_integral_moments(const FiniteElement& moment_space,
                                              const int poly_deg,
                                              const int q_deg);
 
+/// Make normal integral moments, as above, in the arithmetic of T (double
+/// or DoubleDouble)
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+make_normal_integral_moments(const MomentSpace<T>& moment_space,
+                             const cell::type celltype, const int value_size,
+                             const int poly_deg, const int q_deg);
+
 }; // namespace moments
 } // namespace libtab
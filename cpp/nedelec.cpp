@@ -4,8 +4,10 @@
 
 #include "nedelec.h"
 #include "dof-permutations.h"
+#include "double-double.h"
 #include "lagrange.h"
 #include "moments.h"
+#include "polyset-scalar.h"
 #include "polyset.h"
 #include "quadrature.h"
 #include "raviart-thomas.h"
@@ -17,8 +19,11 @@ using namespace libtab;
 
 namespace
 {
+template <typename T>
+using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
 //-----------------------------------------------------------------------------
-Eigen::MatrixXd create_nedelec_2d_space(int degree)
+template <typename T>
+Matrix<T> create_nedelec_2d_space(int degree)
 {
   // Number of order (degree) vector polynomials
   const int nv = degree * (degree + 1) / 2;
@@ -29,18 +34,19 @@ Eigen::MatrixXd create_nedelec_2d_space(int degree)
   // Number of additional polynomials in Nedelec set
   const int ns = degree;
 
-  // Tabulate polynomial set at quadrature points
+  // Tabulate polynomial set at quadrature points, exact for the integrands
+  // of degree 2 * degree + 1
   auto [Qpts, Qwts]
-      = quadrature::make_quadrature(cell::type::triangle, 2 * degree);
-  Eigen::ArrayXXd Pkp1_at_Qpts
-      = polyset::tabulate(cell::type::triangle, degree, 0, Qpts)[0];
+      = quadrature::make_quadrature<T>(cell::type::triangle, degree + 1);
+  const polyset::Table<T> Pkp1_at_Qpts
+      = polyset::tabulate_values(cell::type::triangle, degree, Qpts);
 
   const int psize = Pkp1_at_Qpts.cols();
 
   // Create coefficients for order (degree-1) vector polynomials
-  Eigen::MatrixXd wcoeffs = Eigen::MatrixXd::Zero(nv * 2 + ns, psize * 2);
-  wcoeffs.block(0, 0, nv, nv) = Eigen::MatrixXd::Identity(nv, nv);
-  wcoeffs.block(nv, psize, nv, nv) = Eigen::MatrixXd::Identity(nv, nv);
+  Matrix<T> wcoeffs = Matrix<T>::Zero(nv * 2 + ns, psize * 2);
+  wcoeffs.block(0, 0, nv, nv) = Matrix<T>::Identity(nv, nv);
+  wcoeffs.block(nv, psize, nv, nv) = Matrix<T>::Identity(nv, nv);
 
   // Create coefficients for the additional Nedelec polynomials
   for (int i = 0; i < ns; ++i)
@@ -59,22 +65,24 @@ Eigen::MatrixXd create_nedelec_2d_space(int degree)
   return wcoeffs;
 }
 //-----------------------------------------------------------------------------
-Eigen::MatrixXd create_nedelec_2d_dual(int degree)
+template <typename T>
+Matrix<T> create_nedelec_2d_dual(int degree)
 {
   // Number of dofs and size of polynomial set P(k+1)
   const int ndofs = 3 * degree + degree * (degree - 1);
   const int psize = (degree + 1) * (degree + 2) / 2;
 
   // Dual space
-  Eigen::MatrixXd dual = Eigen::MatrixXd::Zero(ndofs, psize * 2);
+  Matrix<T> dual = Matrix<T>::Zero(ndofs, psize * 2);
 
-  // dof counter
-  const int quad_deg = 5 * degree;
+  // Quadrature degree, exact for the integrands of degree at most
+  // 2 * degree - 1
+  const int quad_deg = degree + 1;
 
   // Integral representation for the boundary (edge) dofs
   dual.block(0, 0, 3 * degree, psize * 2)
       = moments::make_tangent_integral_moments(
-          create_dlagrange(cell::type::interval, degree - 1),
+          dlagrange_space<T>(cell::type::interval, degree - 1),
           cell::type::triangle, 2, degree, quad_deg);
 
   if (degree > 1)
@@ -82,7 +90,7 @@ Eigen::MatrixXd create_nedelec_2d_dual(int degree)
     // Interior integral moment
     dual.block(3 * degree, 0, degree * (degree - 1), psize * 2)
         = moments::make_integral_moments(
-            create_dlagrange(cell::type::triangle, degree - 2),
+            dlagrange_space<T>(cell::type::triangle, degree - 2),
             cell::type::triangle, 2, degree, quad_deg);
   }
 
@@ -120,7 +128,8 @@ std::vector<Eigen::MatrixXd> create_nedelec_2d_base_perms(int degree)
   return base_permutations;
 }
 //-----------------------------------------------------------------------------
-Eigen::MatrixXd create_nedelec_3d_space(int degree)
+template <typename T>
+Matrix<T> create_nedelec_3d_space(int degree)
 {
   // Reference tetrahedron
   const int tdim = 3;
@@ -140,29 +149,27 @@ Eigen::MatrixXd create_nedelec_3d_space(int degree)
   const int ndofs = 6 * degree + 4 * degree * (degree - 1)
                     + (degree - 2) * (degree - 1) * degree / 2;
 
-  // Tabulate polynomial basis at quadrature points
+  // Tabulate polynomial basis at quadrature points, exact for the
+  // integrands of degree 2 * degree + 1
   auto [Qpts, Qwts]
-      = quadrature::make_quadrature(cell::type::tetrahedron, 2 * degree);
-  Eigen::ArrayXXd Pkp1_at_Qpts
-      = polyset::tabulate(cell::type::tetrahedron, degree, 0, Qpts)[0];
+      = quadrature::make_quadrature<T>(cell::type::tetrahedron, degree + 1);
+  const polyset::Table<T> Pkp1_at_Qpts
+      = polyset::tabulate_values(cell::type::tetrahedron, degree, Qpts);
   const int psize = Pkp1_at_Qpts.cols();
 
   // Create coefficients for order (degree-1) polynomials
-  Eigen::MatrixXd wcoeffs = Eigen::MatrixXd::Zero(ndofs, psize * tdim);
+  Matrix<T> wcoeffs = Matrix<T>::Zero(ndofs, psize * tdim);
   for (int i = 0; i < tdim; ++i)
-  {
-    wcoeffs.block(nv * i, psize * i, nv, nv)
-        = Eigen::MatrixXd::Identity(nv, nv);
-  }
+    wcoeffs.block(nv * i, psize * i, nv, nv) = Matrix<T>::Identity(nv, nv);
 
   // Create coefficients for additional Nedelec polynomials
   for (int i = 0; i < ns; ++i)
   {
     for (int k = 0; k < psize; ++k)
     {
-      const double w = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(2)
-                        * Pkp1_at_Qpts.col(k))
-                           .sum();
+      const T w = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(2)
+                   * Pkp1_at_Qpts.col(k))
+                      .sum();
       // Don't include polynomials (*, *, 0) that are dependant
       if (i >= ns_remove)
         wcoeffs(tdim * nv + i - ns_remove, psize + k) = -w;
@@ -174,9 +181,9 @@ Eigen::MatrixXd create_nedelec_3d_space(int degree)
   {
     for (int k = 0; k < psize; ++k)
     {
-      const double w = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(1)
-                        * Pkp1_at_Qpts.col(k))
-                           .sum();
+      const T w = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(1)
+                   * Pkp1_at_Qpts.col(k))
+                      .sum();
       wcoeffs(tdim * nv + i + ns * 2 - ns_remove, k) = -w;
       // Don't include polynomials (*, *, 0) that are dependant
       if (i >= ns_remove)
@@ -188,9 +195,9 @@ Eigen::MatrixXd create_nedelec_3d_space(int degree)
   {
     for (int k = 0; k < psize; ++k)
     {
-      const double w = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(0)
-                        * Pkp1_at_Qpts.col(k))
-                           .sum();
+      const T w = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(0)
+                   * Pkp1_at_Qpts.col(k))
+                      .sum();
       wcoeffs(tdim * nv + i + ns - ns_remove, psize * 2 + k) = -w;
       wcoeffs(tdim * nv + i + ns * 2 - ns_remove, psize + k) = w;
     }
@@ -199,7 +206,8 @@ Eigen::MatrixXd create_nedelec_3d_space(int degree)
   return wcoeffs;
 }
 //-----------------------------------------------------------------------------
-Eigen::MatrixXd create_nedelec_3d_dual(int degree)
+template <typename T>
+Matrix<T> create_nedelec_3d_dual(int degree)
 {
   const int tdim = 3;
 
@@ -209,15 +217,16 @@ Eigen::MatrixXd create_nedelec_3d_dual(int degree)
   // Work out number of dofs
   const int ndofs = 6 * degree + 4 * degree * (degree - 1)
                     + (degree - 2) * (degree - 1) * degree / 2;
-  Eigen::MatrixXd dual = Eigen::MatrixXd::Zero(ndofs, psize * tdim);
+  Matrix<T> dual = Matrix<T>::Zero(ndofs, psize * tdim);
 
-  // Create quadrature scheme on the edge
-  const int quad_deg = 5 * degree;
+  // Quadrature degree, exact for the integrands of degree at most
+  // 2 * degree - 1
+  const int quad_deg = degree + 1;
 
   // Integral representation for the boundary (edge) dofs
   dual.block(0, 0, 6 * degree, psize * 3)
       = moments::make_tangent_integral_moments(
-          create_dlagrange(cell::type::interval, degree - 1),
+          dlagrange_space<T>(cell::type::interval, degree - 1),
           cell::type::tetrahedron, 3, degree, quad_deg);
 
   if (degree > 1)
@@ -225,7 +234,7 @@ Eigen::MatrixXd create_nedelec_3d_dual(int degree)
     // Integral moments on faces
     dual.block(6 * degree, 0, 4 * (degree - 1) * degree, psize * 3)
         = moments::make_integral_moments(
-            create_dlagrange(cell::type::triangle, degree - 2),
+            dlagrange_space<T>(cell::type::triangle, degree - 2),
             cell::type::tetrahedron, 3, degree, quad_deg);
   }
 
@@ -235,7 +244,7 @@ Eigen::MatrixXd create_nedelec_3d_dual(int degree)
     dual.block(6 * degree + 4 * degree * (degree - 1), 0,
                (degree - 2) * (degree - 1) * degree / 2, psize * 3)
         = moments::make_integral_moments(
-            create_dlagrange(cell::type::tetrahedron, degree - 3),
+            dlagrange_space<T>(cell::type::tetrahedron, degree - 3),
             cell::type::tetrahedron, 3, degree, quad_deg);
   }
 
@@ -393,25 +402,13 @@ Eigen::MatrixXd create_nedelec2_3d_dual(int degree)
 } // namespace
 
 //-----------------------------------------------------------------------------
-FiniteElement libtab::create_nedelec(cell::type celltype, int degree,
-                                     const std::string& name)
+DofLayout libtab::nedelec_layout(cell::type celltype, int degree)
 {
-  Eigen::MatrixXd wcoeffs;
-  Eigen::MatrixXd dual;
   std::vector<Eigen::MatrixXd> perms;
-  std::vector<Eigen::MatrixXd> directions;
   if (celltype == cell::type::triangle)
-  {
-    wcoeffs = create_nedelec_2d_space(degree);
-    dual = create_nedelec_2d_dual(degree);
     perms = create_nedelec_2d_base_perms(degree);
-  }
   else if (celltype == cell::type::tetrahedron)
-  {
-    wcoeffs = create_nedelec_3d_space(degree);
-    dual = create_nedelec_3d_dual(degree);
     perms = create_nedelec_3d_base_perms(degree);
-  }
   else
     throw std::runtime_error("Invalid celltype in Nedelec");
 
@@ -427,9 +424,44 @@ FiniteElement libtab::create_nedelec(cell::type celltype, int degree,
   if (tdim > 2)
     entity_dofs[3] = {degree * (degree - 1) * (degree - 2) / 2};
 
+  return {{tdim}, entity_dofs, perms, Eigen::ArrayXXd()};
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+libtab::nedelec_space(cell::type celltype, int degree)
+{
+  if (celltype == cell::type::triangle)
+    return create_nedelec_2d_space<T>(degree);
+  else if (celltype == cell::type::tetrahedron)
+    return create_nedelec_3d_space<T>(degree);
+  else
+    throw std::runtime_error("Invalid celltype in Nedelec");
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+libtab::nedelec_dual(cell::type celltype, int degree)
+{
+  if (celltype == cell::type::triangle)
+    return create_nedelec_2d_dual<T>(degree);
+  else if (celltype == cell::type::tetrahedron)
+    return create_nedelec_3d_dual<T>(degree);
+  else
+    throw std::runtime_error("Invalid celltype in Nedelec");
+}
+//-----------------------------------------------------------------------------
+FiniteElement libtab::create_nedelec(cell::type celltype, int degree,
+                                     const std::string& name)
+{
+  const Eigen::MatrixXd wcoeffs = nedelec_space<double>(celltype, degree);
+  const Eigen::MatrixXd dual = nedelec_dual<double>(celltype, degree);
+
+  const DofLayout layout = nedelec_layout(celltype, degree);
+
   const Eigen::MatrixXd coeffs = compute_expansion_coefficients(wcoeffs, dual);
-  return FiniteElement(name, celltype, degree, {tdim}, coeffs, entity_dofs,
-                       perms);
+  return FiniteElement(name, celltype, degree, layout.value_shape, coeffs,
+                       layout.entity_dofs, layout.base_permutations);
 }
 //-----------------------------------------------------------------------------
 FiniteElement libtab::create_nedelec2(cell::type celltype, int degree,
@@ -473,3 +505,10 @@ FiniteElement libtab::create_nedelec2(cell::type celltype, int degree,
                        base_permutations);
 }
 //-----------------------------------------------------------------------------
+template Eigen::MatrixXd libtab::nedelec_space<double>(cell::type, int);
+template Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>
+libtab::nedelec_space<DoubleDouble>(cell::type, int);
+template Eigen::MatrixXd libtab::nedelec_dual<double>(cell::type, int);
+template Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>
+libtab::nedelec_dual<DoubleDouble>(cell::type, int);
+//-----------------------------------------------------------------------------
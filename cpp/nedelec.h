@@ -9,6 +9,28 @@
 
 namespace libtab
 {
+/// Dofs of the Nedelec element (first kind), without computing its
+/// expansion coefficients
+/// @param celltype
+/// @param degree
+DofLayout nedelec_layout(cell::type celltype, int degree);
+
+/// Expansion coefficients of the polynomial span of the Nedelec element
+/// (first kind), in the arithmetic of T (double or DoubleDouble)
+/// @param celltype
+/// @param degree
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+nedelec_space(cell::type celltype, int degree);
+
+/// Dual matrix of the Nedelec element (first kind), in the arithmetic of T
+/// (double or DoubleDouble)
+/// @param celltype
+/// @param degree
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+nedelec_dual(cell::type celltype, int degree);
+
 /// Create Nedelec element (first kind)
 /// @param celltype
 /// @param degree
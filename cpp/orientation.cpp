@@ -0,0 +1,216 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "orientation.h"
+#include "libtab.h"
+#include "memory.h"
+#include "parallel.h"
+#include <algorithm>
+#include <numeric>
+#include <set>
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Number of edges and faces which have base permutations
+std::pair<int, int> num_oriented_entities(cell::type celltype)
+{
+  const int tdim = cell::topological_dimension(celltype);
+  const int nedges = tdim > 1 ? cell::sub_entity_count(celltype, 1) : 0;
+  const int nfaces = tdim > 2 ? cell::sub_entity_count(celltype, 2) : 0;
+  return {nedges, nfaces};
+}
+//-----------------------------------------------------------------------------
+// Largest number of realisable orientations precomputed by default
+constexpr std::size_t max_default_orientations = 1024;
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+std::uint32_t
+orientation::pack(const std::vector<bool>& edge_reflections,
+                  const std::vector<int>& face_rotations,
+                  const std::vector<bool>& face_reflections)
+{
+  if (face_rotations.size() != face_reflections.size())
+    throw std::runtime_error("Face rotations and reflections do not match");
+  if (edge_reflections.size() + 3 * face_rotations.size() > 32)
+    throw std::runtime_error("Too many entities to pack orientation");
+
+  std::uint32_t bits = 0;
+  for (std::size_t e = 0; e < edge_reflections.size(); ++e)
+    bits |= std::uint32_t(edge_reflections[e]) << e;
+  for (std::size_t f = 0; f < face_rotations.size(); ++f)
+  {
+    if (face_rotations[f] < 0 or face_rotations[f] > 3)
+      throw std::runtime_error("Invalid number of face rotations");
+    const int shift = edge_reflections.size() + 3 * f;
+    bits |= std::uint32_t(face_rotations[f]) << shift;
+    bits |= std::uint32_t(face_reflections[f]) << (shift + 2);
+  }
+  return bits;
+}
+//-----------------------------------------------------------------------------
+std::uint32_t orientation::compute(cell::type celltype,
+                                   const std::vector<std::int64_t>& vertices)
+{
+  const std::vector<std::vector<std::vector<int>>> topology
+      = cell::topology(celltype);
+  if (vertices.size() != topology[0].size())
+    throw std::runtime_error("Wrong number of vertices for cell");
+
+  const auto [nedges, nfaces] = num_oriented_entities(celltype);
+  std::vector<bool> edge_reflections(nedges);
+  for (int e = 0; e < nedges; ++e)
+  {
+    const std::vector<int>& edge = topology[1][e];
+    edge_reflections[e] = vertices[edge[0]] > vertices[edge[1]];
+  }
+
+  std::vector<int> face_rotations(nfaces);
+  std::vector<bool> face_reflections(nfaces);
+  for (int f = 0; f < nfaces; ++f)
+  {
+    // Vertices of the face in the order going around it (quadrilateral
+    // faces are listed in tensor product order)
+    const std::vector<int>& face = topology[2][f];
+    std::vector<std::int64_t> cycle;
+    if (face.size() == 3)
+      cycle = {vertices[face[0]], vertices[face[1]], vertices[face[2]]};
+    else
+    {
+      cycle = {vertices[face[0]], vertices[face[1]], vertices[face[3]],
+               vertices[face[2]]};
+    }
+
+    const int n = cycle.size();
+    const int rots = std::min_element(cycle.begin(), cycle.end())
+                     - cycle.begin();
+    face_rotations[f] = rots;
+    face_reflections[f] = cycle[(rots + 1) % n] > cycle[(rots + n - 1) % n];
+  }
+
+  return pack(edge_reflections, face_rotations, face_reflections);
+}
+//-----------------------------------------------------------------------------
+std::vector<std::uint32_t> orientation::realisable(cell::type celltype)
+{
+  std::vector<std::int64_t> vertices(cell::sub_entity_count(celltype, 0));
+  std::iota(vertices.begin(), vertices.end(), 0);
+  std::set<std::uint32_t> orientations;
+  do
+  {
+    orientations.insert(compute(celltype, vertices));
+  } while (std::next_permutation(vertices.begin(), vertices.end()));
+
+  return std::vector<std::uint32_t>(orientations.begin(), orientations.end());
+}
+//-----------------------------------------------------------------------------
+Eigen::MatrixXd orientation::transformation(const FiniteElement& element,
+                                            std::uint32_t bits)
+{
+  const auto [nedges, nfaces] = num_oriented_entities(element.cell_type());
+  const std::vector<Eigen::MatrixXd> perms = element.base_permutations();
+  if (static_cast<int>(perms.size()) != nedges + 2 * nfaces)
+  {
+    throw std::runtime_error(
+        "Element does not have base permutations for each entity");
+  }
+
+  // The permutations of different entities act on different dofs, so the
+  // order in which the entities are applied does not matter
+  Eigen::MatrixXd T = Eigen::MatrixXd::Identity(element.dim(), element.dim());
+  for (int e = 0; e < nedges; ++e)
+  {
+    if (bits >> e & 1)
+      T = perms[e] * T;
+  }
+  for (int f = 0; f < nfaces; ++f)
+  {
+    const int shift = nedges + 3 * f;
+    for (std::uint32_t r = 0; r < (bits >> shift & 3); ++r)
+      T = perms[nedges + 2 * f] * T;
+    if (bits >> (shift + 2) & 1)
+      T = perms[nedges + 2 * f + 1] * T;
+  }
+  return T;
+}
+//-----------------------------------------------------------------------------
+OrientationTables::OrientationTables(
+    const FiniteElement& element, int nd, const Eigen::ArrayXXd& x,
+    const std::vector<std::uint32_t>& orientations, int nthreads)
+    : _orientations(orientations.empty()
+                        ? orientation::realisable(element.cell_type())
+                        : orientations)
+{
+  if (orientations.empty()
+      and _orientations.size() > max_default_orientations)
+  {
+    throw std::runtime_error("Too many realisable orientations to "
+                             "precompute: pass the orientations needed");
+  }
+
+  std::vector<Eigen::ArrayXXd> reference;
+  if (x.rows() > 0)
+    reference = element.tabulate(nd, x);
+
+  // Create the entries first, so they can be filled concurrently
+  std::vector<std::pair<std::uint32_t, Entry*>> entries;
+  for (std::uint32_t bits : _orientations)
+    if (_entries.count(bits) == 0)
+      entries.emplace_back(bits, &_entries[bits]);
+
+  const int ndofs = element.dim();
+  const int vs = element.value_size();
+  parallel::for_each(entries.size(), nthreads, [&](int i) {
+    const Eigen::MatrixXd T
+        = orientation::transformation(element, entries[i].first);
+    Entry& entry = *entries[i].second;
+    entry.coeffs = T * element.coefficients();
+
+    // Each component of the tables is multiplied by T^T
+    entry.tables.resize(reference.size());
+    for (std::size_t p = 0; p < reference.size(); ++p)
+    {
+      entry.tables[p].resize(reference[p].rows(), reference[p].cols());
+      memory::advise_huge_pages(entry.tables[p].data(),
+                                entry.tables[p].size() * sizeof(double));
+      for (int j = 0; j < vs; ++j)
+      {
+        entry.tables[p].matrix().middleCols(j * ndofs, ndofs).noalias()
+            = reference[p].matrix().middleCols(j * ndofs, ndofs)
+              * T.transpose();
+      }
+    }
+  });
+}
+//-----------------------------------------------------------------------------
+const std::vector<std::uint32_t>& OrientationTables::orientations() const
+{
+  return _orientations;
+}
+//-----------------------------------------------------------------------------
+const Eigen::MatrixXd&
+OrientationTables::coefficients(std::uint32_t bits) const
+{
+  return entry(bits).coeffs;
+}
+//-----------------------------------------------------------------------------
+const std::vector<Eigen::ArrayXXd>&
+OrientationTables::tables(std::uint32_t bits) const
+{
+  return entry(bits).tables;
+}
+//-----------------------------------------------------------------------------
+const OrientationTables::Entry&
+OrientationTables::entry(std::uint32_t bits) const
+{
+  auto it = _entries.find(bits);
+  if (it == _entries.end())
+    throw std::runtime_error("Orientation has not been precomputed");
+  return it->second;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,124 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "cell.h"
+#include <Eigen/Dense>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace libtab
+{
+
+class FiniteElement;
+
+/// ## Cell orientations
+/// The orientation of a cell in a mesh is described by whether each edge
+/// is reflected, and by how many times each face is rotated and whether
+/// it is reflected, relative to the reference cell. These are packed into
+/// the bits of an integer: bit e is set if edge e is reflected, and face f
+/// uses the three bits from nedges + 3f, with the number of rotations in
+/// the lower two bits and the reflection in the third.
+///
+/// The effect of an orientation on the dofs is the product of the base
+/// permutations (see FiniteElement::base_permutations) of the reflected
+/// edges, and, for each face, the rotation applied the given number of
+/// times followed by the reflection.
+namespace orientation
+{
+
+/// Pack orientation data into bits
+/// @param[in] edge_reflections Whether each edge is reflected
+/// @param[in] face_rotations Number of rotations of each face
+/// @param[in] face_reflections Whether each face is reflected
+/// @return The packed bits
+std::uint32_t pack(const std::vector<bool>& edge_reflections,
+                   const std::vector<int>& face_rotations = {},
+                   const std::vector<bool>& face_reflections = {});
+
+/// Compute the orientation of a cell from the global numbers of its
+/// vertices. An edge is reflected if its first vertex has the larger
+/// global number. A face is rotated until its vertex with the smallest
+/// global number comes first (going around the face), and then reflected
+/// if the vertex after it has a larger global number than the vertex
+/// before it.
+/// @param[in] celltype The cell type
+/// @param[in] vertices The global numbers of the cell's vertices
+/// @return The packed orientation bits
+std::uint32_t compute(cell::type celltype,
+                      const std::vector<std::int64_t>& vertices);
+
+/// All orientations which can arise from a numbering of the vertices of a
+/// cell, i.e. compute for each ordering of the vertices
+/// @param[in] celltype The cell type
+/// @return The distinct packed orientations, in increasing order
+std::vector<std::uint32_t> realisable(cell::type celltype);
+
+/// The matrix T giving the effect of an orientation on the dofs of an
+/// element: the basis functions of the oriented cell are T applied to the
+/// reference basis functions
+/// @param[in] element The element
+/// @param[in] bits The packed orientation
+/// @return Matrix of shape (dim, dim)
+Eigen::MatrixXd transformation(const FiniteElement& element,
+                               std::uint32_t bits);
+
+} // namespace orientation
+
+/// Tables of an element with the effect of each orientation already
+/// applied, so that assembly can look up the table for the orientation of
+/// a cell rather than transform the dofs of each cell
+class OrientationTables
+{
+public:
+  /// Precompute the coefficients and tabulated values of the element for
+  /// each orientation
+  /// @param[in] element The element
+  /// @param[in] nd The order of derivatives, up to and including, to
+  /// tabulate
+  /// @param[in] x The points at which to tabulate. If empty, only the
+  /// coefficients are computed.
+  /// @param[in] orientations The packed orientations to precompute. If
+  /// empty, all orientations realisable from a vertex numbering are used
+  /// (6 on a triangle, 24 on a tetrahedron, 720 on a prism). Hexahedra
+  /// have 24024 realisable orientations, so the orientations which occur
+  /// in the mesh must be given.
+  /// @param[in] nthreads The number of threads used to compute the
+  /// orientations concurrently
+  OrientationTables(const FiniteElement& element, int nd,
+                    const Eigen::ArrayXXd& x,
+                    const std::vector<std::uint32_t>& orientations = {},
+                    int nthreads = 1);
+
+  /// The precomputed orientations
+  const std::vector<std::uint32_t>& orientations() const;
+
+  /// The expansion coefficients of the basis functions for an orientation
+  /// (see FiniteElement::coefficients)
+  /// @param[in] bits The packed orientation
+  /// @return The coefficients
+  const Eigen::MatrixXd& coefficients(std::uint32_t bits) const;
+
+  /// The basis functions and derivatives at the points for an
+  /// orientation, in the layout of FiniteElement::tabulate
+  /// @param[in] bits The packed orientation
+  /// @return The tables
+  const std::vector<Eigen::ArrayXXd>& tables(std::uint32_t bits) const;
+
+private:
+  struct Entry
+  {
+    Eigen::MatrixXd coeffs;
+    std::vector<Eigen::ArrayXXd> tables;
+  };
+
+  const Entry& entry(std::uint32_t bits) const;
+
+  std::vector<std::uint32_t> _orientations;
+  std::unordered_map<std::uint32_t, Entry> _entries;
+};
+
+} // namespace libtab
@@ -0,0 +1,257 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "parallel.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace libtab;
+
+namespace
+{
+// Set on threads which are executing tasks of a parallel region, so that
+// nested regions run serially rather than waiting on the busy pool
+thread_local bool in_parallel_region = false;
+
+//-----------------------------------------------------------------------------
+std::mutex executor_mutex;
+std::shared_ptr<parallel::Executor> current_executor;
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+// Pool of worker threads which execute one parallel region at a time. The
+// calling thread also takes tasks, so a region with nthreads threads uses
+// nthreads - 1 workers.
+class parallel::WorkStealingExecutor::Pool
+{
+public:
+  ~Pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _start.notify_all();
+    for (std::thread& t : _workers)
+      t.join();
+  }
+
+  void run(int n, int nthreads, const std::function<void(int)>& f)
+  {
+    // Regions started from different threads are run one after another
+    std::lock_guard<std::mutex> region_lock(_region_mutex);
+
+    const int nworkers = std::max(std::min(nthreads, n) - 1, 0);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      while (static_cast<int>(_ranges.size()) < nworkers + 1)
+        _ranges.push_back(std::make_unique<Range>());
+      while (static_cast<int>(_workers.size()) < nworkers)
+      {
+        const int id = _workers.size();
+        _workers.emplace_back([this, id]() { work_loop(id); });
+      }
+
+      // Split the tasks evenly, the calling thread takes the last range
+      for (int p = 0; p <= nworkers; ++p)
+      {
+        _ranges[p]->begin = static_cast<long>(n) * p / (nworkers + 1);
+        _ranges[p]->end = static_cast<long>(n) * (p + 1) / (nworkers + 1);
+      }
+      _task = &f;
+      _nworkers = nworkers;
+      _finished = 0;
+      _error = nullptr;
+      ++_generation;
+    }
+    _start.notify_all();
+
+    take_tasks(nworkers);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _finished == _nworkers; });
+    _task = nullptr;
+    if (_error)
+      std::rethrow_exception(_error);
+  }
+
+private:
+  // Remaining tasks of one thread
+  struct Range
+  {
+    std::mutex mutex;
+    int begin = 0;
+    int end = 0;
+  };
+
+  void work_loop(int id)
+  {
+    std::size_t seen = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+      _start.wait(lock, [&]() { return _stop or _generation != seen; });
+      if (_stop)
+        return;
+      seen = _generation;
+      if (id >= _nworkers)
+        continue;
+
+      lock.unlock();
+      take_tasks(id);
+      lock.lock();
+      if (++_finished == _nworkers)
+        _done.notify_one();
+    }
+  }
+
+  // Take the next task of thread id, stealing from the other threads once
+  // its own range is empty. Returns -1 when no tasks are left.
+  int next_task(int id)
+  {
+    Range& own = *_ranges[id];
+    {
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (own.begin < own.end)
+        return own.begin++;
+    }
+
+    for (int k = 1; k <= _nworkers; ++k)
+    {
+      Range& victim = *_ranges[(id + k) % (_nworkers + 1)];
+      int begin, end;
+      {
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.begin >= victim.end)
+          continue;
+        // Take the back half of the victim's remaining tasks
+        end = victim.end;
+        begin = victim.begin + (victim.end - victim.begin) / 2;
+        victim.end = begin;
+      }
+
+      std::lock_guard<std::mutex> lock(own.mutex);
+      own.begin = begin + 1;
+      own.end = end;
+      return begin;
+    }
+
+    return -1;
+  }
+
+  // Execute tasks until none are left
+  void take_tasks(int id)
+  {
+    in_parallel_region = true;
+    for (int i = next_task(id); i != -1; i = next_task(id))
+    {
+      try
+      {
+        (*_task)(i);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error)
+          _error = std::current_exception();
+      }
+    }
+    in_parallel_region = false;
+  }
+
+  std::vector<std::thread> _workers;
+  std::vector<std::unique_ptr<Range>> _ranges;
+  std::mutex _region_mutex;
+  std::mutex _mutex;
+  std::condition_variable _start;
+  std::condition_variable _done;
+  bool _stop = false;
+  std::size_t _generation = 0;
+
+  // Current region
+  const std::function<void(int)>* _task = nullptr;
+  int _nworkers = 0;
+  int _finished = 0;
+  std::exception_ptr _error;
+};
+//-----------------------------------------------------------------------------
+parallel::WorkStealingExecutor::WorkStealingExecutor()
+    : _pool(std::make_unique<Pool>())
+{
+}
+//-----------------------------------------------------------------------------
+parallel::WorkStealingExecutor::~WorkStealingExecutor() = default;
+//-----------------------------------------------------------------------------
+void parallel::WorkStealingExecutor::run(int n, int nthreads,
+                                         const std::function<void(int)>& f)
+{
+  _pool->run(n, nthreads, f);
+}
+//-----------------------------------------------------------------------------
+parallel::FunctionExecutor::FunctionExecutor(function run)
+    : _run(std::move(run))
+{
+}
+//-----------------------------------------------------------------------------
+void parallel::FunctionExecutor::run(int n, int nthreads,
+                                     const std::function<void(int)>& f)
+{
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  _run(n, nthreads, [&](int i) {
+    const bool nested = in_parallel_region;
+    in_parallel_region = true;
+    try
+    {
+      f(i);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+        error = std::current_exception();
+    }
+    in_parallel_region = nested;
+  });
+
+  if (error)
+    std::rethrow_exception(error);
+}
+//-----------------------------------------------------------------------------
+void parallel::set_executor(std::shared_ptr<Executor> executor)
+{
+  std::lock_guard<std::mutex> lock(executor_mutex);
+  current_executor = std::move(executor);
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<parallel::Executor> parallel::get_executor()
+{
+  std::lock_guard<std::mutex> lock(executor_mutex);
+  if (!current_executor)
+  {
+    static std::shared_ptr<Executor> default_executor
+        = std::make_shared<WorkStealingExecutor>();
+    current_executor = default_executor;
+  }
+  return current_executor;
+}
+//-----------------------------------------------------------------------------
+void parallel::for_each(int n, int nthreads,
+                        const std::function<void(int)>& f)
+{
+  if (nthreads < 2 or n < 2 or in_parallel_region)
+  {
+    for (int i = 0; i < n; ++i)
+      f(i);
+    return;
+  }
+
+  get_executor()->run(n, nthreads, f);
+}
+//-----------------------------------------------------------------------------
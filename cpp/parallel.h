@@ -0,0 +1,103 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+namespace libtab
+{
+
+/// ## Task parallelism
+/// Independent tasks within a single call (e.g. the derivative tables of
+/// one order in the polyset recurrences, or the tables of each orientation
+/// of an element) are run by an executor shared by all of libtab. By
+/// default this is a pool of worker threads with work stealing, created on
+/// first use and grown to the largest number of threads requested. An
+/// application with its own thread pool (TBB, OpenMP, ...) can instead
+/// set an executor which runs the tasks on that pool, so that libtab does
+/// not oversubscribe the cores.
+namespace parallel
+{
+
+/// Runs the tasks of a parallel region
+class Executor
+{
+public:
+  virtual ~Executor() = default;
+
+  /// Run f(i) for i = 0, ..., n - 1 and return once all tasks have
+  /// completed. An exception thrown by a task must be rethrown on the
+  /// calling thread.
+  /// @param n Number of tasks
+  /// @param nthreads Maximum number of threads requested by the caller
+  /// @param f Task function, taking the task index
+  virtual void run(int n, int nthreads, const std::function<void(int)>& f)
+      = 0;
+};
+
+/// Pool of worker threads. The tasks of a region are split into one
+/// contiguous range per thread (including the calling thread), and a
+/// thread which finishes its range steals half of the remaining range of
+/// another thread.
+class WorkStealingExecutor : public Executor
+{
+public:
+  WorkStealingExecutor();
+  ~WorkStealingExecutor();
+
+  /// Run the tasks on up to nthreads threads (see Executor::run)
+  void run(int n, int nthreads, const std::function<void(int)>& f) override;
+
+private:
+  class Pool;
+  std::unique_ptr<Pool> _pool;
+};
+
+/// Adapter for an externally supplied thread pool
+class FunctionExecutor : public Executor
+{
+public:
+  /// Function which runs f(i) for i = 0, ..., n - 1 on the external pool
+  /// and returns once all have completed, e.g. with tbb::parallel_for or
+  /// an OpenMP parallel loop. The number of threads requested by libtab
+  /// is passed as a hint.
+  using function = std::function<void(int n, int nthreads,
+                                      const std::function<void(int)>& f)>;
+
+  /// Create an executor using a function which runs the tasks
+  /// @param run The function
+  explicit FunctionExecutor(function run);
+
+  /// Run the tasks with the function. Exceptions thrown by tasks are
+  /// caught, so they do not escape into the external pool, and the first
+  /// is rethrown once the function returns.
+  void run(int n, int nthreads, const std::function<void(int)>& f) override;
+
+private:
+  function _run;
+};
+
+/// Set the executor used by all parallel regions
+/// @param executor The executor, or nullptr for the default
+/// WorkStealingExecutor
+void set_executor(std::shared_ptr<Executor> executor);
+
+/// The executor used by all parallel regions
+std::shared_ptr<Executor> get_executor();
+
+/// Run f(i) for i = 0, ..., n - 1, using up to nthreads threads (including
+/// the calling thread), and return once all tasks have completed. The
+/// tasks must be independent. If nthreads < 2, or if called from within
+/// another parallel region, the tasks are run in order on the calling
+/// thread. Otherwise they are run by the executor. An exception thrown by
+/// a task is rethrown on the calling thread.
+/// @param n Number of tasks
+/// @param nthreads Maximum number of threads to use
+/// @param f Task function, taking the task index
+void for_each(int n, int nthreads, const std::function<void(int)>& f);
+
+} // namespace parallel
+} // namespace libtab
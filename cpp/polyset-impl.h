@@ -0,0 +1,993 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "cell.h"
+#include "indexing.h"
+#include "parallel.h"
+#include "polyset-scalar.h"
+#include "polyset.h"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+/// @file polyset-impl.h
+/// @brief Definitions of the polynomial set recurrences for any scalar type
+///
+/// The recurrences are templated on the scalar type T of the points and
+/// tables. They only need +, - and * of T with T and with double, and the
+/// construction of T from a double. The library instantiates
+/// polyset::tabulate_values for double, DoubleDouble, Dual<N> and
+/// Dual<N, Dual<N>> with N = 1, 2, 3. Include this header to use it with
+/// other scalar types, e.g. Dual<N, DoubleDouble> or third derivatives.
+
+namespace libtab
+{
+namespace polyset
+{
+namespace impl
+{
+
+template <typename T>
+using Column = Eigen::Array<T, Eigen::Dynamic, 1>;
+
+template <typename T>
+using Points = Eigen::Ref<const Table<T>>;
+//-----------------------------------------------------------------------------
+// Called with each derivative order k once its tables in the result are
+// complete and normalised. The tables of order k are not read again, so
+// the consumer may move them out.
+using order_consumer = std::function<void(int)>;
+//-----------------------------------------------------------------------------
+// Make sure that a scratch table has the given number of rows and at least
+// the given number of columns, only reallocating if it does not
+template <typename T>
+void reserve(Table<T>& table, Eigen::Index rows, Eigen::Index cols)
+{
+  if (table.rows() != rows or table.cols() < cols)
+    table.resize(rows, std::max(cols, table.cols()));
+}
+//-----------------------------------------------------------------------------
+// Give a list of tables the given size, which does not allocate if they
+// already have it
+template <typename T>
+void resize(std::vector<Table<T>>& tables, std::size_t count,
+            Eigen::Index rows, Eigen::Index cols)
+{
+  tables.resize(count);
+  for (Table<T>& table : tables)
+    table.resize(rows, cols);
+}
+//-----------------------------------------------------------------------------
+// Check that barycentric coordinates can be tabulated on a cell
+inline void check_points(cell::type celltype, Eigen::Index cols,
+                         polyset::coordinates coords)
+{
+  if (coords != polyset::coordinates::barycentric)
+    return;
+  if (celltype != cell::type::interval and celltype != cell::type::triangle
+      and celltype != cell::type::tetrahedron)
+  {
+    throw std::runtime_error(
+        "Barycentric coordinates are only supported on simplices");
+  }
+  if (cols != cell::topological_dimension(celltype) + 1)
+    throw std::runtime_error("Barycentric coordinates do not match cell");
+}
+//-----------------------------------------------------------------------------
+// Compute coefficients in the Jacobi Polynomial recurrence relation
+constexpr std::array<double, 3> jrc(int a, int n)
+{
+  double an = (a + 2 * n + 1) * (a + 2 * n + 2)
+              / static_cast<double>(2 * (n + 1) * (a + n + 1));
+  double bn = a * a * (a + 2 * n + 1)
+              / static_cast<double>(2 * (n + 1) * (a + n + 1) * (a + 2 * n));
+  double cn = n * (a + n) * (a + 2 * n + 2)
+              / static_cast<double>((n + 1) * (a + n + 1) * (a + 2 * n));
+  return {an, bn, cn};
+}
+//-----------------------------------------------------------------------------
+// Compute the complete set of derivatives from 0 to nderiv, for all the
+// polynomials up to order n on a line segment. The polynomials used are
+// Legendre Polynomials, with the recurrence relation given by
+// n P(n) = (2n - 1) x P_{n-1} - (n - 1) P_{n-2} in the interval [-1, 1]. The
+// range is rescaled here to [0, 1], and X is the point in [-1, 1].
+template <typename T>
+void line_derivs(int degree, int nderiv,
+                 const Eigen::Ref<const Column<T>>& X,
+                 std::vector<Table<T>>& dresult)
+{
+  const int m = (degree + 1);
+
+  dresult.resize(nderiv + 1);
+  for (int k = 0; k < nderiv + 1; ++k)
+  {
+    // Get reference to this derivative
+    Table<T>& result = dresult[k];
+    result.resize(X.rows(), m);
+
+    if (k == 0)
+      result.col(0).fill(T(1.0));
+    else
+      result.col(0).setZero();
+
+    for (int p = 1; p < degree + 1; ++p)
+    {
+      const double a = 1.0 - 1.0 / static_cast<double>(p);
+      result.col(p) = X * result.col(p - 1) * (a + 1.0);
+      if (k > 0)
+        result.col(p) += 2 * k * dresult[k - 1].col(p - 1) * (a + 1.0);
+      if (p > 1)
+        result.col(p) -= result.col(p - 2) * a;
+    }
+  }
+
+  // Normalise
+  for (int k = 0; k < nderiv + 1; ++k)
+  {
+    for (int p = 0; p < degree + 1; ++p)
+      dresult[k].col(p) *= std::sqrt(p + 0.5);
+  }
+}
+//-----------------------------------------------------------------------------
+// The polynomials on the interval [0, 1]. With barycentric coordinates
+// (l0, l1), the point in [-1, 1] is l1 - l0.
+template <typename T>
+void tabulate_polyset_line_derivs(
+    int degree, int nderiv, const Points<T>& x, std::vector<Table<T>>& dresult,
+    polyset::Workspace<T>& ws,
+    polyset::coordinates coords = polyset::coordinates::cartesian)
+{
+  const bool barycentric = coords == polyset::coordinates::barycentric;
+  assert(x.cols() == (barycentric ? 2 : 1));
+  reserve(ws.factors, x.rows(), 1);
+  if (barycentric)
+    ws.factors.col(0) = x.col(1) - x.col(0);
+  else
+    ws.factors.col(0) = x.col(0) * 2.0 - 1.0;
+
+  line_derivs<T>(degree, nderiv, ws.factors.col(0), dresult);
+}
+//-----------------------------------------------------------------------------
+// Compute the complete set of derivatives from 0 to nderiv, for all the
+// polynomials up to order n on a triangle in [0, 1][0, 1].
+// The polynomials P_{pq} are built up in sequence, firstly along q = 0, which
+// is a line segment, as in tabulate_polyset_interval_derivs above, but with a
+// change of variables. The polynomials are then extended in the q direction,
+// using the relation given in Sherwin and Karniadakis 1995
+// (https://doi.org/10.1016/0045-7825(94)00745-9)
+template <typename T>
+void tabulate_polyset_triangle_derivs(
+    int n, int nderiv, const Points<T>& pts, std::vector<Table<T>>& dresult,
+    polyset::Workspace<T>& ws, int nthreads = 1,
+    polyset::coordinates coords = polyset::coordinates::cartesian)
+
+{
+  // The recurrence only depends on the point (x, y) in [-1, 1]^2 through
+  // s = x + (y + 1)/2, y and f3 = ((1-y)/2)^2. With barycentric coordinates
+  // (l0, l1, l2), these are l1 - l0, l2 - (l0 + l1) and (l0 + l1)^2.
+  reserve(ws.factors, pts.rows(), 5);
+  auto s = ws.factors.col(0);
+  auto y = ws.factors.col(1);
+  auto f3 = ws.factors.col(2);
+  if (coords == polyset::coordinates::barycentric)
+  {
+    assert(pts.cols() == 3);
+    auto l01 = ws.factors.col(3);
+    l01 = pts.col(0) + pts.col(1);
+    s = pts.col(1) - pts.col(0);
+    y = pts.col(2) - l01;
+    f3 = l01.square();
+  }
+  else
+  {
+    assert(pts.cols() == 2);
+    auto x = ws.factors.middleCols(3, 2);
+    x = pts * 2.0 - 1.0;
+    s = x.col(0) + 0.5 * x.col(1) + 0.5;
+    y = x.col(1);
+    f3 = (1.0 - x.col(1)).square() * 0.25;
+  }
+
+  const int m = (n + 1) * (n + 2) / 2;
+  const int md = (nderiv + 1) * (nderiv + 2) / 2;
+  dresult.resize(md);
+
+  // Compute derivative (kx, ky) from the lower order derivatives
+  auto compute = [&](int kx, int ky) {
+    Table<T>& result = dresult[idx(kx, ky)];
+    result.resize(pts.rows(), m);
+
+    if (kx == 0 and ky == 0)
+      result.col(0).fill(T(1.0));
+    else
+      result.col(0).setZero();
+
+    for (int p = 1; p < n + 1; ++p)
+    {
+      const double a
+          = static_cast<double>(2 * p - 1) / static_cast<double>(p);
+      result.col(idx(p, 0)) = s * result.col(idx(p - 1, 0)) * a;
+      if (kx > 0)
+      {
+        result.col(idx(p, 0))
+            += 2 * kx * a * dresult[idx(kx - 1, ky)].col(idx(p - 1, 0));
+      }
+
+      if (ky > 0)
+      {
+        result.col(idx(p, 0))
+            += ky * a * dresult[idx(kx, ky - 1)].col(idx(p - 1, 0));
+      }
+
+      if (p > 1)
+      {
+        // y^2 terms
+        result.col(idx(p, 0)) -= f3 * result.col(idx(p - 2, 0)) * (a - 1.0);
+
+        if (ky > 0)
+        {
+          result.col(idx(p, 0))
+              -= ky * (y - 1.0) * dresult[idx(kx, ky - 1)].col(idx(p - 2, 0))
+                 * (a - 1.0);
+        }
+
+        if (ky > 1)
+        {
+          result.col(idx(p, 0))
+              -= ky * (ky - 1) * dresult[idx(kx, ky - 2)].col(idx(p - 2, 0))
+                 * (a - 1.0);
+        }
+      }
+    }
+
+    for (int p = 0; p < n; ++p)
+    {
+      result.col(idx(p, 1))
+          = result.col(idx(p, 0)) * (y * (1.5 + p) + 0.5 + p);
+      if (ky > 0)
+      {
+        result.col(idx(p, 1))
+            += 2 * ky * (1.5 + p) * dresult[idx(kx, ky - 1)].col(idx(p, 0));
+      }
+
+      for (int q = 1; q < n - p; ++q)
+      {
+        const auto [a1, a2, a3] = jrc(2 * p + 1, q);
+        result.col(idx(p, q + 1))
+            = result.col(idx(p, q)) * (y * a1 + a2)
+              - result.col(idx(p, q - 1)) * a3;
+        if (ky > 0)
+        {
+          result.col(idx(p, q + 1))
+              += 2 * ky * a1 * dresult[idx(kx, ky - 1)].col(idx(p, q));
+        }
+      }
+    }
+  };
+
+  // Iterate over derivatives in increasing order, since higher derivatives
+  // depend on earlier calculations. The derivatives of one order only
+  // depend on lower orders, so each order is computed as a set of
+  // independent tasks.
+  for (int k = 0; k < nderiv + 1; ++k)
+    parallel::for_each(k + 1, nthreads, [&](int kx) { compute(kx, k - kx); });
+
+  // Normalisation
+  for (std::size_t j = 0; j < dresult.size(); ++j)
+  {
+    for (int p = 0; p < n + 1; ++p)
+      for (int q = 0; q < n - p + 1; ++q)
+        dresult[j].col(idx(p, q)) *= std::sqrt((p + 0.5) * (p + q + 1));
+  }
+}
+//-----------------------------------------------------------------------------
+// Compute the complete set of derivatives from 0 to nderiv, for all the
+// polynomials up to order n on a tetrahedron. The recurrence for order k
+// reads orders k - 1 and k - 2 only, so once order k has been computed the
+// tables of order k - 2 are normalised and passed to emit (if set), and if
+// emit moves them out at most three orders are held at any time.
+template <typename T>
+void tabulate_polyset_tetrahedron_derivs(int n, int nderiv,
+                                         const Points<T>& pts,
+                                         std::vector<Table<T>>& dresult,
+                                         polyset::Workspace<T>& ws,
+                                         const order_consumer& emit,
+                                         int nthreads,
+                                         polyset::coordinates coords)
+{
+  // The recurrence only depends on the point (x, y, z) in [-1, 1]^3
+  // through the sums below. With barycentric coordinates (l0, l1, l2, l3),
+  // they are differences and sums of these, e.g. s = x + (y + z)/2 + 1 is
+  // l1 - l0 and f4 = (1 - z)/2 is l0 + l1 + l2.
+  reserve(ws.factors, pts.rows(), 12);
+  auto s = ws.factors.col(0);
+  auto yz = ws.factors.col(1);
+  auto f3 = ws.factors.col(2);
+  auto f4 = ws.factors.col(3);
+  auto y1 = ws.factors.col(4);
+  auto y2 = ws.factors.col(5);
+  auto z = ws.factors.col(6);
+  if (coords == polyset::coordinates::barycentric)
+  {
+    assert(pts.cols() == 4);
+    auto l01 = ws.factors.col(9);
+    l01 = pts.col(0) + pts.col(1);
+    s = pts.col(1) - pts.col(0);
+    yz = -2.0 * l01;
+    f3 = pts.col(2) - l01;
+    f4 = l01 + pts.col(2);
+    y1 = 2.0 * pts.col(2);
+    y2 = pts.col(2) + f3;
+    z = pts.col(3) - f4;
+  }
+  else
+  {
+    assert(pts.cols() == 3);
+    auto x = ws.factors.middleCols(9, 3);
+    x = pts * 2.0 - 1.0;
+    s = x.col(0) + 0.5 * (x.col(1) + x.col(2)) + 1.0;
+    yz = x.col(1) + x.col(2);
+    f3 = (1.0 + x.col(1) * 2.0 + x.col(2)) * 0.5;
+    f4 = (1.0 - x.col(2)) * 0.5;
+    y1 = 1.0 + x.col(1);
+    y2 = (2.0 + x.col(1) * 3.0 + x.col(2)) * 0.5;
+    z = x.col(2);
+  }
+
+  const int m = (n + 1) * (n + 2) * (n + 3) / 6;
+  const int md = (nderiv + 1) * (nderiv + 2) * (nderiv + 3) / 6;
+  dresult.resize(md);
+
+  // Normalise the tables of derivative order k and hand them over to emit
+  auto release = [&](int k) {
+    for (int i = idx(k, 0, 0); i < idx(k + 1, 0, 0); ++i)
+    {
+      Table<T>& result = dresult[i];
+      for (int p = 0; p < n + 1; ++p)
+      {
+        for (int q = 0; q < n - p + 1; ++q)
+        {
+          for (int r = 0; r < n - p - q + 1; ++r)
+          {
+            result.col(idx(p, q, r))
+                *= std::sqrt((p + 0.5) * (p + q + 1.0) * (p + q + r + 1.5));
+          }
+        }
+      }
+    }
+    if (emit)
+      emit(k);
+  };
+
+  auto f2 = ws.factors.col(7);
+  auto f5 = ws.factors.col(8);
+  f2 = yz.square() * 0.25;
+  f5 = f4 * f4;
+
+  // Compute derivative (kx, ky, kz) from the lower order derivatives
+  auto compute = [&](int kx, int ky, int kz) {
+    Table<T>& result = dresult[idx(kx, ky, kz)];
+    result.resize(pts.rows(), m);
+    if (kx == 0 and ky == 0 and kz == 0)
+      result.col(0).fill(T(1.0));
+    else
+      result.col(0).setZero();
+
+    for (int p = 1; p < n + 1; ++p)
+    {
+      double a = static_cast<double>(2 * p - 1) / static_cast<double>(p);
+      result.col(idx(p, 0, 0))
+          = s * result.col(idx(p - 1, 0, 0)) * a;
+      if (kx > 0)
+      {
+        result.col(idx(p, 0, 0))
+            += 2 * kx * a
+               * dresult[idx(kx - 1, ky, kz)].col(idx(p - 1, 0, 0));
+      }
+
+      if (ky > 0)
+      {
+        result.col(idx(p, 0, 0))
+            += ky * a * dresult[idx(kx, ky - 1, kz)].col(idx(p - 1, 0, 0));
+      }
+
+      if (kz > 0)
+      {
+        result.col(idx(p, 0, 0))
+            += kz * a * dresult[idx(kx, ky, kz - 1)].col(idx(p - 1, 0, 0));
+      }
+
+      if (p > 1)
+      {
+        result.col(idx(p, 0, 0))
+            -= f2 * result.col(idx(p - 2, 0, 0)) * (a - 1.0);
+        if (ky > 0)
+        {
+          result.col(idx(p, 0, 0))
+              -= ky * yz
+                 * dresult[idx(kx, ky - 1, kz)].col(idx(p - 2, 0, 0))
+                 * (a - 1.0);
+        }
+
+        if (ky > 1)
+        {
+          result.col(idx(p, 0, 0))
+              -= ky * (ky - 1)
+                 * dresult[idx(kx, ky - 2, kz)].col(idx(p - 2, 0, 0))
+                 * (a - 1.0);
+        }
+
+        if (kz > 0)
+        {
+          result.col(idx(p, 0, 0))
+              -= kz * yz
+                 * dresult[idx(kx, ky, kz - 1)].col(idx(p - 2, 0, 0))
+                 * (a - 1.0);
+        }
+
+        if (kz > 1)
+        {
+          result.col(idx(p, 0, 0))
+              -= kz * (kz - 1)
+                 * dresult[idx(kx, ky, kz - 2)].col(idx(p - 2, 0, 0))
+                 * (a - 1.0);
+        }
+
+        if (ky > 0 and kz > 0)
+        {
+          result.col(idx(p, 0, 0))
+              -= 2.0 * ky * kz
+                 * dresult[idx(kx, ky - 1, kz - 1)].col(idx(p - 2, 0, 0))
+                 * (a - 1.0);
+        }
+      }
+    }
+
+    for (int p = 0; p < n; ++p)
+    {
+      result.col(idx(p, 1, 0)) = result.col(idx(p, 0, 0)) * (y1 * p + y2);
+      if (ky > 0)
+      {
+        result.col(idx(p, 1, 0))
+            += 2 * ky * dresult[idx(kx, ky - 1, kz)].col(idx(p, 0, 0))
+               * (1.5 + p);
+      }
+
+      if (kz > 0)
+      {
+        result.col(idx(p, 1, 0))
+            += kz * dresult[idx(kx, ky, kz - 1)].col(idx(p, 0, 0));
+      }
+
+      for (int q = 1; q < n - p; ++q)
+      {
+        auto [aq, bq, cq] = jrc(2 * p + 1, q);
+        result.col(idx(p, q + 1, 0))
+            = result.col(idx(p, q, 0)) * (f3 * aq + f4 * bq)
+              - result.col(idx(p, q - 1, 0)) * f5 * cq;
+
+        if (ky > 0)
+        {
+          result.col(idx(p, q + 1, 0))
+              += 2 * ky * dresult[idx(kx, ky - 1, kz)].col(idx(p, q, 0))
+                 * aq;
+        }
+
+        if (kz > 0)
+        {
+          result.col(idx(p, q + 1, 0))
+              += kz * dresult[idx(kx, ky, kz - 1)].col(idx(p, q, 0))
+                     * (aq - bq)
+                 + kz * 2.0 * f4
+                       * dresult[idx(kx, ky, kz - 1)].col(idx(p, q - 1, 0))
+                       * cq;
+        }
+
+        if (kz > 1)
+        {
+          // Quadratic term in z
+          result.col(idx(p, q + 1, 0))
+              -= kz * (kz - 1)
+                 * dresult[idx(kx, ky, kz - 2)].col(idx(p, q - 1, 0)) * cq;
+        }
+      }
+    }
+
+    for (int p = 0; p < n; ++p)
+    {
+      for (int q = 0; q < n - p; ++q)
+      {
+        result.col(idx(p, q, 1))
+            = result.col(idx(p, q, 0))
+              * ((1.0 + p + q) + z * (2.0 + p + q));
+        if (kz > 0)
+        {
+          result.col(idx(p, q, 1))
+              += 2 * kz * (2.0 + p + q)
+                 * dresult[idx(kx, ky, kz - 1)].col(idx(p, q, 0));
+        }
+      }
+    }
+
+    for (int p = 0; p < n - 1; ++p)
+    {
+      for (int q = 0; q < n - p - 1; ++q)
+      {
+        for (int r = 1; r < n - p - q; ++r)
+        {
+          auto [ar, br, cr] = jrc(2 * p + 2 * q + 2, r);
+          result.col(idx(p, q, r + 1))
+              = result.col(idx(p, q, r)) * (z * ar + br)
+                - result.col(idx(p, q, r - 1)) * cr;
+          if (kz > 0)
+          {
+            result.col(idx(p, q, r + 1))
+                += 2 * kz * ar
+                   * dresult[idx(kx, ky, kz - 1)].col(idx(p, q, r));
+          }
+        }
+      }
+    }
+  };
+
+  // Traverse derivatives in increasing order. The derivatives of one
+  // order only depend on the two orders below, so each order is computed
+  // as a set of independent tasks.
+  for (int k = 0; k < nderiv + 1; ++k)
+  {
+    parallel::for_each((k + 1) * (k + 2) / 2, nthreads, [&](int i) {
+      // Invert i = idx(kx, ky, kz) - idx(k, 0, 0)
+      int j = 0;
+      while ((j + 1) * (j + 2) / 2 <= i)
+        ++j;
+      const int kz = i - j * (j + 1) / 2;
+      const int ky = j - kz;
+      compute(k - j, ky, kz);
+    });
+
+    // Order k - 2 is not needed by any higher order
+    if (k > 1)
+      release(k - 2);
+  }
+
+  for (int k = std::max(0, nderiv - 1); k < nderiv + 1; ++k)
+    release(k);
+}
+//-----------------------------------------------------------------------------
+// Compute the complete set of derivatives from 0 to nderiv, for all the
+// polynomials up to order n on a pyramid. As for the tetrahedron, the tables
+// of each order are passed to emit (if set) as soon as the recurrence is
+// done with them.
+template <typename T>
+void tabulate_polyset_pyramid_derivs(int n, int nderiv, const Points<T>& pts,
+                                     std::vector<Table<T>>& dresult,
+                                     polyset::Workspace<T>& ws,
+                                     const order_consumer& emit, int nthreads)
+{
+  assert(pts.cols() == 3);
+
+  reserve(ws.factors, pts.rows(), 4);
+  auto x = ws.factors.leftCols(3);
+  x = pts * 2.0 - 1.0;
+
+  const int m = (n + 1) * (n + 2) * (2 * n + 3) / 6;
+  const int md = (nderiv + 1) * (nderiv + 2) * (nderiv + 3) / 6;
+  dresult.resize(md);
+
+  // Indexing for pyramidal basis functions
+  auto pyr_idx = [&n](int p, int q, int r) -> int {
+    const int rv = n - r + 1;
+    const int r0 = r * (n + 1) * (n - r + 2) + (2 * r - 1) * (r - 1) * r / 6;
+    return r0 + p * rv + q;
+  };
+
+  // Normalise the tables of derivative order k and hand them over to emit
+  auto release = [&](int k) {
+    for (int i = idx(k, 0, 0); i < idx(k + 1, 0, 0); ++i)
+    {
+      Table<T>& result = dresult[i];
+      for (int r = 0; r < n + 1; ++r)
+      {
+        for (int p = 0; p < n - r + 1; ++p)
+        {
+          for (int q = 0; q < n - r + 1; ++q)
+          {
+            result.col(pyr_idx(p, q, r))
+                *= std::sqrt((q + 0.5) * (p + 0.5) * (p + q + r + 1.5));
+          }
+        }
+      }
+    }
+    if (emit)
+      emit(k);
+  };
+
+  auto f2 = ws.factors.col(3);
+  f2 = (1.0 - x.col(2)).square() * 0.25;
+
+  // Compute derivative (kx, ky, kz) from the lower order derivatives
+  auto compute = [&](int kx, int ky, int kz) {
+    Table<T>& result = dresult[idx(kx, ky, kz)];
+    result.resize(pts.rows(), m);
+    result.setZero();
+
+    const int pyramidal_index = pyr_idx(0, 0, 0);
+    assert(pyramidal_index < m);
+    if (kx == 0 and ky == 0 and kz == 0)
+      result.col(pyramidal_index).fill(T(1.0));
+    else
+      result.col(pyramidal_index).setZero();
+
+    // r = 0
+    for (int p = 0; p < n + 1; ++p)
+    {
+      if (p > 0)
+      {
+        const double a
+            = static_cast<double>(p - 1) / static_cast<double>(p);
+        result.col(pyr_idx(p, 0, 0)) = (0.5 + x.col(0) + x.col(2) * 0.5)
+                                       * result.col(pyr_idx(p - 1, 0, 0))
+                                       * (a + 1.0);
+        if (kx > 0)
+        {
+          result.col(pyr_idx(p, 0, 0))
+              += 2.0 * kx
+                 * dresult[idx(kx - 1, ky, kz)].col(pyr_idx(p - 1, 0, 0))
+                 * (a + 1.0);
+        }
+
+        if (kz > 0)
+        {
+          result.col(pyr_idx(p, 0, 0))
+              += kz * dresult[idx(kx, ky, kz - 1)].col(pyr_idx(p - 1, 0, 0))
+                 * (a + 1.0);
+        }
+
+        if (p > 1)
+        {
+          result.col(pyr_idx(p, 0, 0))
+              -= f2 * result.col(pyr_idx(p - 2, 0, 0)) * a;
+
+          if (kz > 0)
+          {
+            result.col(pyr_idx(p, 0, 0))
+                += kz * (1.0 - x.col(2))
+                   * dresult[idx(kx, ky, kz - 1)].col(pyr_idx(p - 2, 0, 0))
+                   * a;
+          }
+
+          if (kz > 1)
+          {
+            // quadratic term in z
+            result.col(pyr_idx(p, 0, 0))
+                -= kz * (kz - 1)
+                   * dresult[idx(kx, ky, kz - 2)].col(pyr_idx(p - 2, 0, 0))
+                   * a;
+          }
+        }
+      }
+
+      for (int q = 1; q < n + 1; ++q)
+      {
+        const double a
+            = static_cast<double>(q - 1) / static_cast<double>(q);
+        result.col(pyr_idx(p, q, 0)) = (0.5 + x.col(1) + x.col(2) * 0.5)
+                                       * result.col(pyr_idx(p, q - 1, 0))
+                                       * (a + 1.0);
+        if (ky > 0)
+        {
+          result.col(pyr_idx(p, q, 0))
+              += 2.0 * ky
+                 * dresult[idx(kx, ky - 1, kz)].col(pyr_idx(p, q - 1, 0))
+                 * (a + 1.0);
+        }
+
+        if (kz > 0)
+        {
+          result.col(pyr_idx(p, q, 0))
+              += kz * dresult[idx(kx, ky, kz - 1)].col(pyr_idx(p, q - 1, 0))
+                 * (a + 1.0);
+        }
+
+        if (q > 1)
+        {
+          result.col(pyr_idx(p, q, 0))
+              -= f2 * result.col(pyr_idx(p, q - 2, 0)) * a;
+
+          if (kz > 0)
+          {
+            result.col(pyr_idx(p, q, 0))
+                += kz * (1.0 - x.col(2))
+                   * dresult[idx(kx, ky, kz - 1)].col(pyr_idx(p, q - 2, 0))
+                   * a;
+          }
+
+          if (kz > 1)
+          {
+            result.col(pyr_idx(p, q, 0))
+                -= kz * (kz - 1)
+                   * dresult[idx(kx, ky, kz - 2)].col(pyr_idx(p, q - 2, 0))
+                   * a;
+          }
+        }
+      }
+    }
+
+    // Extend into r > 0
+    for (int p = 0; p < n; ++p)
+    {
+      for (int q = 0; q < n; ++q)
+      {
+        result.col(pyr_idx(p, q, 1))
+            = result.col(pyr_idx(p, q, 0))
+              * ((1.0 + p + q) + x.col(2) * (2.0 + p + q));
+        if (kz > 0)
+        {
+          result.col(pyr_idx(p, q, 1))
+              += 2 * kz * dresult[idx(kx, ky, kz - 1)].col(pyr_idx(p, q, 0))
+                 * (2.0 + p + q);
+        }
+      }
+    }
+
+    for (int r = 1; r < n + 1; ++r)
+    {
+      for (int p = 0; p < n - r; ++p)
+      {
+        for (int q = 0; q < n - r; ++q)
+        {
+          auto [ar, br, cr] = jrc(2 * p + 2 * q + 2, r);
+          result.col(pyr_idx(p, q, r + 1))
+              = result.col(pyr_idx(p, q, r)) * (x.col(2) * ar + br)
+                - result.col(pyr_idx(p, q, r - 1)) * cr;
+          if (kz > 0)
+          {
+            result.col(pyr_idx(p, q, r + 1))
+                += ar * 2 * kz
+                   * dresult[idx(kx, ky, kz - 1)].col(pyr_idx(p, q, r));
+          }
+        }
+      }
+    }
+  };
+
+  // Traverse derivatives in increasing order. The derivatives of one
+  // order only depend on the two orders below, so each order is computed
+  // as a set of independent tasks.
+  for (int k = 0; k < nderiv + 1; ++k)
+  {
+    parallel::for_each((k + 1) * (k + 2) / 2, nthreads, [&](int i) {
+      // Invert i = idx(kx, ky, kz) - idx(k, 0, 0)
+      int j = 0;
+      while ((j + 1) * (j + 2) / 2 <= i)
+        ++j;
+      const int kz = i - j * (j + 1) / 2;
+      const int ky = j - kz;
+      compute(k - j, ky, kz);
+    });
+
+    // Order k - 2 is not needed by any higher order
+    if (k > 1)
+      release(k - 2);
+  }
+
+  for (int k = std::max(0, nderiv - 1); k < nderiv + 1; ++k)
+    release(k);
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+void tabulate_polyset_quad_derivs(int n, int nderiv, const Points<T>& pts,
+                                  std::vector<Table<T>>& dresult,
+                                  polyset::Workspace<T>& ws)
+{
+  assert(pts.cols() == 2);
+  const int m = (n + 1) * (n + 1);
+  const int md = (nderiv + 1) * (nderiv + 2) / 2;
+
+  reserve(ws.factors, pts.rows(), 2);
+  ws.factors.leftCols(2) = pts * 2.0 - 1.0;
+  std::vector<Table<T>>& px = ws.tables[0];
+  std::vector<Table<T>>& py = ws.tables[1];
+  line_derivs<T>(n, nderiv, ws.factors.col(0), px);
+  line_derivs<T>(n, nderiv, ws.factors.col(1), py);
+
+  dresult.resize(md);
+  for (int kx = 0; kx < nderiv + 1; ++kx)
+  {
+    for (int ky = 0; ky < nderiv + 1 - kx; ++ky)
+    {
+      Table<T>& result = dresult[idx(kx, ky)];
+      result.resize(pts.rows(), m);
+      int c = 0;
+      for (int i = 0; i < px[kx].cols(); ++i)
+        for (int j = 0; j < py[ky].cols(); ++j)
+          result.col(c++) = px[kx].col(i) * py[ky].col(j);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+void tabulate_polyset_hex_derivs(int n, int nderiv, const Points<T>& pts,
+                                 std::vector<Table<T>>& dresult,
+                                 polyset::Workspace<T>& ws)
+{
+  assert(pts.cols() == 3);
+  const int m = (n + 1) * (n + 1) * (n + 1);
+  const int md = (nderiv + 1) * (nderiv + 2) * (nderiv + 3) / 6;
+
+  reserve(ws.factors, pts.rows(), 3);
+  ws.factors.leftCols(3) = pts * 2.0 - 1.0;
+  std::vector<Table<T>>& px = ws.tables[0];
+  std::vector<Table<T>>& py = ws.tables[1];
+  std::vector<Table<T>>& pz = ws.tables[2];
+  line_derivs<T>(n, nderiv, ws.factors.col(0), px);
+  line_derivs<T>(n, nderiv, ws.factors.col(1), py);
+  line_derivs<T>(n, nderiv, ws.factors.col(2), pz);
+
+  dresult.resize(md);
+  for (int kx = 0; kx < nderiv + 1; ++kx)
+  {
+    for (int ky = 0; ky < nderiv + 1 - kx; ++ky)
+    {
+      for (int kz = 0; kz < nderiv + 1 - kx - ky; ++kz)
+      {
+        Table<T>& result = dresult[idx(kx, ky, kz)];
+        result.resize(pts.rows(), m);
+        int c = 0;
+        for (int i = 0; i < px[kx].cols(); ++i)
+          for (int j = 0; j < py[ky].cols(); ++j)
+            for (int k = 0; k < pz[kz].cols(); ++k)
+              result.col(c++) = px[kx].col(i) * py[ky].col(j) * pz[kz].col(k);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+void tabulate_polyset_prism_derivs(int n, int nderiv, const Points<T>& pts,
+                                   std::vector<Table<T>>& dresult,
+                                   polyset::Workspace<T>& ws)
+{
+  assert(pts.cols() == 3);
+  const int m = (n + 1) * (n + 1) * (n + 2) / 2;
+  const int md = (nderiv + 1) * (nderiv + 2) * (nderiv + 3) / 6;
+
+  // The triangle recurrence is done with the factors before they are
+  // overwritten by the interval factor
+  std::vector<Table<T>>& pxy = ws.tables[0];
+  std::vector<Table<T>>& pz = ws.tables[1];
+  tabulate_polyset_triangle_derivs<T>(n, nderiv, pts.leftCols(2), pxy, ws);
+  reserve(ws.factors, pts.rows(), 1);
+  ws.factors.col(0) = pts.col(2) * 2.0 - 1.0;
+  line_derivs<T>(n, nderiv, ws.factors.col(0), pz);
+
+  dresult.resize(md);
+  for (int kx = 0; kx < nderiv + 1; ++kx)
+  {
+    for (int ky = 0; ky < nderiv + 1 - kx; ++ky)
+    {
+      for (int kz = 0; kz < nderiv + 1 - kx - ky; ++kz)
+      {
+        Table<T>& result = dresult[idx(kx, ky, kz)];
+        result.resize(pts.rows(), m);
+        int c = 0;
+        for (int i = 0; i < pxy[idx(kx, ky)].cols(); ++i)
+          for (int k = 0; k < pz[kz].cols(); ++k)
+            result.col(c++) = pxy[idx(kx, ky)].col(i) * pz[kz].col(k);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+// Size a workspace for the recurrences on a cell at npoints points, in
+// either coordinates
+template <typename T>
+void reserve_workspace(polyset::Workspace<T>& ws, cell::type celltype,
+                       int n, int nderiv, int npoints)
+{
+  const int md2 = (nderiv + 1) * (nderiv + 2) / 2;
+  switch (celltype)
+  {
+  case cell::type::interval:
+    reserve(ws.factors, npoints, 1);
+    break;
+  case cell::type::triangle:
+    reserve(ws.factors, npoints, 5);
+    break;
+  case cell::type::tetrahedron:
+    reserve(ws.factors, npoints, 12);
+    break;
+  case cell::type::quadrilateral:
+    reserve(ws.factors, npoints, 2);
+    for (int d = 0; d < 2; ++d)
+      resize(ws.tables[d], nderiv + 1, npoints, n + 1);
+    break;
+  case cell::type::hexahedron:
+    reserve(ws.factors, npoints, 3);
+    for (int d = 0; d < 3; ++d)
+      resize(ws.tables[d], nderiv + 1, npoints, n + 1);
+    break;
+  case cell::type::prism:
+    reserve(ws.factors, npoints, 5);
+    resize(ws.tables[0], md2, npoints, (n + 1) * (n + 2) / 2);
+    resize(ws.tables[1], nderiv + 1, npoints, n + 1);
+    break;
+  case cell::type::pyramid:
+    reserve(ws.factors, npoints, 4);
+    break;
+  default:
+    throw std::runtime_error("Polynomial set: Unsupported cell type");
+  }
+}
+//-----------------------------------------------------------------------------
+// Tabulate the polynomial set and its derivatives on any cell into dresult
+template <typename T>
+void tabulate_derivs(cell::type celltype, int n, int nderiv,
+                     const Points<T>& pts, std::vector<Table<T>>& dresult,
+                     polyset::Workspace<T>& ws, int nthreads,
+                     polyset::coordinates coords)
+{
+  switch (celltype)
+  {
+  case cell::type::interval:
+    tabulate_polyset_line_derivs<T>(n, nderiv, pts, dresult, ws, coords);
+    return;
+  case cell::type::triangle:
+    tabulate_polyset_triangle_derivs<T>(n, nderiv, pts, dresult, ws,
+                                        nthreads, coords);
+    return;
+  case cell::type::tetrahedron:
+    tabulate_polyset_tetrahedron_derivs<T>(n, nderiv, pts, dresult, ws,
+                                           nullptr, nthreads, coords);
+    return;
+  case cell::type::quadrilateral:
+    tabulate_polyset_quad_derivs<T>(n, nderiv, pts, dresult, ws);
+    return;
+  case cell::type::prism:
+    tabulate_polyset_prism_derivs<T>(n, nderiv, pts, dresult, ws);
+    return;
+  case cell::type::pyramid:
+    tabulate_polyset_pyramid_derivs<T>(n, nderiv, pts, dresult, ws, nullptr,
+                                       nthreads);
+    return;
+  case cell::type::hexahedron:
+    tabulate_polyset_hex_derivs<T>(n, nderiv, pts, dresult, ws);
+    return;
+  default:
+    throw std::runtime_error("Polynomial set: Unsupported cell type");
+  }
+}
+//-----------------------------------------------------------------------------
+// Tabulate the polynomial set and its derivatives on any cell
+template <typename T>
+std::vector<Table<T>> tabulate_derivs(cell::type celltype, int n, int nderiv,
+                                      const Table<T>& pts, int nthreads,
+                                      polyset::coordinates coords)
+{
+  std::vector<Table<T>> dresult;
+  polyset::Workspace<T> ws;
+  tabulate_derivs<T>(celltype, n, nderiv, pts, dresult, ws, nthreads, coords);
+  return dresult;
+}
+} // namespace impl
+
+//-----------------------------------------------------------------------------
+template <typename T>
+Table<T> tabulate_values(cell::type celltype, int degree, const Table<T>& x)
+{
+  if (x.cols() != cell::topological_dimension(celltype))
+    throw std::runtime_error("Point dimension does not match cell");
+  return impl::tabulate_derivs(celltype, degree, 0, x, 1,
+                               coordinates::cartesian)[0];
+}
+//-----------------------------------------------------------------------------
+} // namespace polyset
+} // namespace libtab
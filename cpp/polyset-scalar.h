@@ -0,0 +1,42 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "cell.h"
+#include "polyset.h"
+#include <Eigen/Dense>
+
+namespace libtab
+{
+namespace polyset
+{
+
+/// Table of values of scalar type T, of shape (rows, cols)
+template <typename T>
+using Table = Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+/// Values of the orthonormal polynomials on a reference cell at points
+/// with coordinates of scalar type T
+///
+/// This gives the same values as polyset::tabulate with nd = 0, using the
+/// same recurrences evaluated in the arithmetic of T. With points of dual
+/// numbers (see dual::variables), the derivatives of the values follow
+/// from the recurrences by forward-mode automatic differentiation, and
+/// nested dual numbers give higher derivatives.
+///
+/// The library instantiates this for T = double, DoubleDouble, Dual<N> and
+/// Dual<N, Dual<N>> with N = 1, 2, 3. The definition is in
+/// polyset-impl.h, which must be included to use other scalar types.
+///
+/// @param celltype Cell type
+/// @param degree Polynomial degree
+/// @param x Points, of shape (number of points, topological dimension)
+/// @return Table of shape (number of points, polyset::dim(celltype,
+/// degree))
+template <typename T>
+Table<T> tabulate_values(cell::type celltype, int degree, const Table<T>& x);
+
+} // namespace polyset
+} // namespace libtab
@@ -6,6 +6,8 @@
 
 #include "cell.h"
 #include <Eigen/Dense>
+#include <array>
+#include <functional>
 #include <vector>
 
 namespace libtab
@@ -19,6 +21,20 @@ namespace libtab
 /// triangle, tetrahedron, quadrilateral, hexahedron, prism and pyramids.
 namespace polyset
 {
+/// Coordinates in which points are given
+enum class coordinates
+{
+  /// Cartesian coordinates on the reference cell, with one column per
+  /// topological dimension
+  cartesian,
+
+  /// Barycentric coordinates (l0, l1, ..., ltdim) on a reference simplex
+  /// (interval, triangle or tetrahedron), with one column per vertex.
+  /// Vertex 0 is the origin and vertex i the i-th unit vector, so the
+  /// Cartesian coordinates are (l1, ..., ltdim).
+  barycentric
+};
+
 /// Basis and derivatives of orthonormal polynomials on reference cell at points
 ///
 /// Compute all derivatives up to given order.
@@ -29,11 +45,26 @@ namespace polyset
 /// derivatives, and in 3D, there are (nderiv + 1)(nderiv + 2)(nderiv + 3)/6.
 /// The ordering is 'triangular' with the lower derivatives appearing first.
 ///
+/// On simplices, the points may be given by their barycentric coordinates.
+/// The factors of the recurrences are then computed from these directly,
+/// without first converting them to reference Cartesian coordinates and
+/// mapping these to [-1, 1]. The derivatives are still with respect to the
+/// reference Cartesian coordinates.
+///
+/// On triangles, tetrahedra and pyramids, the derivatives of each order
+/// depend only on the lower orders, so the tables of one order can be
+/// computed concurrently. With nthreads > 1, these are run as tasks on
+/// libtab's thread pool, which gives parallelism even for a small number of
+/// points. The result does not depend on nthreads.
+///
 /// @param celltype Cell type
 /// @param degree Polynomial degree
 /// @param nd Maximum derivative order. Use nd = 0 for the basis only.
 /// @param x Points at which to evaluate the basis. The shape is (number
-/// of points, geometric dimension).
+/// of points, geometric dimension), or (number of points, number of
+/// vertices) for barycentric coordinates.
+/// @param nthreads Number of threads used to compute the derivative tables
+/// @param coords The coordinates in which the points are given
 /// @return List of polynomial sets, for each derivative, tabulated at
 /// points. The first index is the derivative. Higher derivatives are
 /// stored in triangular (2D) or tetrahedral (3D) ordering, i.e. for the
@@ -43,7 +74,97 @@ namespace polyset
 /// second index is the point, and the third index is the basis function
 /// index.
 std::vector<Eigen::ArrayXXd> tabulate(cell::type celltype, int degree, int nd,
-                                      const Eigen::ArrayXXd& x);
+                                      const Eigen::ArrayXXd& x,
+                                      int nthreads = 1,
+                                      coordinates coords
+                                      = coordinates::cartesian);
+
+/// Scratch storage of the polynomial set recurrences, for points of scalar
+/// type T (see polyset::tabulate_into). It is sized by the first
+/// tabulation (or by polyset::reserve) and reused by later tabulations at
+/// the same number of points, which then do not allocate.
+template <typename T>
+struct Workspace
+{
+  /// Factors of the recurrences which only depend on the points, one per
+  /// column
+  Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic> factors;
+
+  /// Tables of the interval (or, on prisms, triangle) factors of the
+  /// polynomial sets on tensor product cells, for each direction
+  std::array<std::vector<Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>>,
+             3>
+      tables;
+};
+
+/// Size a workspace for tabulating on a cell at a number of points, in
+/// Cartesian or barycentric coordinates
+/// @param workspace The workspace
+/// @param celltype Cell type
+/// @param degree Polynomial degree
+/// @param nd Maximum derivative order
+/// @param npoints Number of points
+void reserve(Workspace<double>& workspace, cell::type celltype, int degree,
+             int nd, int npoints);
+
+/// Basis and derivatives of orthonormal polynomials on reference cell at
+/// points, written into tables provided by the caller
+///
+/// This computes the same tables as polyset::tabulate. The tables are
+/// resized if needed, which does not allocate if they already have the
+/// right size, and the recurrences only use the workspace for scratch
+/// storage. Tabulating repeatedly at the same number of points into the
+/// same tables and workspace therefore does not allocate.
+///
+/// @param celltype Cell type
+/// @param degree Polynomial degree
+/// @param nd Maximum derivative order. Use nd = 0 for the basis only.
+/// @param x Points at which to evaluate the basis, see tabulate
+/// @param tables The tables for each derivative, see tabulate
+/// @param workspace Scratch storage of the recurrences
+/// @param nthreads Number of threads used to compute the derivative tables
+/// @param coords The coordinates in which the points are given
+void tabulate_into(cell::type celltype, int degree, int nd,
+                   const Eigen::Ref<const Eigen::ArrayXXd>& x,
+                   std::vector<Eigen::ArrayXXd>& tables,
+                   Workspace<double>& workspace, int nthreads = 1,
+                   coordinates coords = coordinates::cartesian);
+
+/// Streaming tabulation of the polynomial set, one derivative order at a time
+///
+/// The points are processed in blocks of block_size rows. For each block
+/// and each derivative order k = 0, ..., nd, consumer(k, offset, tables) is
+/// called, where offset is the row in x of the first point in the block and
+/// tables holds the derivatives of order k at the points of the block, in
+/// the same ordering and layout as returned by tabulate. The consumer may
+/// move the tables out. Orders are passed to the consumer in increasing
+/// order.
+///
+/// On tetrahedra and pyramids, the tables of order k are released as soon
+/// as the recurrence no longer reads them, i.e. once order k + 2 is
+/// complete. For nd >= 2 at most three consecutive orders are then live at
+/// once, so the peak storage is (3 nd^2 + 3 nd + 2)/2 tables of
+/// (block_size x dim(celltype, degree)) values, plus one table of scratch,
+/// independent of the total number of points. On other cells all
+/// (nd + 1)(nd + 2)/2 (2D) or (nd + 1)(nd + 2)(nd + 3)/6 (3D) tables of a
+/// block are computed before being passed on.
+///
+/// @param celltype Cell type
+/// @param degree Polynomial degree
+/// @param nd Maximum derivative order. Use nd = 0 for the basis only.
+/// @param x Points at which to evaluate the basis, see tabulate
+/// @param block_size Number of points tabulated at once
+/// @param consumer Function receiving the derivative order, the offset of
+/// the block and the tables of that order
+/// @param nthreads Number of threads used to compute the derivative tables
+/// of each order, see tabulate
+/// @param coords The coordinates in which the points are given
+void tabulate_by_order(
+    cell::type celltype, int degree, int nd, const Eigen::ArrayXXd& x,
+    int block_size,
+    const std::function<void(int, int, std::vector<Eigen::ArrayXXd>&)>&
+        consumer,
+    int nthreads = 1, coordinates coords = coordinates::cartesian);
 
 /// Dimension of a space
 /// @param[in] cellThe cell type
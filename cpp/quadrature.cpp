@@ -3,8 +3,12 @@
 // SPDX-License-Identifier:    MIT
 
 #include "quadrature.h"
+#include "double-double.h"
+#include "lru-cache.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <set>
 #include <vector>
 
 using namespace libtab;
@@ -12,6 +16,80 @@ using namespace libtab;
 namespace
 {
 //----------------------------------------------------------------------------
+// Values (row 0) and derivatives (rows 1 to nderiv) of the Jacobi
+// polynomial P_n^{a,0} at the points x, in the arithmetic of T. The
+// recurrence coefficients are rational, and are formed in T rather than
+// rounded to double.
+template <typename T>
+quadrature::Points<T> jacobi_deriv(double a, int n, int nderiv,
+                                   const quadrature::Weights<T>& x)
+{
+  std::vector<quadrature::Points<T>> J;
+  quadrature::Points<T> Jd(n + 1, x.rows());
+  for (int i = 0; i < nderiv + 1; ++i)
+  {
+    if (i == 0)
+      Jd.row(0).fill(T(1.0));
+    else
+      Jd.row(0).setZero();
+
+    if (n > 0)
+    {
+      if (i == 0)
+        Jd.row(1) = (x.transpose() * (a + 2.0) + a) * 0.5;
+      else if (i == 1)
+        Jd.row(1).fill(T(a * 0.5 + 1));
+      else
+        Jd.row(1).setZero();
+    }
+
+    for (int k = 2; k < n + 1; ++k)
+    {
+      const T a1(2 * k * (k + a) * (2 * k + a - 2));
+      const T a2 = T((2 * k + a - 1) * (a * a)) / a1;
+      const T a3 = T((2 * k + a - 1) * (2 * k + a)) / T(2 * k * (k + a));
+      const T a4 = T(2 * (k + a - 1) * (k - 1) * (2 * k + a)) / a1;
+      Jd.row(k)
+          = Jd.row(k - 1) * (x.transpose() * a3 + a2) - Jd.row(k - 2) * a4;
+      if (i > 0)
+        Jd.row(k) += J[i - 1].row(k - 1) * (a3 * double(i));
+    }
+
+    J.push_back(Jd);
+  }
+
+  quadrature::Points<T> result(nderiv + 1, x.rows());
+  for (int i = 0; i < nderiv + 1; ++i)
+    result.row(i) = J[i].row(n);
+
+  return result;
+}
+//----------------------------------------------------------------------------
+// Gauss-Jacobi rule with m points for the weight (1 - x)^a on [-1, 1], in
+// the arithmetic of T. The points found in double precision by
+// compute_gauss_jacobi_points are refined by Newton's method in T.
+template <typename T>
+std::pair<quadrature::Weights<T>, quadrature::Weights<T>>
+gauss_jacobi_rule(double a, int m)
+{
+  quadrature::Weights<T> pts
+      = quadrature::compute_gauss_jacobi_points(a, m).cast<T>();
+  for (int it = 0; it < 2; ++it)
+  {
+    const quadrature::Points<T> f = jacobi_deriv<T>(a, m, 1, pts);
+    pts -= (f.row(0) / f.row(1)).transpose();
+  }
+
+  const quadrature::Weights<T> f
+      = jacobi_deriv<T>(a, m, 1, pts).row(1).transpose();
+  const T a1(std::pow(2.0, a + 1.0));
+  quadrature::Weights<T> wts(m);
+  for (int i = 0; i < m; ++i)
+    wts[i] = a1 / (1.0 - pts[i] * pts[i]) / (f[i] * f[i]);
+
+  return {pts, wts};
+}
+//----------------------------------------------------------------------------
 std::tuple<Eigen::ArrayXd, Eigen::ArrayXd> rec_jacobi(int N, double a, double b)
 {
   // Generate the recursion coefficients alpha_k, beta_k
@@ -48,6 +126,13 @@ std::tuple<Eigen::ArrayXd, Eigen::ArrayXd> rec_jacobi(int N, double a, double b)
   beta.tail(N - 1) = 4 * (n + a) * (n + b) * n * (n + a + b)
                      / (nab * nab * (nab + 1.0) * (nab - 1.0));
 
+  // Cancel the factor (1 + a + b) in beta_1, which vanishes for a + b = -1
+  if (N > 1)
+  {
+    beta[1] = 4 * (1.0 + a) * (1.0 + b)
+              / ((2.0 + a + b) * (2.0 + a + b) * (3.0 + a + b));
+  }
+
   return {alpha, beta};
 }
 //----------------------------------------------------------------------------
@@ -122,51 +207,294 @@ std::tuple<Eigen::ArrayXd, Eigen::ArrayXd> lobatto(const Eigen::ArrayXd& alpha,
 
   return gauss(alpha_l, beta_l);
 }
-}; // namespace
-
-//-----------------------------------------------------------------------------
-Eigen::ArrayXXd quadrature::compute_jacobi_deriv(double a, int n, int nderiv,
-                                                 const Eigen::ArrayXd& x)
+//----------------------------------------------------------------------------
+std::tuple<Eigen::ArrayXd, Eigen::ArrayXd> radau(const Eigen::ArrayXd& alpha,
+                                                 const Eigen::ArrayXd& beta,
+                                                 double xl)
 {
-  std::vector<Eigen::ArrayXXd> J;
-  Eigen::ArrayXXd Jd(n + 1, x.rows());
-  for (int i = 0; i < nderiv + 1; ++i)
+  // Compute the Radau nodes and weights with the preassigned node xl
+  //
+  // Adapted from the MATLAB code by Walter Gautschi
+  // http://www.cs.purdue.edu/archives/2002/wxg/codes/radau.m
+
+  // Evaluate the monic orthogonal polynomials p_{n-2} and p_{n-1} at xl
+  const int n = alpha.rows();
+  double p0 = 0.0;
+  double p1 = 1.0;
+  for (int i = 0; i < n - 1; ++i)
   {
-    if (i == 0)
-      Jd.row(0).fill(1.0);
-    else
-      Jd.row(0).setZero();
+    const double pm1 = p0;
+    p0 = p1;
+    p1 = (xl - alpha(i)) * p0 - beta(i) * pm1;
+  }
 
-    if (n > 0)
+  // Modify the last recursion coefficient so that xl is a node
+  Eigen::ArrayXd alpha_r = alpha;
+  alpha_r(n - 1) = xl - beta(n - 1) * p0 / p1;
+
+  return gauss(alpha_r, beta);
+}
+//----------------------------------------------------------------------------
+// Rule on [-1, 1] for the weight (1 - x)^a (1 + x)^b
+std::pair<Eigen::ArrayXd, Eigen::ArrayXd>
+compute_line_rule(quadrature::type qtype, double a, double b, int m)
+{
+  if (m < 1)
+    throw std::runtime_error("Quadrature requires at least one point");
+  if (a <= -1.0 or b <= -1.0)
+    throw std::runtime_error("Jacobi weight exponents must be > -1");
+
+  auto [alpha, beta] = rec_jacobi(m, a, b);
+  Eigen::ArrayXd x, w;
+  switch (qtype)
+  {
+  case quadrature::type::gauss_jacobi:
+    std::tie(x, w) = gauss(alpha, beta);
+    break;
+  case quadrature::type::gauss_radau_left:
+    std::tie(x, w) = radau(alpha, beta, -1.0);
+    break;
+  case quadrature::type::gauss_radau_right:
+    std::tie(x, w) = radau(alpha, beta, 1.0);
+    break;
+  default:
+    throw std::runtime_error("Unknown quadrature type");
+  }
+  return {x, w};
+}
+//----------------------------------------------------------------------------
+// Tensor product of rules on [0, 1], with the first direction varying
+// fastest
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd> tensor_product(
+    const std::vector<std::pair<Eigen::ArrayXd, Eigen::ArrayXd>>& lines)
+{
+  int npts = 1;
+  for (const auto& line : lines)
+    npts *= line.first.rows();
+
+  Eigen::ArrayXXd pts(npts, lines.size());
+  Eigen::ArrayXd wts = Eigen::ArrayXd::Ones(npts);
+  int stride = 1;
+  for (std::size_t d = 0; d < lines.size(); ++d)
+  {
+    const auto& [x, w] = lines[d];
+    for (int c = 0; c < npts; ++c)
     {
-      if (i == 0)
-        Jd.row(1) = (x.transpose() * (a + 2.0) + a) * 0.5;
-      else if (i == 1)
-        Jd.row(1) = a * 0.5 + 1;
-      else
-        Jd.row(1).setZero();
+      const int i = (c / stride) % x.rows();
+      pts(c, d) = x[i];
+      wts[c] *= w[i];
     }
+    stride *= x.rows();
+  }
 
-    for (int k = 2; k < n + 1; ++k)
+  return {pts, wts};
+}
+//----------------------------------------------------------------------------
+// Collapsed (Duffy) rule on the reference triangle or tetrahedron. Each
+// direction uses a rule of type qtype with the Jacobi weight that absorbs
+// the Jacobian of the collapse.
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+collapsed(quadrature::type qtype, int tdim, int m)
+{
+  std::vector<std::pair<Eigen::ArrayXd, Eigen::ArrayXd>> lines;
+  for (int d = 0; d < tdim; ++d)
+    lines.push_back(compute_line_rule(qtype, d, 0.0, m));
+
+  // Map each point from [-1, 1]^tdim, where the last direction is the
+  // outermost collapse
+  auto [t, w] = tensor_product(lines);
+  Eigen::ArrayXXd pts(t.rows(), tdim);
+  for (int c = 0; c < t.rows(); ++c)
+  {
+    double scale = 1.0;
+    for (int d = tdim - 1; d >= 0; --d)
     {
-      const double a1 = 2 * k * (k + a) * (2 * k + a - 2);
-      const double a2 = (2 * k + a - 1) * (a * a) / a1;
-      const double a3 = (2 * k + a - 1) * (2 * k + a) / (2 * k * (k + a));
-      const double a4 = 2 * (k + a - 1) * (k - 1) * (2 * k + a) / a1;
-      Jd.row(k)
-          = Jd.row(k - 1) * (x.transpose() * a3 + a2) - Jd.row(k - 2) * a4;
-      if (i > 0)
-        Jd.row(k) += i * a3 * J[i - 1].row(k - 1);
+      pts(c, d) = scale * 0.5 * (1.0 + t(c, d));
+      scale *= 0.5 * (1.0 - t(c, d));
     }
+  }
 
-    J.push_back(Jd);
+  // Each direction d contributes 1/2 from the change of variables and
+  // (1/2)^d from the Jacobi weight
+  const double scale = std::pow(0.5, tdim * (tdim + 1) / 2);
+  return {pts, w * scale};
+}
+//----------------------------------------------------------------------------
+// Most recently used rules, keyed by everything which defines them
+using cache_key = std::tuple<cell::type, quadrature::type, int,
+                             std::vector<std::array<double, 2>>>;
+LRUCache<cache_key, std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>>
+    cache(quadrature::cache_capacity);
+//----------------------------------------------------------------------------
+// Points related to a generator by symmetry, all sharing one weight. On
+// [-1, 1]^d the orbit contains all sign changes of the generator (and its
+// permutations if permute is true). On the triangle the generator holds
+// barycentric coordinates and the orbit contains all their permutations.
+struct orbit
+{
+  std::vector<double> generator;
+  double weight;
+  bool permute = true;
+};
+//----------------------------------------------------------------------------
+// Symmetric rule and the polynomial degree it integrates exactly
+struct symmetric_rule
+{
+  int degree;
+  std::vector<orbit> orbits;
+};
+//----------------------------------------------------------------------------
+// Reduced rules on [-1, 1]^2 (weights sum to 4), from Stroud, "Approximate
+// calculation of multiple integrals" (1971), C2 5-1 (Radon) and C2 7-3
+const std::vector<symmetric_rule>& quadrilateral_rules()
+{
+  static const double r = std::sqrt(583.0);
+  static const std::vector<symmetric_rule> rules
+      = {{1, {{{0.0, 0.0}, 4.0}}},
+         {5,
+          {{{0.0, 0.0}, 8.0 / 7.0},
+           {{0.0, std::sqrt(14.0 / 15.0)}, 20.0 / 63.0, false},
+           {{std::sqrt(0.6), std::sqrt(1.0 / 3.0)}, 5.0 / 9.0, false}}},
+         {7,
+          {{{std::sqrt(6.0 / 7.0), 0.0}, 98.0 / 405.0},
+           {{std::sqrt((114.0 + 3.0 * r) / 287.0),
+             std::sqrt((114.0 + 3.0 * r) / 287.0)},
+            307.0 / 810.0 - 923.0 / (270.0 * r)},
+           {{std::sqrt((114.0 - 3.0 * r) / 287.0),
+             std::sqrt((114.0 - 3.0 * r) / 287.0)},
+            307.0 / 810.0 + 923.0 / (270.0 * r)}}}};
+  return rules;
+}
+//----------------------------------------------------------------------------
+// Reduced rules on [-1, 1]^3 (weights sum to 8). Degrees 3 and 5 are
+// Stroud C3 3-1 and C3 5-1. The degree 7 rule is the fully symmetric
+// 34-point rule with positive weights, computed by solving the moment
+// equations (there is no such rule with 27 points).
+const std::vector<symmetric_rule>& hexahedron_rules()
+{
+  static const std::vector<symmetric_rule> rules
+      = {{1, {{{0.0, 0.0, 0.0}, 8.0}}},
+         {3, {{{1.0, 0.0, 0.0}, 4.0 / 3.0}}},
+         {5,
+          {{{std::sqrt(19.0 / 30.0), 0.0, 0.0}, 320.0 / 361.0},
+           {{std::sqrt(19.0 / 33.0), std::sqrt(19.0 / 33.0),
+             std::sqrt(19.0 / 33.0)},
+            121.0 / 361.0}}},
+         {7,
+          {{{0.9395926580323618, 0.0, 0.0}, 0.27067190032092381},
+           {{0.9053504858616559, 0.9053504858616559, 0.0},
+            0.10761078129104214},
+           {{0.74703036041422777, 0.74703036041422777, 0.74703036041422777},
+            0.20119369348744906},
+           {{0.41025870996200059, 0.41025870996200059, 0.41025870996200059},
+            0.43438620933529476}}}};
+  return rules;
+}
+//----------------------------------------------------------------------------
+// Fully symmetric rules with positive weights and interior points on the
+// reference triangle (weights sum to 1/2). Degree 5 is Radon's rule, the
+// others were computed by solving the moment equations.
+const std::vector<symmetric_rule>& triangle_rules()
+{
+  static const double r = std::sqrt(15.0);
+  static const std::vector<symmetric_rule> rules = {
+      {1, {{{1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0}, 0.5}}},
+      {2, {{{2.0 / 3.0, 1.0 / 6.0, 1.0 / 6.0}, 1.0 / 6.0}}},
+      {4,
+       {{{0.4459484909159648, 0.4459484909159648, 0.1081030181680704},
+         0.11169079483900557},
+        {{0.09157621350977097, 0.09157621350977097, 0.8168475729804581},
+         0.054975871827661095}}},
+      {5,
+       {{{1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0}, 9.0 / 80.0},
+        {{(6.0 - r) / 21.0, (6.0 - r) / 21.0, (9.0 + 2.0 * r) / 21.0},
+         (155.0 - r) / 2400.0},
+        {{(6.0 + r) / 21.0, (6.0 + r) / 21.0, (9.0 - 2.0 * r) / 21.0},
+         (155.0 + r) / 2400.0}}},
+      {6,
+       {{{0.48013796411221665, 0.48013796411221665, 0.0397240717755667},
+         0.04036554479651411},
+        {{0.21942998254978255, 0.21942998254978255, 0.5611400349004349},
+         0.08566656207649248},
+        {{0.019371724361240517, 0.14161901592396722, 0.83900925971479226},
+         0.020317279896830055}}},
+      {7,
+       {{{0.4175623616084197, 0.4175623616084197, 0.1648752767831606},
+         0.06355656382879196},
+        {{0.05450804261090295, 0.05450804261090295, 0.8909839147781941},
+         0.019111028988438642},
+        {{0.16325475158420277, 0.16325475158420277, 0.67349049683159446},
+         0.0391341761267326},
+        {{0.3125491511587342, 0.021154108178197815, 0.66629674066306798},
+         0.022432448861351716}}}};
+  return rules;
+}
+//----------------------------------------------------------------------------
+// Expand the orbits of a rule into points and weights. Rules on [-1, 1]^d
+// are mapped to [0, 1]^d.
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd> expand(bool simplex,
+                                                  const symmetric_rule& rule)
+{
+  std::vector<std::vector<double>> pts;
+  std::vector<double> wts;
+  for (const orbit& o : rule.orbits)
+  {
+    std::set<std::vector<double>> points;
+    std::vector<double> p = o.generator;
+    if (o.permute)
+      std::sort(p.begin(), p.end());
+    do
+    {
+      if (simplex)
+        points.insert({p[1], p[2]});
+      else
+      {
+        // Apply every combination of signs
+        for (int signs = 0; signs < (1 << p.size()); ++signs)
+        {
+          std::vector<double> q = p;
+          for (std::size_t i = 0; i < q.size(); ++i)
+            if (signs & (1 << i))
+              q[i] = -q[i];
+          points.insert(q);
+        }
+      }
+    } while (o.permute and std::next_permutation(p.begin(), p.end()));
+
+    pts.insert(pts.end(), points.begin(), points.end());
+    wts.insert(wts.end(), points.size(), o.weight);
   }
 
-  Eigen::ArrayXXd result(nderiv + 1, x.rows());
-  for (int i = 0; i < nderiv + 1; ++i)
-    result.row(i) = J[i].row(n);
+  const int tdim = pts[0].size();
+  Eigen::ArrayXXd x(pts.size(), tdim);
+  Eigen::ArrayXd w = Eigen::Map<Eigen::ArrayXd>(wts.data(), wts.size());
+  for (std::size_t i = 0; i < pts.size(); ++i)
+    for (int j = 0; j < tdim; ++j)
+      x(i, j) = simplex ? pts[i][j] : 0.5 * (pts[i][j] + 1.0);
+  if (!simplex)
+    w *= std::pow(0.5, tdim);
 
-  return result;
+  return {x, w};
+}
+//----------------------------------------------------------------------------
+// Lowest-degree rule in a catalogue that is exact for the given degree, or
+// nullptr if there is none
+const symmetric_rule* find_rule(const std::vector<symmetric_rule>& rules,
+                                int degree)
+{
+  for (const symmetric_rule& rule : rules)
+    if (rule.degree >= degree)
+      return &rule;
+  return nullptr;
+}
+//----------------------------------------------------------------------------
+}; // namespace
+
+//-----------------------------------------------------------------------------
+Eigen::ArrayXXd quadrature::compute_jacobi_deriv(double a, int n, int nderiv,
+                                                 const Eigen::ArrayXd& x)
+{
+  return jacobi_deriv<double>(a, n, nderiv, x);
 }
 //-----------------------------------------------------------------------------
 Eigen::ArrayXd quadrature::compute_gauss_jacobi_points(double a, int m)
@@ -193,7 +521,7 @@ Eigen::ArrayXd quadrature::compute_gauss_jacobi_points(double a, int m)
       for (int i = 0; i < k; ++i)
         s += 1.0 / (x[k] - x[i]);
       const Eigen::ArrayXd f
-          = quadrature::compute_jacobi_deriv(a, m, 1, x.row(k));
+          = jacobi_deriv<double>(a, m, 1, x.row(k));
       const double delta = f[0] / (f[1] - f[0] * s);
       x[k] -= delta;
 
@@ -210,99 +538,45 @@ std::pair<Eigen::ArrayXd, Eigen::ArrayXd>
 quadrature::compute_gauss_jacobi_rule(double a, int m)
 {
   /// @note Computes on [-1, 1]
-  const Eigen::ArrayXd pts = quadrature::compute_gauss_jacobi_points(a, m);
-  const Eigen::ArrayXd Jd
-      = quadrature::compute_jacobi_deriv(a, m, 1, pts).row(1);
-
-  const double a1 = pow(2.0, a + 1.0);
-  const double a3 = tgamma(m + 1.0);
-  // factorial(m)
-  double a5 = 1.0;
-  for (int i = 0; i < m; ++i)
-    a5 *= (i + 1);
-  const double a6 = a1 * a3 / a5;
-
-  Eigen::ArrayXd wts(m);
-  for (int i = 0; i < m; ++i)
-  {
-    const double x = pts[i];
-    const double f = Jd[i];
-    wts[i] = a6 / (1.0 - x * x) / (f * f);
-  }
-
-  return {pts, wts};
+  return gauss_jacobi_rule<double>(a, m);
 }
 //-----------------------------------------------------------------------------
 std::pair<Eigen::ArrayXd, Eigen::ArrayXd>
 quadrature::make_quadrature_line(int m)
 {
-  auto [ptx, wx] = quadrature::compute_gauss_jacobi_rule(0.0, m);
-  return {0.5 * (ptx + 1.0), wx * 0.5};
+  auto [pts, wts] = quadrature::make_quadrature(cell::type::interval, m);
+  return {pts.col(0), wts};
 }
 //-----------------------------------------------------------------------------
 std::pair<Eigen::ArrayX2d, Eigen::ArrayXd>
 quadrature::make_quadrature_triangle_collapsed(int m)
 {
-  auto [ptx, wx] = quadrature::compute_gauss_jacobi_rule(0.0, m);
-  auto [pty, wy] = quadrature::compute_gauss_jacobi_rule(1.0, m);
-
-  Eigen::ArrayX2d pts(m * m, 2);
-  Eigen::ArrayXd wts(m * m);
-  int c = 0;
-  for (int i = 0; i < m; ++i)
-  {
-    for (int j = 0; j < m; ++j)
-    {
-      pts(c, 0) = 0.25 * (1.0 + ptx[i]) * (1.0 - pty[j]);
-      pts(c, 1) = 0.5 * (1.0 + pty[j]);
-      wts[c] = wx[i] * wy[j] * 0.125;
-      ++c;
-    }
-  }
-
-  return {pts, wts};
+  return quadrature::make_quadrature(cell::type::triangle, m);
 }
 //-----------------------------------------------------------------------------
 std::pair<Eigen::ArrayX3d, Eigen::ArrayXd>
 quadrature::make_quadrature_tetrahedron_collapsed(int m)
 {
-  auto [ptx, wx] = quadrature::compute_gauss_jacobi_rule(0.0, m);
-  auto [pty, wy] = quadrature::compute_gauss_jacobi_rule(1.0, m);
-  auto [ptz, wz] = quadrature::compute_gauss_jacobi_rule(2.0, m);
-
-  Eigen::ArrayX3d pts(m * m * m, 3);
-  Eigen::ArrayXd wts(m * m * m);
-  int c = 0;
-  for (int i = 0; i < m; ++i)
-  {
-    for (int j = 0; j < m; ++j)
-    {
-      for (int k = 0; k < m; ++k)
-      {
-        pts(c, 0) = 0.125 * (1.0 + ptx[i]) * (1.0 - pty[j]) * (1.0 - ptz[k]);
-        pts(c, 1) = 0.25 * (1. + pty[j]) * (1. - ptz[k]);
-        pts(c, 2) = 0.5 * (1.0 + ptz[k]);
-        wts[c] = wx[i] * wy[j] * wz[k] * 0.125 * 0.125;
-        ++c;
-      }
-    }
-  }
-
-  return {pts, wts};
+  return quadrature::make_quadrature(cell::type::tetrahedron, m);
 }
 //-----------------------------------------------------------------------------
-std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+template <typename T>
+std::pair<quadrature::Points<T>, quadrature::Weights<T>>
 quadrature::make_quadrature(cell::type celltype, int m)
 {
   switch (celltype)
   {
   case cell::type::interval:
-    return quadrature::make_quadrature_line(m);
+  {
+    auto [ptx, wx] = gauss_jacobi_rule<T>(0.0, m);
+    return {Points<T>(0.5 * (ptx + 1.0)), wx * 0.5};
+  }
   case cell::type::quadrilateral:
   {
-    auto [QptsL, QwtsL] = quadrature::make_quadrature_line(m);
-    Eigen::ArrayX2d Qpts(m * m, 2);
-    Eigen::ArrayXd Qwts(m * m);
+    auto [QptsL, QwtsL]
+        = quadrature::make_quadrature<T>(cell::type::interval, m);
+    Points<T> Qpts(m * m, 2);
+    Weights<T> Qwts(m * m);
     int c = 0;
     for (int j = 0; j < m; ++j)
     {
@@ -317,9 +591,10 @@ quadrature::make_quadrature(cell::type celltype, int m)
   }
   case cell::type::hexahedron:
   {
-    auto [QptsL, QwtsL] = quadrature::make_quadrature_line(m);
-    Eigen::ArrayX3d Qpts(m * m * m, 3);
-    Eigen::ArrayXd Qwts(m * m * m);
+    auto [QptsL, QwtsL]
+        = quadrature::make_quadrature<T>(cell::type::interval, m);
+    Points<T> Qpts(m * m * m, 3);
+    Weights<T> Qwts(m * m * m);
     int c = 0;
     for (int k = 0; k < m; ++k)
     {
@@ -337,10 +612,12 @@ quadrature::make_quadrature(cell::type celltype, int m)
   }
   case cell::type::prism:
   {
-    auto [QptsL, QwtsL] = quadrature::make_quadrature_line(m);
-    auto [QptsT, QwtsT] = quadrature::make_quadrature_triangle_collapsed(m);
-    Eigen::ArrayX3d Qpts(m * QptsT.rows(), 3);
-    Eigen::ArrayXd Qwts(m * QptsT.rows());
+    auto [QptsL, QwtsL]
+        = quadrature::make_quadrature<T>(cell::type::interval, m);
+    auto [QptsT, QwtsT]
+        = quadrature::make_quadrature<T>(cell::type::triangle, m);
+    Points<T> Qpts(m * QptsT.rows(), 3);
+    Weights<T> Qwts(m * QptsT.rows());
     int c = 0;
     for (int k = 0; k < m; ++k)
     {
@@ -356,13 +633,61 @@ quadrature::make_quadrature(cell::type celltype, int m)
   case cell::type::pyramid:
     throw std::runtime_error("Pyramid not yet supported");
   case cell::type::triangle:
-    return quadrature::make_quadrature_triangle_collapsed(m);
+  {
+    auto [ptx, wx] = gauss_jacobi_rule<T>(0.0, m);
+    auto [pty, wy] = gauss_jacobi_rule<T>(1.0, m);
+
+    Points<T> pts(m * m, 2);
+    Weights<T> wts(m * m);
+    int c = 0;
+    for (int i = 0; i < m; ++i)
+    {
+      for (int j = 0; j < m; ++j)
+      {
+        pts(c, 0) = 0.25 * (1.0 + ptx[i]) * (1.0 - pty[j]);
+        pts(c, 1) = 0.5 * (1.0 + pty[j]);
+        wts[c] = wx[i] * wy[j] * 0.125;
+        ++c;
+      }
+    }
+    return {pts, wts};
+  }
   case cell::type::tetrahedron:
-    return quadrature::make_quadrature_tetrahedron_collapsed(m);
+  {
+    auto [ptx, wx] = gauss_jacobi_rule<T>(0.0, m);
+    auto [pty, wy] = gauss_jacobi_rule<T>(1.0, m);
+    auto [ptz, wz] = gauss_jacobi_rule<T>(2.0, m);
+
+    Points<T> pts(m * m * m, 3);
+    Weights<T> wts(m * m * m);
+    int c = 0;
+    for (int i = 0; i < m; ++i)
+    {
+      for (int j = 0; j < m; ++j)
+      {
+        for (int k = 0; k < m; ++k)
+        {
+          pts(c, 0)
+              = 0.125 * (1.0 + ptx[i]) * (1.0 - pty[j]) * (1.0 - ptz[k]);
+          pts(c, 1) = 0.25 * (1. + pty[j]) * (1. - ptz[k]);
+          pts(c, 2) = 0.5 * (1.0 + ptz[k]);
+          wts[c] = wx[i] * wy[j] * wz[k] * 0.125 * 0.125;
+          ++c;
+        }
+      }
+    }
+    return {pts, wts};
+  }
   default:
     throw std::runtime_error("Unsupported celltype for make_quadrature");
   }
 }
+//-----------------------------------------------------------------------------
+template std::pair<quadrature::Points<double>, quadrature::Weights<double>>
+quadrature::make_quadrature(cell::type, int);
+template std::pair<quadrature::Points<DoubleDouble>,
+                   quadrature::Weights<DoubleDouble>>
+quadrature::make_quadrature(cell::type, int);
 //----------------------------------------------------------------------------
 std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
 quadrature::make_quadrature(const Eigen::ArrayXXd& simplex, int m)
@@ -443,3 +768,149 @@ quadrature::gauss_lobatto_legendre_line_rule(int m)
   return {xs_ref, ws_ref};
 }
 //-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXd, Eigen::ArrayXd>
+quadrature::compute_gauss_jacobi_rule(double a, double b, int m)
+{
+  return compute_line_rule(quadrature::type::gauss_jacobi, a, b, m);
+}
+//-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXd, Eigen::ArrayXd>
+quadrature::compute_gauss_radau_rule(double a, double b, int m, bool left)
+{
+  return compute_line_rule(left ? quadrature::type::gauss_radau_left
+                                : quadrature::type::gauss_radau_right,
+                           a, b, m);
+}
+//-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+quadrature::make_quadrature(cell::type celltype, quadrature::type qtype, int m,
+                            const std::vector<std::array<double, 2>>& weights)
+{
+  const cache_key key = {celltype, qtype, m, weights};
+  if (auto rule = cache.find(key))
+    return *rule;
+
+  const int tdim = cell::topological_dimension(celltype);
+  if (!weights.empty() and static_cast<int>(weights.size()) != tdim)
+    throw std::runtime_error("Need one pair of weight exponents per direction");
+
+  std::pair<Eigen::ArrayXXd, Eigen::ArrayXd> rule;
+  switch (celltype)
+  {
+  case cell::type::interval:
+  case cell::type::quadrilateral:
+  case cell::type::hexahedron:
+  {
+    // Map each direction to [0, 1], where the weight is (1 - x)^a x^b
+    std::vector<std::pair<Eigen::ArrayXd, Eigen::ArrayXd>> lines;
+    for (int d = 0; d < tdim; ++d)
+    {
+      const auto [a, b] = weights.empty() ? std::array<double, 2>{0.0, 0.0}
+                                          : weights[d];
+      auto [x, w] = compute_line_rule(qtype, a, b, m);
+      lines.emplace_back(0.5 * (x + 1.0), w * std::pow(0.5, a + b + 1.0));
+    }
+    rule = tensor_product(lines);
+    break;
+  }
+  case cell::type::triangle:
+  case cell::type::tetrahedron:
+  case cell::type::prism:
+  {
+    if (!weights.empty())
+    {
+      throw std::runtime_error("Weighted rules are only supported on "
+                               "interval, quadrilateral and hexahedron");
+    }
+    if (celltype != cell::type::prism)
+    {
+      rule = collapsed(qtype, tdim, m);
+      break;
+    }
+    auto [ptsT, wtsT] = collapsed(qtype, 2, m);
+    auto [x, w] = compute_line_rule(qtype, 0.0, 0.0, m);
+    rule.first.resize(m * ptsT.rows(), 3);
+    rule.second.resize(m * ptsT.rows());
+    int c = 0;
+    for (int k = 0; k < m; ++k)
+    {
+      for (int i = 0; i < ptsT.rows(); ++i)
+      {
+        rule.first.row(c) << ptsT(i, 0), ptsT(i, 1), 0.5 * (1.0 + x[k]);
+        rule.second[c] = wtsT[i] * w[k] * 0.5;
+        ++c;
+      }
+    }
+    break;
+  }
+  default:
+    throw std::runtime_error("Unsupported celltype for make_quadrature");
+  }
+
+  return cache.insert(key, rule);
+}
+//-----------------------------------------------------------------------------
+void quadrature::clear_cache() { cache.clear(); }
+//-----------------------------------------------------------------------------
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+quadrature::make_reduced_quadrature(cell::type celltype, int degree)
+{
+  if (degree < 0)
+    throw std::runtime_error("Invalid degree");
+
+  // Default to the Gauss-Jacobi rule that is exact for the degree
+  std::pair<Eigen::ArrayXXd, Eigen::ArrayXd> rule
+      = quadrature::make_quadrature(celltype, degree / 2 + 1);
+
+  const symmetric_rule* reduced = nullptr;
+  switch (celltype)
+  {
+  case cell::type::quadrilateral:
+    reduced = find_rule(quadrilateral_rules(), degree);
+    break;
+  case cell::type::hexahedron:
+    reduced = find_rule(hexahedron_rules(), degree);
+    break;
+  case cell::type::triangle:
+    reduced = find_rule(triangle_rules(), degree);
+    break;
+  case cell::type::prism:
+  {
+    // Symmetric triangle rule times a Gauss line rule
+    const symmetric_rule* tri = find_rule(triangle_rules(), degree);
+    if (!tri)
+      break;
+    auto [ptsT, wtsT] = expand(true, *tri);
+    auto [ptsL, wtsL] = quadrature::make_quadrature_line(degree / 2 + 1);
+    if (ptsT.rows() * ptsL.rows() >= rule.first.rows())
+      break;
+    rule.first.resize(ptsT.rows() * ptsL.rows(), 3);
+    rule.second.resize(ptsT.rows() * ptsL.rows());
+    int c = 0;
+    for (int k = 0; k < ptsL.rows(); ++k)
+    {
+      for (int i = 0; i < ptsT.rows(); ++i)
+      {
+        rule.first.row(c) << ptsT(i, 0), ptsT(i, 1), ptsL(k, 0);
+        rule.second[c] = wtsT[i] * wtsL[k];
+        ++c;
+      }
+    }
+    return rule;
+  }
+  default:
+    break;
+  }
+
+  // Use the reduced rule only when it has fewer points
+  if (reduced)
+  {
+    std::pair<Eigen::ArrayXXd, Eigen::ArrayXd> r
+        = expand(celltype == cell::type::triangle, *reduced);
+    if (r.first.rows() < rule.first.rows())
+      return r;
+  }
+
+  return rule;
+}
+//-----------------------------------------------------------------------------
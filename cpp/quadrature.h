@@ -6,7 +6,10 @@
 
 #include "cell.h"
 #include <Eigen/Dense>
+#include <array>
+#include <cstddef>
 #include <utility>
+#include <vector>
 
 /// libtab
 
@@ -17,6 +20,23 @@ namespace libtab
 /// @todo - pyramid
 namespace quadrature
 {
+/// Points of a quadrature rule in the arithmetic of T, of shape (number of
+/// points, dimension)
+template <typename T>
+using Points = Eigen::Array<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+/// Weights of a quadrature rule in the arithmetic of T
+template <typename T>
+using Weights = Eigen::Array<T, Eigen::Dynamic, 1>;
+
+/// Type of one-dimensional rule used in each direction
+enum class type
+{
+  gauss_jacobi,
+  gauss_radau_left,
+  gauss_radau_right
+};
+
 /// Evaluate the nth Jacobi polynomial and derivatives with weight parameters
 /// (a, 0) at points x
 /// @param a Jacobi weight a
@@ -39,6 +59,25 @@ Eigen::ArrayXd compute_gauss_jacobi_points(double a, int m);
 std::pair<Eigen::ArrayXd, Eigen::ArrayXd> compute_gauss_jacobi_rule(double a,
                                                                     int m);
 
+/// Gauss-Jacobi quadrature rule for the weight \f$(1-x)^a(1+x)^b\f$ on
+/// [-1, 1], computed from the eigenvalues of the Jacobi matrix
+/// @param a Jacobi weight a (> -1)
+/// @param b Jacobi weight b (> -1)
+/// @param m Number of points (exact to degree 2m - 1)
+/// @return Array of points, array of weights
+std::pair<Eigen::ArrayXd, Eigen::ArrayXd>
+compute_gauss_jacobi_rule(double a, double b, int m);
+
+/// Gauss-Radau quadrature rule for the weight \f$(1-x)^a(1+x)^b\f$ on
+/// [-1, 1], which includes one endpoint
+/// @param a Jacobi weight a (> -1)
+/// @param b Jacobi weight b (> -1)
+/// @param m Number of points (exact to degree 2m - 2)
+/// @param left If true the rule includes -1, otherwise 1
+/// @return Array of points, array of weights
+std::pair<Eigen::ArrayXd, Eigen::ArrayXd>
+compute_gauss_radau_rule(double a, double b, int m, bool left);
+
 /// Compute line quadrature rule on [0, 1]
 /// @param m order
 /// @returns list of 1D points, list of weights
@@ -57,11 +96,49 @@ std::pair<Eigen::ArrayX3d, Eigen::ArrayXd>
 make_quadrature_tetrahedron_collapsed(int m);
 
 /// Utility for quadrature rule on reference cell
+///
+/// The points and weights are computed in the arithmetic of T, which is
+/// double or DoubleDouble. The Gauss-Jacobi points are found in double
+/// precision and refined by Newton's method in T.
+///
 /// @param celltype
 /// @param m order
 /// @returns list of points, list of weights
-std::pair<Eigen::ArrayXXd, Eigen::ArrayXd> make_quadrature(cell::type celltype,
-                                                           int m);
+template <typename T = double>
+std::pair<Points<T>, Weights<T>> make_quadrature(cell::type celltype, int m);
+
+/// Quadrature rule on a reference cell built from one-dimensional rules
+/// of the given type. Interval, quadrilateral and hexahedron use a tensor
+/// product, and each direction may carry a weight \f$(1-x)^a x^b\f$.
+/// Triangle and tetrahedron use a collapsed (Duffy) product, and prism the
+/// product of the two. The cache_capacity most recently used rules are
+/// cached.
+/// @param celltype Cell type
+/// @param qtype Type of one-dimensional rule
+/// @param m Number of points in each direction
+/// @param weights Exponents (a, b) for each direction, or empty for an
+/// unweighted rule
+/// @returns list of points, list of weights
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+make_quadrature(cell::type celltype, type qtype, int m,
+                const std::vector<std::array<double, 2>>& weights = {});
+
+/// Quadrature rule on a reference cell with the fewest points that is
+/// exact for polynomials of the given degree. Quadrilateral, hexahedron,
+/// triangle and prism use a catalogue of symmetric rules with positive
+/// weights (the prism as a triangle rule times a Gauss line rule) when it
+/// has fewer points than the Gauss-Jacobi product rule.
+/// @param celltype Cell type
+/// @param degree Polynomial degree to integrate exactly
+/// @returns list of points, list of weights
+std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>
+make_reduced_quadrature(cell::type celltype, int degree);
+
+/// Maximum number of rules cached by make_quadrature
+constexpr std::size_t cache_capacity = 256;
+
+/// Discard all cached quadrature rules
+void clear_cache();
 
 /// Scaled quadrature rule on arbitrary simplices
 /// @param simplex Set of vertices describing simplex
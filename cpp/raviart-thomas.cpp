@@ -4,8 +4,10 @@
 
 #include "raviart-thomas.h"
 #include "dof-permutations.h"
+#include "double-double.h"
 #include "lagrange.h"
 #include "moments.h"
+#include "polyset-scalar.h"
 #include "polyset.h"
 #include "quadrature.h"
 #include <Eigen/Dense>
@@ -15,85 +17,22 @@
 using namespace libtab;
 
 //----------------------------------------------------------------------------
-FiniteElement libtab::create_rt(cell::type celltype, int degree,
-                                const std::string& name)
+DofLayout libtab::rt_layout(cell::type celltype, int degree)
 {
   if (celltype != cell::type::triangle and celltype != cell::type::tetrahedron)
     throw std::runtime_error("Unsupported cell type");
 
   const int tdim = cell::topological_dimension(celltype);
-
   const cell::type facettype
       = (tdim == 2) ? cell::type::interval : cell::type::triangle;
-
-  // The number of order (degree-1) scalar polynomials
-  const int nv = polyset::dim(celltype, degree - 1);
-  // The number of order (degree-2) scalar polynomials
   const int ns0 = polyset::dim(celltype, degree - 2);
-  // The number of additional polnomials in the polynomial basis for
-  // Raviart-Thomas
   const int ns = polyset::dim(facettype, degree - 1);
-
-  // Evaluate the expansion polynomials at the quadrature points
-  auto [Qpts, Qwts] = quadrature::make_quadrature(celltype, 2 * degree);
-  Eigen::ArrayXXd Pkp1_at_Qpts
-      = polyset::tabulate(celltype, degree, 0, Qpts)[0];
-
-  // The number of order (degree) polynomials
-  const int psize = Pkp1_at_Qpts.cols();
-
-  // Create coefficients for order (degree-1) vector polynomials
-  Eigen::MatrixXd wcoeffs = Eigen::MatrixXd::Zero(nv * tdim + ns, psize * tdim);
-  for (int j = 0; j < tdim; ++j)
-  {
-    wcoeffs.block(nv * j, psize * j, nv, nv)
-        = Eigen::MatrixXd::Identity(nv, nv);
-  }
-
-  // Create coefficients for additional polynomials in Raviart-Thomas
-  // polynomial basis
-  for (int i = 0; i < ns; ++i)
-  {
-    for (int k = 0; k < psize; ++k)
-    {
-      for (int j = 0; j < tdim; ++j)
-      {
-        const double w_sum = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(j)
-                              * Pkp1_at_Qpts.col(k))
-                                 .sum();
-        wcoeffs(nv * tdim + i, k + psize * j) = w_sum;
-      }
-    }
-  }
-
-  // Dual space
-  Eigen::MatrixXd dual = Eigen::MatrixXd::Zero(nv * tdim + ns, psize * tdim);
-
-  // quadrature degree
-  int quad_deg = 5 * degree;
-
-  // Add rows to dualmat for integral moments on facets
   const int facet_count = tdim + 1;
-  const int facet_dofs = ns;
-  dual.block(0, 0, facet_count * facet_dofs, psize * tdim)
-      = moments::make_normal_integral_moments(
-          create_dlagrange(facettype, degree - 1), celltype, tdim, degree,
-          quad_deg);
-
-  // Add rows to dualmat for integral moments on interior
-  if (degree > 1)
-  {
-    const int internal_dofs = tdim * ns0;
-    // Interior integral moment
-    dual.block(facet_count * facet_dofs, 0, internal_dofs, psize * tdim)
-        = moments::make_integral_moments(create_dlagrange(celltype, degree - 2),
-                                         celltype, tdim, degree, quad_deg);
-  }
+  const int ndofs = facet_count * ns + tdim * ns0;
 
   const std::vector<std::vector<std::vector<int>>> topology
       = cell::topology(celltype);
 
-  const int ndofs = dual.rows();
   int perm_count = 0;
   for (int i = 1; i < tdim; ++i)
     perm_count += topology[i].size() * i;
@@ -138,8 +77,133 @@ FiniteElement libtab::create_rt(cell::type celltype, int degree,
   entity_dofs[tdim - 1].resize(topology[tdim - 1].size(), ns);
   entity_dofs[tdim] = {ns0 * tdim};
 
-  Eigen::MatrixXd coeffs = compute_expansion_coefficients(wcoeffs, dual);
-  return FiniteElement(name, celltype, degree, {tdim}, coeffs, entity_dofs,
-                       base_permutations);
+  return {{tdim}, entity_dofs, base_permutations, Eigen::ArrayXXd()};
+}
+//----------------------------------------------------------------------------
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+libtab::rt_space(cell::type celltype, int degree)
+{
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+  if (celltype != cell::type::triangle and celltype != cell::type::tetrahedron)
+    throw std::runtime_error("Unsupported cell type");
+
+  const int tdim = cell::topological_dimension(celltype);
+
+  const cell::type facettype
+      = (tdim == 2) ? cell::type::interval : cell::type::triangle;
+
+  // The number of order (degree-1) scalar polynomials
+  const int nv = polyset::dim(celltype, degree - 1);
+  // The number of order (degree-2) scalar polynomials
+  const int ns0 = polyset::dim(celltype, degree - 2);
+  // The number of additional polnomials in the polynomial basis for
+  // Raviart-Thomas
+  const int ns = polyset::dim(facettype, degree - 1);
+
+  // Evaluate the expansion polynomials at the quadrature points. The
+  // integrands have degree 2 * degree + 1, so degree + 1 points in each
+  // direction integrate them exactly.
+  auto [Qpts, Qwts] = quadrature::make_quadrature<T>(celltype, degree + 1);
+  const polyset::Table<T> Pkp1_at_Qpts
+      = polyset::tabulate_values(celltype, degree, Qpts);
+
+  // The number of order (degree) polynomials
+  const int psize = Pkp1_at_Qpts.cols();
+
+  // Create coefficients for order (degree-1) vector polynomials
+  Matrix wcoeffs = Matrix::Zero(nv * tdim + ns, psize * tdim);
+  for (int j = 0; j < tdim; ++j)
+    wcoeffs.block(nv * j, psize * j, nv, nv) = Matrix::Identity(nv, nv);
+
+  // Create coefficients for additional polynomials in Raviart-Thomas
+  // polynomial basis
+  for (int i = 0; i < ns; ++i)
+  {
+    for (int k = 0; k < psize; ++k)
+    {
+      for (int j = 0; j < tdim; ++j)
+      {
+        const T w_sum = (Qwts * Pkp1_at_Qpts.col(ns0 + i) * Qpts.col(j)
+                         * Pkp1_at_Qpts.col(k))
+                            .sum();
+        wcoeffs(nv * tdim + i, k + psize * j) = w_sum;
+      }
+    }
+  }
+
+  return wcoeffs;
 }
+//----------------------------------------------------------------------------
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>
+libtab::rt_dual(cell::type celltype, int degree)
+{
+  using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+
+  if (celltype != cell::type::triangle and celltype != cell::type::tetrahedron)
+    throw std::runtime_error("Unsupported cell type");
+
+  const int tdim = cell::topological_dimension(celltype);
+
+  const cell::type facettype
+      = (tdim == 2) ? cell::type::interval : cell::type::triangle;
+
+  // The number of order (degree-1) scalar polynomials
+  const int nv = polyset::dim(celltype, degree - 1);
+  // The number of order (degree-2) scalar polynomials
+  const int ns0 = polyset::dim(celltype, degree - 2);
+  // The number of additional polnomials in the polynomial basis for
+  // Raviart-Thomas
+  const int ns = polyset::dim(facettype, degree - 1);
+  // The number of order (degree) polynomials
+  const int psize = polyset::dim(celltype, degree);
+
+  // Dual space
+  Matrix dual = Matrix::Zero(nv * tdim + ns, psize * tdim);
+
+  // quadrature degree, exact for the integrands of degree at most
+  // 2 * degree - 1
+  const int quad_deg = degree + 1;
+
+  // Add rows to dualmat for integral moments on facets
+  const int facet_count = tdim + 1;
+  const int facet_dofs = ns;
+  dual.block(0, 0, facet_count * facet_dofs, psize * tdim)
+      = moments::make_normal_integral_moments(
+          dlagrange_space<T>(facettype, degree - 1), celltype, tdim, degree,
+          quad_deg);
+
+  // Add rows to dualmat for integral moments on interior
+  if (degree > 1)
+  {
+    const int internal_dofs = tdim * ns0;
+    // Interior integral moment
+    dual.block(facet_count * facet_dofs, 0, internal_dofs, psize * tdim)
+        = moments::make_integral_moments(
+            dlagrange_space<T>(celltype, degree - 2), celltype, tdim, degree,
+            quad_deg);
+  }
+
+  return dual;
+}
+//----------------------------------------------------------------------------
+FiniteElement libtab::create_rt(cell::type celltype, int degree,
+                                const std::string& name)
+{
+  const DofLayout layout = rt_layout(celltype, degree);
+
+  const Eigen::MatrixXd coeffs = compute_expansion_coefficients(
+      rt_space<double>(celltype, degree), rt_dual<double>(celltype, degree));
+  return FiniteElement(name, celltype, degree, layout.value_shape, coeffs,
+                       layout.entity_dofs, layout.base_permutations);
+}
+//-----------------------------------------------------------------------------
+template Eigen::MatrixXd libtab::rt_space<double>(cell::type, int);
+template Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>
+libtab::rt_space<DoubleDouble>(cell::type, int);
+template Eigen::MatrixXd libtab::rt_dual<double>(cell::type, int);
+template Eigen::Matrix<DoubleDouble, Eigen::Dynamic, Eigen::Dynamic>
+libtab::rt_dual<DoubleDouble>(cell::type, int);
 //-----------------------------------------------------------------------------
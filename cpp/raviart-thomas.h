@@ -9,6 +9,28 @@
 
 namespace libtab
 {
+/// Dofs of the Raviart-Thomas element, without computing its expansion
+/// coefficients
+/// @param celltype
+/// @param degree
+DofLayout rt_layout(cell::type celltype, int degree);
+
+/// Expansion coefficients of the polynomial span of the Raviart-Thomas
+/// element, in the arithmetic of T (double or DoubleDouble)
+/// @param celltype
+/// @param degree
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> rt_space(cell::type celltype,
+                                                          int degree);
+
+/// Dual matrix of the Raviart-Thomas element, in the arithmetic of T
+/// (double or DoubleDouble)
+/// @param celltype
+/// @param degree
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> rt_dual(cell::type celltype,
+                                                         int degree);
+
 /// Create Raviart-Thomas element
 /// @param celltype
 /// @param degree
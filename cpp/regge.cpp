@@ -5,6 +5,7 @@
 #include "regge.h"
 #include "lattice.h"
 #include "polyset.h"
+#include "symmetric-tensor.h"
 #include <iostream>
 
 using namespace libtab;
@@ -17,28 +18,12 @@ Eigen::MatrixXd create_regge_space(cell::type celltype, int degree)
   if (celltype != cell::type::triangle and celltype != cell::type::tetrahedron)
     throw std::runtime_error("Unsupported celltype");
 
+  // The space is all symmetric matrices with entries of the given degree,
+  // which are stored by their independent components
   const int tdim = cell::topological_dimension(celltype);
-  const int nc = tdim * (tdim + 1) / 2;
-  const int basis_size = polyset::dim(celltype, degree);
-  const int ndofs = basis_size * nc;
-  const int psize = basis_size * tdim * tdim;
-
-  Eigen::ArrayXXd wcoeffs = Eigen::ArrayXXd::Zero(ndofs, psize);
-  int s = basis_size;
-  for (int i = 0; i < tdim; ++i)
-  {
-    for (int j = 0; j < tdim; ++j)
-    {
-      int xoff = i + tdim * j;
-      int yoff = i + j;
-      if (tdim == 3 and i > 0 and j > 0)
-        ++yoff;
-
-      wcoeffs.block(yoff * s, xoff * s, s, s) = Eigen::MatrixXd::Identity(s, s);
-    }
-  }
-
-  return wcoeffs;
+  const int ndofs
+      = polyset::dim(celltype, degree) * symmetric_tensor::num_components(tdim);
+  return Eigen::MatrixXd::Identity(ndofs, ndofs);
 }
 //-----------------------------------------------------------------------------
 Eigen::MatrixXd create_regge_dual(cell::type celltype, int degree)
@@ -47,10 +32,12 @@ Eigen::MatrixXd create_regge_dual(cell::type celltype, int degree)
 
   const int basis_size = polyset::dim(celltype, degree);
 
-  const int ndofs = basis_size * (tdim + 1) * tdim / 2;
-  const int space_size = basis_size * tdim * tdim;
+  // The functionals act on the independent components, so the coefficients
+  // of the two off-diagonal entries (i, j) and (j, i) are added together
+  const int ndofs = basis_size * symmetric_tensor::num_components(tdim);
+  const std::vector<int> value_map = symmetric_tensor::value_map(tdim);
 
-  Eigen::ArrayXXd dualmat(ndofs, space_size);
+  Eigen::ArrayXXd dualmat = Eigen::ArrayXXd::Zero(ndofs, ndofs);
   std::vector<std::vector<std::vector<int>>> topology
       = cell::topology(celltype);
   const Eigen::ArrayXXd geometry = cell::geometry(celltype);
@@ -106,10 +93,12 @@ Eigen::MatrixXd create_regge_dual(cell::type celltype, int degree)
           // outer product: outer(outer(t, t), basis)
           const Eigen::MatrixXd vvt_b = vvt_flat * basis.row(k);
 
-          // Copy tensor values row by row into dualmat
+          // Add tensor values row by row into dualmat
           for (int r = 0; r < vvt_b.rows(); ++r)
-            dualmat.block(dof, r * vvt_b.cols(), 1, vvt_b.cols())
-                = vvt_b.row(r);
+          {
+            dualmat.block(dof, value_map[r] * vvt_b.cols(), 1, vvt_b.cols())
+                += vvt_b.row(r).array();
+          }
           ++dof;
         }
       }
@@ -149,6 +138,6 @@ FiniteElement libtab::create_regge(cell::type celltype, int degree,
     entity_dofs[3] = {(degree + 1) * degree * (degree - 1)};
 
   return FiniteElement(name, celltype, degree, {tdim, tdim}, coeffs,
-                       entity_dofs, base_permutations);
+                       entity_dofs, base_permutations, Eigen::ArrayXXd(), true);
 }
 //-----------------------------------------------------------------------------
@@ -0,0 +1,75 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "symmetric-tensor.h"
+#include <stdexcept>
+#include <utility>
+
+using namespace libtab;
+
+//-----------------------------------------------------------------------------
+int symmetric_tensor::num_components(int n) { return n * (n + 1) / 2; }
+//-----------------------------------------------------------------------------
+int symmetric_tensor::index(int n, int i, int j)
+{
+  if (i > j)
+    std::swap(i, j);
+  return i * n - i * (i - 1) / 2 + j - i;
+}
+//-----------------------------------------------------------------------------
+std::vector<int> symmetric_tensor::value_map(int n)
+{
+  std::vector<int> map(n * n);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      map[i * n + j] = index(n, i, j);
+  return map;
+}
+//-----------------------------------------------------------------------------
+SymmetricTableView::SymmetricTableView(const Eigen::ArrayXXd& table,
+                                       int ndofs, int n)
+    : SymmetricTableView(
+        Table(table.data(), table.rows(), table.cols(),
+              Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(table.rows(), 1)),
+        ndofs, n)
+{
+}
+//-----------------------------------------------------------------------------
+SymmetricTableView::SymmetricTableView(const Table& table, int ndofs, int n)
+    : _table(table), _ndofs(ndofs), _n(n)
+{
+  if (table.cols() != symmetric_tensor::num_components(n) * ndofs)
+    throw std::runtime_error("Table does not match symmetric tensor");
+}
+//-----------------------------------------------------------------------------
+SymmetricTableView::Block SymmetricTableView::entry(int i, int j) const
+{
+  check_entry(i, j);
+  return _table.middleCols(symmetric_tensor::index(_n, i, j) * _ndofs,
+                           _ndofs);
+}
+//-----------------------------------------------------------------------------
+double SymmetricTableView::operator()(int point, int dof, int i, int j) const
+{
+  if (point < 0 or point >= _table.rows() or dof < 0 or dof >= _ndofs)
+    throw std::runtime_error("Invalid point or dof");
+  check_entry(i, j);
+  return _table(point, symmetric_tensor::index(_n, i, j) * _ndofs + dof);
+}
+//-----------------------------------------------------------------------------
+Eigen::ArrayXXd SymmetricTableView::expand() const
+{
+  Eigen::ArrayXXd full(_table.rows(), _n * _n * _ndofs);
+  for (int i = 0; i < _n; ++i)
+    for (int j = 0; j < _n; ++j)
+      full.middleCols((i * _n + j) * _ndofs, _ndofs) = entry(i, j);
+  return full;
+}
+//-----------------------------------------------------------------------------
+void SymmetricTableView::check_entry(int i, int j) const
+{
+  if (i < 0 or i >= _n or j < 0 or j >= _n)
+    throw std::runtime_error("Invalid tensor entry");
+}
+//-----------------------------------------------------------------------------
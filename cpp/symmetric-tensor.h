@@ -0,0 +1,93 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <vector>
+
+namespace libtab
+{
+
+/// ## Symmetric tensor values
+/// An element whose values are symmetric n x n tensors (e.g. Regge) only
+/// stores the n(n+1)/2 independent components, i.e. the entries (i, j)
+/// with i <= j, in row-major order: (0, 0), (0, 1), ..., (0, n - 1),
+/// (1, 1), ... Its coefficients have one block for each of these, and
+/// FiniteElement::tabulate_compact tabulates only these components, which
+/// saves a third of the work and memory for n = 3.
+namespace symmetric_tensor
+{
+
+/// The number of independent components of a symmetric n x n tensor
+/// @param[in] n The size of the tensor
+/// @return n(n+1)/2
+int num_components(int n);
+
+/// The independent component holding entry (i, j) of a symmetric tensor
+/// @param[in] n The size of the tensor
+/// @param[in] i Row
+/// @param[in] j Column
+/// @return The component
+int index(int n, int i, int j);
+
+/// The independent component holding each entry of a symmetric tensor,
+/// for the entries in row-major order
+/// @param[in] n The size of the tensor
+/// @return Vector of size n * n
+std::vector<int> value_map(int n);
+
+} // namespace symmetric_tensor
+
+/// View of the compact tables of a symmetric tensor valued element (see
+/// FiniteElement::tabulate_compact) as the tables of all n * n entries,
+/// which does not copy the values
+class SymmetricTableView
+{
+public:
+  /// A compact table in memory, with any strides (e.g. a numpy array)
+  using Table = Eigen::Map<const Eigen::ArrayXXd, 0,
+                           Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>;
+
+  /// Block of the compact table holding the values of one entry
+  using Block
+      = Eigen::Block<const Table, Eigen::Dynamic, Eigen::Dynamic, true>;
+
+  /// Create a view
+  /// @param[in] table A compact table, of shape (npoints, ncomponents *
+  /// ndofs). The view refers to it, so it must outlive the view.
+  /// @param[in] ndofs The number of dofs of the element
+  /// @param[in] n The size of the tensor
+  SymmetricTableView(const Eigen::ArrayXXd& table, int ndofs, int n);
+
+  /// Create a view of a compact table in memory
+  /// @param[in] table A compact table, of shape (npoints, ncomponents *
+  /// ndofs). The view refers to its memory, which must outlive the view.
+  /// @param[in] ndofs The number of dofs of the element
+  /// @param[in] n The size of the tensor
+  SymmetricTableView(const Table& table, int ndofs, int n);
+
+  /// The values of entry (i, j) of each basis function
+  /// @param[in] i Row
+  /// @param[in] j Column
+  /// @return Block of shape (npoints, ndofs) of the compact table
+  Block entry(int i, int j) const;
+
+  /// The value of entry (i, j) of a basis function at a point
+  double operator()(int point, int dof, int i, int j) const;
+
+  /// Copy the values into a table with a block for each of the n * n
+  /// entries, in the layout of FiniteElement::tabulate
+  /// @return Table of shape (npoints, n * n * ndofs)
+  Eigen::ArrayXXd expand() const;
+
+private:
+  // Throw if (i, j) is not an entry of the tensor
+  void check_entry(int i, int j) const;
+
+  Table _table;
+  int _ndofs, _n;
+};
+
+} // namespace libtab
@@ -0,0 +1,260 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "tabulation-cache.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <utility>
+#include <unordered_map>
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// FNV-1a hash of the shape and bytes of the points
+std::size_t hash_points(const Eigen::ArrayXXd& x)
+{
+  std::uint64_t h = 14695981039346656037ull;
+  auto combine = [&h](const unsigned char* p, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      h ^= p[i];
+      h *= 1099511628211ull;
+    }
+  };
+  const std::int64_t shape[2] = {x.rows(), x.cols()};
+  combine(reinterpret_cast<const unsigned char*>(shape), sizeof(shape));
+  combine(reinterpret_cast<const unsigned char*>(x.data()),
+          x.size() * sizeof(double));
+  return h;
+}
+//-----------------------------------------------------------------------------
+// Storage of the tables of an entry: -1 for doubles, or a
+// CompressedTable::format
+constexpr int uncompressed = -1;
+//-----------------------------------------------------------------------------
+struct Entry
+{
+  std::size_t hash;
+  std::size_t key;
+  int nd;
+  int storage;
+  Eigen::ArrayXXd points;
+
+  // A std::vector<Eigen::ArrayXXd> or std::vector<CompressedTable>,
+  // according to the storage
+  std::shared_ptr<const void> tables;
+  std::size_t bytes;
+};
+//-----------------------------------------------------------------------------
+// Least recently used cache of tables. The most recently used entry is at
+// the front of the list, and the index maps the hash of the points to the
+// entries with that hash.
+class Cache
+{
+public:
+  std::shared_ptr<const void> find(std::size_t hash, std::size_t key, int nd,
+                                   int storage, const Eigen::ArrayXXd& x)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = lookup(hash, key, nd, storage, x);
+    if (it == _entries.end())
+    {
+      ++_misses;
+      return nullptr;
+    }
+
+    ++_hits;
+    _entries.splice(_entries.begin(), _entries, it);
+    return it->tables;
+  }
+
+  // Insert tables of the given size in bytes for the points, unless
+  // another thread has done so in the meantime, and return the cached
+  // tables
+  std::shared_ptr<const void> insert(std::size_t hash, std::size_t key,
+                                     int nd, int storage,
+                                     const Eigen::ArrayXXd& x,
+                                     std::shared_ptr<const void> tables,
+                                     std::size_t table_bytes)
+  {
+    const std::size_t bytes = x.size() * sizeof(double) + table_bytes;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (auto it = lookup(hash, key, nd, storage, x); it != _entries.end())
+      return it->tables;
+    if (bytes > _capacity)
+      return tables;
+
+    _entries.push_front({hash, key, nd, storage, x, tables, bytes});
+    _index.emplace(hash, _entries.begin());
+    _size += bytes;
+    evict(_capacity);
+    return tables;
+  }
+
+  std::size_t capacity()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity;
+  }
+
+  void set_capacity(std::size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = bytes;
+    evict(_capacity);
+  }
+
+  std::size_t size()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+  }
+
+  std::size_t hits()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hits;
+  }
+
+  std::size_t misses()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _misses;
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    evict(0);
+    _hits = 0;
+    _misses = 0;
+  }
+
+private:
+  using iterator = std::list<Entry>::iterator;
+
+  iterator lookup(std::size_t hash, std::size_t key, int nd, int storage,
+                  const Eigen::ArrayXXd& x)
+  {
+    auto [first, last] = _index.equal_range(hash);
+    for (auto it = first; it != last; ++it)
+    {
+      const Entry& e = *it->second;
+      if (e.key == key and e.nd == nd and e.storage == storage
+          and e.points.rows() == x.rows()
+          and e.points.cols() == x.cols() and (e.points == x).all())
+      {
+        return it->second;
+      }
+    }
+    return _entries.end();
+  }
+
+  // Remove least recently used entries until at most size bytes are held
+  void evict(std::size_t size)
+  {
+    while (_size > size)
+    {
+      const iterator last = std::prev(_entries.end());
+      auto [first, end] = _index.equal_range(last->hash);
+      for (auto it = first; it != end; ++it)
+      {
+        if (it->second == last)
+        {
+          _index.erase(it);
+          break;
+        }
+      }
+      _size -= last->bytes;
+      _entries.pop_back();
+    }
+  }
+
+  std::mutex _mutex;
+  std::list<Entry> _entries;
+  std::unordered_multimap<std::size_t, iterator> _index;
+  std::size_t _capacity = 64 << 20;
+  std::size_t _size = 0;
+  std::size_t _hits = 0;
+  std::size_t _misses = 0;
+};
+//-----------------------------------------------------------------------------
+Cache& cache()
+{
+  static Cache c;
+  return c;
+}
+//-----------------------------------------------------------------------------
+// The cached tables of type T (a std::vector of tables) for the given
+// storage, computing them with compute if there is no such entry
+template <typename T, typename F>
+std::shared_ptr<const T> get_entry(std::size_t key, int nd, int storage,
+                                   const Eigen::ArrayXXd& x, F compute)
+{
+  const std::size_t hash = hash_points(x);
+  if (auto t = cache().find(hash, key, nd, storage, x))
+    return std::static_pointer_cast<const T>(t);
+
+  // Compute without holding the lock, so that other lookups can proceed
+  auto [tables, bytes] = compute();
+  auto t = std::make_shared<const T>(std::move(tables));
+  return std::static_pointer_cast<const T>(
+      cache().insert(hash, key, nd, storage, x, std::move(t), bytes));
+}
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+tabulation_cache::tables tabulation_cache::get(
+    std::size_t key, int nd, const Eigen::ArrayXXd& x,
+    const std::function<std::vector<Eigen::ArrayXXd>()>& tabulate)
+{
+  return get_entry<std::vector<Eigen::ArrayXXd>>(
+      key, nd, uncompressed, x, [&]() {
+        std::vector<Eigen::ArrayXXd> t = tabulate();
+        std::size_t bytes = 0;
+        for (const Eigen::ArrayXXd& table : t)
+          bytes += table.size() * sizeof(double);
+        return std::pair(std::move(t), bytes);
+      });
+}
+//-----------------------------------------------------------------------------
+tabulation_cache::compressed_tables tabulation_cache::get(
+    std::size_t key, int nd, const Eigen::ArrayXXd& x,
+    CompressedTable::format storage,
+    const std::function<std::vector<Eigen::ArrayXXd>()>& tabulate)
+{
+  return get_entry<std::vector<CompressedTable>>(
+      key, nd, static_cast<int>(storage), x, [&]() {
+        // Only the compressed tables are kept
+        std::vector<CompressedTable> t;
+        std::size_t bytes = 0;
+        for (const Eigen::ArrayXXd& table : tabulate())
+        {
+          t.emplace_back(table, storage);
+          bytes += t.back().memory_usage();
+        }
+        return std::pair(std::move(t), bytes);
+      });
+}
+//-----------------------------------------------------------------------------
+std::size_t tabulation_cache::capacity() { return cache().capacity(); }
+//-----------------------------------------------------------------------------
+void tabulation_cache::set_capacity(std::size_t bytes)
+{
+  cache().set_capacity(bytes);
+}
+//-----------------------------------------------------------------------------
+std::size_t tabulation_cache::memory_usage() { return cache().size(); }
+//-----------------------------------------------------------------------------
+std::size_t tabulation_cache::hits() { return cache().hits(); }
+//-----------------------------------------------------------------------------
+std::size_t tabulation_cache::misses() { return cache().misses(); }
+//-----------------------------------------------------------------------------
+void tabulation_cache::clear() { cache().clear(); }
+//-----------------------------------------------------------------------------
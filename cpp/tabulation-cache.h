@@ -0,0 +1,90 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "compressed-table.h"
+#include <Eigen/Dense>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace libtab
+{
+
+/// ## Tabulation cache
+/// Tables of basis functions which are requested repeatedly for the same
+/// points (e.g. facet quadrature points mapped into the cell, which are
+/// identical for every cell sharing a facet orientation) are kept in a
+/// cache shared by all of libtab, so that they are only computed once.
+///
+/// Entries are keyed by a hash of the points, confirmed by comparing the
+/// points exactly, together with an identifier of the tabulated element
+/// and the number of derivatives. The cache holds at most
+/// tabulation_cache::capacity() bytes (points and tables), discarding the
+/// least recently used entries first. It is safe to use from several
+/// threads.
+///
+/// Tables can also be cached in a 16-bit format (see CompressedTable), to
+/// hold about four times as many tables in the same memory. The compressed
+/// tables are separate entries, and are contracted with coefficients
+/// directly (see CompressedTable::contract).
+namespace tabulation_cache
+{
+
+/// Shared, immutable tables, as returned by FiniteElement::tabulate
+using tables = std::shared_ptr<const std::vector<Eigen::ArrayXXd>>;
+
+/// Shared, immutable tables in a 16-bit format
+using compressed_tables
+    = std::shared_ptr<const std::vector<CompressedTable>>;
+
+/// Return the cached tables for the given key and points, calling
+/// tabulate to compute (and then cache) them if there is no such entry.
+/// @param key Identifier of what is tabulated (e.g. FiniteElement::id)
+/// @param nd Number of derivatives
+/// @param x Points, of shape (number of points, tdim)
+/// @param tabulate Function computing the tables at x
+/// @return The tables
+tables get(std::size_t key, int nd, const Eigen::ArrayXXd& x,
+           const std::function<std::vector<Eigen::ArrayXXd>()>& tabulate);
+
+/// Return the cached tables for the given key and points, stored in a
+/// 16-bit format, calling tabulate to compute them (and then caching the
+/// compressed tables only) if there is no such entry.
+/// @param key Identifier of what is tabulated (e.g. FiniteElement::id)
+/// @param nd Number of derivatives
+/// @param x Points, of shape (number of points, tdim)
+/// @param storage The format of the stored values
+/// @param tabulate Function computing the tables at x
+/// @return The compressed tables
+compressed_tables
+get(std::size_t key, int nd, const Eigen::ArrayXXd& x,
+    CompressedTable::format storage,
+    const std::function<std::vector<Eigen::ArrayXXd>()>& tabulate);
+
+/// Maximum memory held by the cache (points, and tables in either
+/// format), in bytes. The default is 64 MiB.
+std::size_t capacity();
+
+/// Set the maximum memory held by the cache, discarding entries if
+/// needed. A capacity of 0 disables caching.
+/// @param bytes Capacity in bytes
+void set_capacity(std::size_t bytes);
+
+/// Memory currently held by the cache, in bytes
+std::size_t memory_usage();
+
+/// Number of lookups which returned a cached entry, since the last clear
+std::size_t hits();
+
+/// Number of lookups which computed the tables, since the last clear
+std::size_t misses();
+
+/// Discard all entries and reset the hit and miss counts
+void clear();
+
+} // namespace tabulation_cache
+} // namespace libtab
@@ -0,0 +1,522 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "tabulation-plan.h"
+#include "libtab.h"
+#include "linalg.h"
+#include "memory.h"
+#include "parallel.h"
+#include "polyset.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <mutex>
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Number of derivatives of order up to and including nd in dimension tdim
+int num_derivatives(int tdim, int nd)
+{
+  switch (tdim)
+  {
+  case 1:
+    return nd + 1;
+  case 2:
+    return (nd + 1) * (nd + 2) / 2;
+  default:
+    return (nd + 1) * (nd + 2) * (nd + 3) / 6;
+  }
+}
+//-----------------------------------------------------------------------------
+// Size of the L2 cache (per core) in bytes
+std::size_t l2_cache_size()
+{
+  long size = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+  return size > 0 ? size : 1 << 20;
+}
+//-----------------------------------------------------------------------------
+// Number of points in a tile for which the expansion set tables of all
+// derivatives fit in half of the L2 cache
+int default_block_size(cell::type celltype, int nd, int psize)
+{
+  const int tdim = cell::topological_dimension(celltype);
+  const int ntables = num_derivatives(tdim, nd);
+
+  static const std::size_t l2 = l2_cache_size();
+  const int rows = l2 / (2 * sizeof(double) * ntables * psize);
+  return std::max(32, rows - rows % 8);
+}
+//-----------------------------------------------------------------------------
+// Points inside the reference cell, used to time the engines
+Eigen::ArrayXXd sample_points(cell::type celltype, int npoints)
+{
+  const Eigen::ArrayXXd vertices = cell::geometry(celltype);
+  Eigen::ArrayXXd weights
+      = Eigen::ArrayXXd::Random(npoints, vertices.rows()).abs() + 0.1;
+  weights.colwise() /= weights.rowwise().sum();
+  return (weights.matrix() * vertices.matrix()).array();
+}
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+// Scratch storage of one task: a tile of points, the expansion set tables
+// at those points, the workspace of the recurrences and a tile of values
+// to scatter into the output. The tables have exactly the number of rows
+// of the tiles the task processes, so that tabulating into them does not
+// resize them.
+struct TabulationPlan::Arena
+{
+  Eigen::ArrayXXd points;
+  std::vector<Eigen::ArrayXXd> basis;
+  polyset::Workspace<double> workspace;
+  Eigen::MatrixXd values;
+};
+//-----------------------------------------------------------------------------
+struct TabulationPlan::ScratchPool
+{
+  std::mutex mutex;
+  std::vector<std::vector<Arena>> free;
+};
+//-----------------------------------------------------------------------------
+TabulationPlan::Points TabulationPlan::Points::row_major(const double* x,
+                                                         int tdim)
+{
+  Points p;
+  for (int c = 0; c < tdim; ++c)
+    p.coordinates[c] = x + c;
+  p.stride = tdim;
+  return p;
+}
+//-----------------------------------------------------------------------------
+TabulationPlan::Points TabulationPlan::Points::col_major(const double* x,
+                                                         int npoints, int tdim)
+{
+  Points p;
+  for (int c = 0; c < tdim; ++c)
+    p.coordinates[c] = x + c * npoints;
+  return p;
+}
+//-----------------------------------------------------------------------------
+TabulationPlan::Points TabulationPlan::Points::separate(const double* x,
+                                                        const double* y,
+                                                        const double* z,
+                                                        const double* w)
+{
+  Points p;
+  p.coordinates = {x, y, z, w};
+  return p;
+}
+//-----------------------------------------------------------------------------
+TabulationPlan::TabulationPlan(const FiniteElement& element, int npoints,
+                               int nd, int nthreads, int block_size,
+                               bool measure, const layout& output,
+                               bool compact)
+    : _cell_type(element.cell_type()), _degree(element.degree()),
+      _tdim(cell::topological_dimension(_cell_type)), _npoints(npoints),
+      _nd(nd), _nderivs(::num_derivatives(_tdim, nd)),
+      _psize(polyset::dim(_cell_type, _degree)), _ndofs(element.dim()),
+      _value_size(compact ? element.stored_value_size()
+                          : element.value_size()),
+      _nthreads(nthreads),
+      _block_size(block_size), _engine(engine::direct), _layout(output)
+{
+  if (npoints < 0 or nd < 0)
+    throw std::runtime_error("Invalid number of points or derivatives");
+
+  // Strides of the output, from the fastest varying axis
+  std::array<bool, 4> seen = {false, false, false, false};
+  std::ptrdiff_t stride = 1;
+  for (int i = 3; i >= 0; --i)
+  {
+    const int a = static_cast<int>(_layout[i]);
+    if (seen[a])
+      throw std::runtime_error("Output layout must contain each axis once");
+    seen[a] = true;
+    _strides[a] = stride;
+    stride *= extent(_layout[i]);
+  }
+  _scatter = _strides[static_cast<int>(axis::point)] != 1
+             and _strides[static_cast<int>(axis::dof)] != 1;
+
+  _coeffs = element._coeff_blocks;
+  _coeffs_t = element._coeff_blocks_t;
+  for (int j = 0; j < _value_size; ++j)
+  {
+    _component.push_back(compact ? j : element.value_map()[j]);
+    auto first = std::find(_component.begin(), _component.end(),
+                           _component.back());
+    _source.push_back(first == _component.end() - 1
+                          ? -1
+                          : static_cast<int>(first - _component.begin()));
+  }
+
+  _pool = std::make_shared<ScratchPool>();
+  const int default_size = default_block_size(_cell_type, nd, _psize);
+  if (measure and block_size < 0)
+  {
+    // Time the direct engine and a few tile sizes around the heuristic, in
+    // the output layout of the plan
+    const Eigen::ArrayXXd x = sample_points(_cell_type, npoints);
+    const Points p = Points::col_major(x.data(), npoints, _tdim);
+    std::vector<double> values(size());
+    double best = std::numeric_limits<double>::max();
+    int best_size = 0;
+    for (int size : {0, default_size / 2, default_size, 2 * default_size})
+    {
+      if (size >= npoints)
+        continue;
+      _block_size = size;
+      _engine = size == 0 ? engine::direct : engine::blocked;
+      _pool->free.clear();
+      double t = std::numeric_limits<double>::max();
+      for (int i = 0; i < 2; ++i)
+      {
+        const auto start = std::chrono::steady_clock::now();
+        execute(p, values.data());
+        const std::chrono::duration<double> elapsed
+            = std::chrono::steady_clock::now() - start;
+        t = std::min(t, elapsed.count());
+      }
+      if (t < best)
+      {
+        best = t;
+        best_size = size;
+      }
+    }
+    _block_size = best_size;
+  }
+  else if (block_size < 0)
+    _block_size = default_size;
+
+  if (_block_size >= npoints)
+    _block_size = 0;
+  _engine = _block_size == 0 ? engine::direct : engine::blocked;
+
+  _pool->free.clear();
+  _pool->free.push_back(create_scratch());
+}
+//-----------------------------------------------------------------------------
+void TabulationPlan::execute(const Eigen::ArrayXXd& x,
+                             std::vector<Eigen::ArrayXXd>& tables,
+                             polyset::coordinates coords) const
+{
+  if (x.cols() != num_coordinates(coords))
+    throw std::runtime_error("Point dim does not match element dim.");
+  if (x.rows() != _npoints)
+    throw std::runtime_error("Number of points does not match plan.");
+
+  tables.resize(_nderivs);
+  for (Eigen::ArrayXXd& t : tables)
+  {
+    t.resize(_npoints, _ndofs * _value_size);
+    memory::advise_huge_pages(t.data(), t.size() * sizeof(double));
+  }
+
+  run(
+      [&](int offset, int rows, Arena&) -> Eigen::Ref<const Eigen::ArrayXXd> {
+        return x.middleRows(offset, rows);
+      },
+      [&](int p, int offset, const Eigen::ArrayXXd& basis, Arena&) {
+        for (int j = 0; j < _value_size; ++j)
+        {
+          auto out = tables[p].matrix().block(offset, _ndofs * j,
+                                              basis.rows(), _ndofs);
+          if (_source[j] >= 0)
+          {
+            out = tables[p].matrix().block(offset, _ndofs * _source[j],
+                                           basis.rows(), _ndofs);
+          }
+          else
+            linalg::matmul(basis.matrix(), (*_coeffs_t)[_component[j]], out);
+        }
+      },
+      coords);
+}
+//-----------------------------------------------------------------------------
+void TabulationPlan::execute(const Points& x, double* values,
+                             polyset::coordinates coords) const
+{
+  // The coordinates are not read if there are no points
+  const int ncoords = num_coordinates(coords);
+  for (int c = 0; c < ncoords and num_points() > 0; ++c)
+  {
+    if (!x.coordinates[c])
+      throw std::runtime_error("Point dim does not match element dim.");
+  }
+
+  using Strided
+      = Eigen::Map<Eigen::MatrixXd, 0, Eigen::Stride<Eigen::Dynamic,
+                                                     Eigen::Dynamic>>;
+  using OuterStrided = Eigen::Map<Eigen::MatrixXd, 0, Eigen::OuterStride<>>;
+  const std::ptrdiff_t sd = _strides[static_cast<int>(axis::derivative)];
+  const std::ptrdiff_t sp = _strides[static_cast<int>(axis::point)];
+  const std::ptrdiff_t si = _strides[static_cast<int>(axis::dof)];
+  const std::ptrdiff_t sc = _strides[static_cast<int>(axis::component)];
+
+  run(
+      [&](int offset, int rows,
+          Arena& arena) -> Eigen::Ref<const Eigen::ArrayXXd> {
+        for (int c = 0; c < ncoords; ++c)
+        {
+          const double* xc = x.coordinates[c] + offset * x.stride;
+          for (int i = 0; i < rows; ++i)
+            arena.points(i, c) = xc[i * x.stride];
+        }
+        return arena.points.leftCols(ncoords);
+      },
+      [&](int p, int offset, const Eigen::ArrayXXd& basis, Arena& arena) {
+        const int rows = basis.rows();
+        const Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic> stride(si, sp);
+        for (int j = 0; j < _value_size; ++j)
+        {
+          double* v = values + p * sd + offset * sp + j * sc;
+          const int c = _component[j];
+          if (_source[j] >= 0)
+          {
+            // Copy the values of the same stored component, which are
+            // still in cache
+            Strided(v, rows, _ndofs, stride) = Strided(
+                values + p * sd + offset * sp + _source[j] * sc, rows,
+                _ndofs, stride);
+          }
+          else if (sp == 1)
+          {
+            // (point, dof) blocks are column-major
+            OuterStrided out(v, rows, _ndofs, Eigen::OuterStride<>(si));
+            linalg::matmul(basis.matrix(), (*_coeffs_t)[c], out);
+          }
+          else if (si == 1)
+          {
+            // (dof, point) blocks are column-major
+            OuterStrided out(v, _ndofs, rows, Eigen::OuterStride<>(sp));
+            linalg::matmul((*_coeffs)[c], basis.matrix(), out, true);
+          }
+          else
+          {
+            // Neither points nor dofs are contiguous: scatter from a tile
+            // which is still in cache
+            linalg::matmul(basis.matrix(), (*_coeffs_t)[c], arena.values);
+            Strided(v, rows, _ndofs, stride) = arena.values;
+          }
+        }
+      },
+      coords);
+}
+//-----------------------------------------------------------------------------
+void TabulationPlan::first_touch(double* values) const
+{
+  using Strided
+      = Eigen::Map<Eigen::MatrixXd, 0, Eigen::Stride<Eigen::Dynamic,
+                                                     Eigen::Dynamic>>;
+  const std::ptrdiff_t sd = _strides[static_cast<int>(axis::derivative)];
+  const std::ptrdiff_t sp = _strides[static_cast<int>(axis::point)];
+  const std::ptrdiff_t si = _strides[static_cast<int>(axis::dof)];
+  const std::ptrdiff_t sc = _strides[static_cast<int>(axis::component)];
+
+  // Zero the values which apply(p, offset, basis) writes in
+  // TabulationPlan::run
+  auto touch = [&](int p, int offset, int rows) {
+    for (int j = 0; j < _value_size; ++j)
+    {
+      Strided(values + p * sd + offset * sp + j * sc, rows, _ndofs,
+              Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(si, sp))
+          .setZero();
+    }
+  };
+
+  parallel::for_each(num_tasks(), _nthreads, [&](int t) {
+    for (int b = first_tile(t); b < first_tile(t + 1); ++b)
+    {
+      if (_engine == engine::direct)
+        touch(b, 0, _npoints);
+      else
+      {
+        const int offset = b * _block_size;
+        const int rows = std::min(_block_size, _npoints - offset);
+        for (int p = 0; p < _nderivs; ++p)
+          touch(p, offset, rows);
+      }
+    }
+  });
+}
+//-----------------------------------------------------------------------------
+template <typename PointsFunction, typename ApplyFunction>
+void TabulationPlan::run(const PointsFunction& points,
+                         const ApplyFunction& apply,
+                         polyset::coordinates coords) const
+{
+  // Take a set of scratch storage, and only allocate one if all are in use
+  // by other executions
+  std::vector<Arena> scratch;
+  {
+    std::lock_guard<std::mutex> lock(_pool->mutex);
+    if (!_pool->free.empty())
+    {
+      scratch = std::move(_pool->free.back());
+      _pool->free.pop_back();
+    }
+  }
+  if (scratch.empty())
+    scratch = create_scratch();
+
+  // The tasks are passed by reference, so that wrapping them in a
+  // std::function does not allocate
+  if (_engine == engine::direct)
+  {
+    Arena& arena = scratch[0];
+    polyset::tabulate_into(_cell_type, _degree, _nd,
+                           points(0, _npoints, arena), arena.basis,
+                           arena.workspace, _nthreads, coords);
+    const auto task = [&](int t) {
+      for (int p = first_tile(t); p < first_tile(t + 1); ++p)
+        apply(p, 0, arena.basis[p], scratch[t]);
+    };
+    parallel::for_each(num_tasks(), _nthreads, std::cref(task));
+  }
+  else
+  {
+    // Tabulate the expansion set for one tile of points at a time, and
+    // multiply each derivative by the coefficients while the tile is still
+    // in cache. Only the final result is written to memory. Each task
+    // processes a range of tiles in its own arena, apart from the last
+    // tile if it is smaller, which has an arena of its own.
+    const auto task = [&](int t) {
+      for (int b = first_tile(t); b < first_tile(t + 1); ++b)
+      {
+        const int offset = b * _block_size;
+        const int rows = std::min(_block_size, _npoints - offset);
+        Arena& arena = rows < _block_size ? scratch.back() : scratch[t];
+        polyset::tabulate_into(_cell_type, _degree, _nd,
+                               points(offset, rows, arena), arena.basis,
+                               arena.workspace, 1, coords);
+        for (int p = 0; p < _nderivs; ++p)
+          apply(p, offset, arena.basis[p], arena);
+      }
+    };
+    parallel::for_each(num_tasks(), _nthreads, std::cref(task));
+  }
+
+  std::lock_guard<std::mutex> lock(_pool->mutex);
+  _pool->free.push_back(std::move(scratch));
+}
+//-----------------------------------------------------------------------------
+std::vector<TabulationPlan::Arena> TabulationPlan::create_scratch() const
+{
+  const int ntasks = num_tasks();
+  auto size = [&](Arena& arena, int rows) {
+    arena.points.resize(rows, _tdim + 1);
+    arena.basis.resize(_nderivs);
+    for (Eigen::ArrayXXd& table : arena.basis)
+      table.resize(rows, _psize);
+    polyset::reserve(arena.workspace, _cell_type, _degree, _nd, rows);
+    if (_scatter)
+      arena.values.resize(rows, _ndofs);
+  };
+
+  if (_engine == engine::direct)
+  {
+    // The expansion set is tabulated once, in the first arena, and each
+    // task scatters the values of its derivatives from its own tile
+    std::vector<Arena> scratch(ntasks);
+    size(scratch[0], _npoints);
+    for (int t = 1; t < ntasks and _scatter; ++t)
+      scratch[t].values.resize(_npoints, _ndofs);
+    return scratch;
+  }
+
+  const int tail = _npoints % _block_size;
+  std::vector<Arena> scratch(tail > 0 ? ntasks + 1 : ntasks);
+  for (int t = 0; t < ntasks; ++t)
+    size(scratch[t], _block_size);
+  if (tail > 0)
+    size(scratch.back(), tail);
+  return scratch;
+}
+//-----------------------------------------------------------------------------
+int TabulationPlan::num_tiles() const
+{
+  if (_engine == engine::direct)
+    return _nderivs;
+  else
+    return (_npoints + _block_size - 1) / _block_size;
+}
+//-----------------------------------------------------------------------------
+int TabulationPlan::num_tasks() const
+{
+  return std::max(1, std::min(_nthreads, num_tiles()));
+}
+//-----------------------------------------------------------------------------
+int TabulationPlan::first_tile(int t) const
+{
+  return static_cast<long>(t) * num_tiles() / num_tasks();
+}
+//-----------------------------------------------------------------------------
+std::vector<Eigen::ArrayXXd> TabulationPlan::allocate() const
+{
+  // The tables are allocated separately, rather than copied, so that
+  // their pages are first touched by TabulationPlan::execute
+  std::vector<Eigen::ArrayXXd> tables(_nderivs);
+  for (Eigen::ArrayXXd& t : tables)
+  {
+    t.resize(_npoints, _ndofs * _value_size);
+    memory::advise_huge_pages(t.data(), t.size() * sizeof(double));
+  }
+  return tables;
+}
+//-----------------------------------------------------------------------------
+int TabulationPlan::num_coordinates(polyset::coordinates coords) const
+{
+  return coords == polyset::coordinates::barycentric ? _tdim + 1 : _tdim;
+}
+//-----------------------------------------------------------------------------
+TabulationPlan::engine TabulationPlan::engine_type() const { return _engine; }
+//-----------------------------------------------------------------------------
+int TabulationPlan::block_size() const { return _block_size; }
+//-----------------------------------------------------------------------------
+int TabulationPlan::num_points() const { return _npoints; }
+//-----------------------------------------------------------------------------
+int TabulationPlan::num_derivatives() const { return _nderivs; }
+//-----------------------------------------------------------------------------
+const TabulationPlan::layout& TabulationPlan::output_layout() const
+{
+  return _layout;
+}
+//-----------------------------------------------------------------------------
+std::size_t TabulationPlan::size() const
+{
+  return static_cast<std::size_t>(_nderivs) * _npoints * _ndofs * _value_size;
+}
+//-----------------------------------------------------------------------------
+std::array<int, 4> TabulationPlan::shape() const
+{
+  return {extent(_layout[0]), extent(_layout[1]), extent(_layout[2]),
+          extent(_layout[3])};
+}
+//-----------------------------------------------------------------------------
+int TabulationPlan::extent(axis a) const
+{
+  switch (a)
+  {
+  case axis::derivative:
+    return _nderivs;
+  case axis::point:
+    return _npoints;
+  case axis::dof:
+    return _ndofs;
+  default:
+    return _value_size;
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,266 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "cell.h"
+#include "polyset.h"
+#include <Eigen/Dense>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace libtab
+{
+
+class FiniteElement;
+
+/// A plan for tabulating the basis functions (and derivatives) of a finite
+/// element at a fixed number of points.
+///
+/// Everything which does not depend on the values of the points is done
+/// once, when the plan is created: sizes are computed, the coefficients are
+/// shared (without copying) in the layout used by the kernels, which the
+/// element keeps, and the way the points are processed (the engine) is
+/// chosen, either by a heuristic or by timing the candidates, and scratch
+/// storage (tiles of points, expansion set tables, workspaces of the
+/// recurrences and tiles of values) is allocated for each task. Executing
+/// the plan then only tabulates the expansion set and applies the
+/// coefficients, writing into caller-owned tables, without allocating.
+///
+/// The values can be written in any order of the derivative, point, dof
+/// and value component axes (the output layout of the plan), and the
+/// points can be read from any strided storage, so that the kernels write
+/// directly in the layout wanted by the caller.
+///
+/// A plan only shares the (immutable) coefficients of the element, and
+/// TabulationPlan::execute is const, so one plan can be executed from
+/// several threads at once. Each execution takes a set of scratch storage
+/// from the plan, and a set is only allocated when all are in use by other
+/// executions.
+class TabulationPlan
+{
+public:
+  /// Axes of the tabulated values
+  enum class axis
+  {
+    derivative,
+    point,
+    dof,
+    component
+  };
+
+  /// Output layout: the axes ordered from the slowest to the fastest
+  /// varying in memory
+  using layout = std::array<axis, 4>;
+
+  /// The layout of FiniteElement::tabulate: for each derivative, a
+  /// column-major (point, dof) table for each component in turn
+  static constexpr layout default_layout
+      = {axis::derivative, axis::component, axis::dof, axis::point};
+
+  /// Points in memory: coordinate c of point i is
+  /// coordinates[c][i * stride]
+  struct Points
+  {
+    /// Address of the first point's coordinate, for each coordinate (up to
+    /// four, for the barycentric coordinates of points in a tetrahedron)
+    std::array<const double*, 4> coordinates
+        = {nullptr, nullptr, nullptr, nullptr};
+
+    /// Distance between consecutive points, in doubles
+    std::ptrdiff_t stride = 1;
+
+    /// Points stored as an array of structures, i.e. a row-major
+    /// (npoints, tdim) array
+    static Points row_major(const double* x, int tdim);
+
+    /// Points stored as a structure of arrays, i.e. a column-major
+    /// (npoints, tdim) array
+    static Points col_major(const double* x, int npoints, int tdim);
+
+    /// Coordinates stored in separate arrays. The fourth is only used for
+    /// the barycentric coordinates of points in a tetrahedron.
+    static Points separate(const double* x, const double* y = nullptr,
+                           const double* z = nullptr,
+                           const double* w = nullptr);
+  };
+
+  /// How the points are processed
+  enum class engine
+  {
+    /// Tabulate the expansion set at all points, then apply the
+    /// coefficients to each derivative
+    direct,
+
+    /// Tabulate the expansion set for one tile of points at a time and
+    /// apply the coefficients while the tile is in cache
+    blocked
+  };
+
+  /// Create a plan
+  /// @param[in] element The element to tabulate
+  /// @param[in] npoints The number of points
+  /// @param[in] nd The order of derivatives, up to and including, to
+  /// compute
+  /// @param[in] nthreads The number of threads used when executing
+  /// @param[in] block_size The number of points in each tile. Use 0 for the
+  /// direct engine, or -1 (the default) to let the plan choose.
+  /// @param[in] measure If set and block_size is -1, choose the engine and
+  /// tile size by timing the candidates at npoints points, rather than by
+  /// a heuristic based on the cache size. This makes creating the plan
+  /// more expensive.
+  /// @param[in] output The layout of the values written by
+  /// TabulationPlan::execute into a buffer
+  /// @param[in] compact If set, only the stored value components of the
+  /// element are tabulated (see FiniteElement::tabulate_compact).
+  /// Otherwise, the values of an element with symmetric tensor values are
+  /// computed for the independent components and copied to the others.
+  TabulationPlan(const FiniteElement& element, int npoints, int nd,
+                 int nthreads = 1, int block_size = -1, bool measure = false,
+                 const layout& output = default_layout,
+                 bool compact = false);
+
+  /// Tabulate the basis functions and derivatives at the points, in the
+  /// layout of FiniteElement::tabulate (or FiniteElement::tabulate_compact
+  /// for a compact plan), whatever the output layout of the plan. The
+  /// tables are resized if needed, which does not allocate if they came
+  /// from TabulationPlan::allocate or an earlier execution of this plan.
+  /// @param[in] x The points, of shape (npoints, tdim), or (npoints, tdim
+  /// + 1) for barycentric coordinates on a simplex
+  /// @param[in,out] tables The tables for each derivative
+  /// @param[in] coords The coordinates in which the points are given. The
+  /// derivatives are with respect to the reference Cartesian coordinates
+  /// in either case.
+  void execute(const Eigen::ArrayXXd& x, std::vector<Eigen::ArrayXXd>& tables,
+               polyset::coordinates coords
+               = polyset::coordinates::cartesian) const;
+
+  /// Tabulate the basis functions and derivatives at the points, writing
+  /// them into a buffer in the output layout of the plan.
+  ///
+  /// With several threads, each thread writes the values at the points
+  /// of its own tiles. If the buffer has not been touched (see
+  /// memory::Buffer), its pages are therefore placed on the NUMA node of
+  /// the thread which computes them.
+  /// @param[in] x The points
+  /// @param[out] values Buffer of TabulationPlan::size values
+  /// @param[in] coords The coordinates in which the points are given
+  void execute(const Points& x, double* values,
+               polyset::coordinates coords
+               = polyset::coordinates::cartesian) const;
+
+  /// The number of coordinates of each point passed to
+  /// TabulationPlan::execute
+  /// @param[in] coords The coordinates in which the points are given
+  /// @return The topological dimension of the cell for Cartesian
+  /// coordinates, or one more for barycentric coordinates
+  int num_coordinates(polyset::coordinates coords
+                      = polyset::coordinates::cartesian) const;
+
+  /// Set a buffer to zero, with the same division of the values between
+  /// threads as TabulationPlan::execute, so that each page is first
+  /// touched, and so placed on the NUMA node of, the thread which will
+  /// write it. Every execution gives each task the same range of tiles,
+  /// and the default executor runs each task on the same thread in every
+  /// call (apart from tasks stolen to balance the load), so this keeps
+  /// later executions local when the buffer is reused, or filled by other
+  /// code before the first execution.
+  /// @param[out] values Buffer of TabulationPlan::size values
+  void first_touch(double* values) const;
+
+  /// Allocate tables for the result of TabulationPlan::execute
+  /// @return Tables of the right size, with unset values
+  std::vector<Eigen::ArrayXXd> allocate() const;
+
+  /// The engine chosen for this plan
+  engine engine_type() const;
+
+  /// The number of points in each tile, or 0 for the direct engine
+  int block_size() const;
+
+  /// The number of points
+  int num_points() const;
+
+  /// The number of derivative tables computed
+  int num_derivatives() const;
+
+  /// The output layout
+  const layout& output_layout() const;
+
+  /// The number of values written by TabulationPlan::execute into a
+  /// buffer
+  std::size_t size() const;
+
+  /// The extent of each axis of the output, in the order of the output
+  /// layout
+  std::array<int, 4> shape() const;
+
+private:
+  // Scratch storage of one task of an execution, see tabulation-plan.cpp
+  struct Arena;
+
+  // Scratch storage for the executions which are not running
+  struct ScratchPool;
+
+  // Run the engine: points(offset, rows, arena) returns the given rows of
+  // the points, in the given coordinates, and apply(p, offset, basis,
+  // arena) applies the coefficients to the expansion set table of
+  // derivative p at those rows
+  template <typename PointsFunction, typename ApplyFunction>
+  void run(const PointsFunction& points, const ApplyFunction& apply,
+           polyset::coordinates coords) const;
+
+  // Scratch storage for one execution: an arena for each task
+  std::vector<Arena> create_scratch() const;
+
+  // The tiles of points (or, for the direct engine, the derivatives) are
+  // split into contiguous ranges, one for each task of an execution, and
+  // task t processes tiles first_tile(t) to first_tile(t + 1) - 1
+  int num_tiles() const;
+  int num_tasks() const;
+  int first_tile(int t) const;
+
+  // Extent of an axis
+  int extent(axis a) const;
+
+  cell::type _cell_type;
+  int _degree;
+  int _tdim;
+  int _npoints;
+  int _nd;
+  int _nderivs;
+  int _psize;
+  int _ndofs;
+  int _value_size;
+  int _nthreads;
+  int _block_size;
+  engine _engine;
+
+  // Output layout, and the distance between consecutive entries along
+  // each axis, indexed by axis
+  layout _layout;
+  std::array<std::ptrdiff_t, 4> _strides;
+
+  // Coefficients for each stored value component, and their transposes,
+  // so that stored component c of the basis is tabulated by P
+  // _coeffs_t[c] (or the transpose by _coeffs[c] P^T), where P is a table
+  // of the expansion set. These are shared with the element.
+  std::shared_ptr<const std::vector<Eigen::MatrixXd>> _coeffs, _coeffs_t;
+
+  // Stored component of each output component, and the earlier output
+  // component with the same stored component (whose values are copied),
+  // or -1
+  std::vector<int> _component, _source;
+
+  // Whether the output layout has neither points nor dofs contiguous, so
+  // that values are scattered from a tile
+  bool _scatter;
+
+  // Scratch storage, shared by copies of the plan
+  std::shared_ptr<ScratchPool> _pool;
+};
+
+} // namespace libtab
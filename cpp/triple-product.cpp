@@ -0,0 +1,178 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#include "triple-product.h"
+#include "libtab.h"
+#include "lru-cache.h"
+#include "polyset.h"
+#include "quadrature.h"
+
+using namespace libtab;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Append the entries of slice i of a tensor, dropping those which are
+// zero up to rounding
+void append_slice(triple_product::Tensor& tensor, const Eigen::MatrixXd& slice,
+                  double tol)
+{
+  for (int j = 0; j < slice.rows(); ++j)
+  {
+    for (int k = 0; k < slice.cols(); ++k)
+    {
+      if (std::abs(slice(j, k)) > tol)
+      {
+        tensor.j.push_back(j);
+        tensor.k.push_back(k);
+        tensor.values.push_back(slice(j, k));
+      }
+    }
+  }
+  tensor.offsets.push_back(tensor.values.size());
+}
+//-----------------------------------------------------------------------------
+// Relative size below which entries are treated as zero
+constexpr double zero_tol = 1e-12;
+//-----------------------------------------------------------------------------
+// Most recently used tensors of expansion sets and of elements
+LRUCache<std::array<int, 4>, std::shared_ptr<const triple_product::Tensor>>
+    polyset_cache(triple_product::cache_capacity);
+LRUCache<std::array<std::size_t, 3>,
+         std::shared_ptr<const triple_product::Tensor>>
+    element_cache(triple_product::cache_capacity);
+//-----------------------------------------------------------------------------
+} // namespace
+
+//-----------------------------------------------------------------------------
+int triple_product::Tensor::nnz() const { return values.size(); }
+//-----------------------------------------------------------------------------
+std::tuple<std::vector<int>, std::vector<int>, std::vector<int>,
+           std::vector<double>>
+triple_product::Tensor::coo() const
+{
+  std::vector<int> i(values.size());
+  for (int r = 0; r < shape[0]; ++r)
+    std::fill(i.begin() + offsets[r], i.begin() + offsets[r + 1], r);
+  return {i, j, k, values};
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<const triple_product::Tensor>
+triple_product::polyset(cell::type celltype, int n0, int n1, int n2)
+{
+  const std::array<int, 4> key = {static_cast<int>(celltype), n0, n1, n2};
+  if (auto tensor = polyset_cache.find(key))
+    return *tensor;
+
+  // A rule with m points in each direction is exact for degree 2m - 1
+  const int m = (n0 + n1 + n2) / 2 + 1;
+  auto [pts, wts] = quadrature::make_quadrature(celltype, m);
+  const Eigen::MatrixXd P0 = polyset::tabulate(celltype, n0, 0, pts)[0];
+  const Eigen::MatrixXd P1 = polyset::tabulate(celltype, n1, 0, pts)[0];
+  const Eigen::MatrixXd P2 = polyset::tabulate(celltype, n2, 0, pts)[0];
+
+  // Slice a of the tensor is P1^T diag(w P0[:, a]) P2
+  std::vector<Eigen::MatrixXd> slices(P0.cols());
+  double max = 0.0;
+  for (int a = 0; a < P0.cols(); ++a)
+  {
+    const Eigen::VectorXd w = wts.matrix().cwiseProduct(P0.col(a));
+    slices[a] = P1.transpose() * w.asDiagonal() * P2;
+    max = std::max(max, slices[a].cwiseAbs().maxCoeff());
+  }
+
+  auto tensor = std::make_shared<Tensor>();
+  tensor->shape = {static_cast<int>(P0.cols()), static_cast<int>(P1.cols()),
+                   static_cast<int>(P2.cols())};
+  tensor->offsets = {0};
+  for (const Eigen::MatrixXd& slice : slices)
+    append_slice(*tensor, slice, zero_tol * max);
+
+  return polyset_cache.insert(key, tensor);
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<const triple_product::Tensor>
+triple_product::element(const FiniteElement& e0, const FiniteElement& e1,
+                        const FiniteElement& e2)
+{
+  const std::array<std::size_t, 3> key = {e0.id(), e1.id(), e2.id()};
+  if (auto tensor = element_cache.find(key))
+    return *tensor;
+
+  const cell::type celltype = e0.cell_type();
+  if (e1.cell_type() != celltype or e2.cell_type() != celltype)
+    throw std::runtime_error("Elements must be defined on the same cell");
+  if (e0.value_size() != 1 or e1.value_size() != 1 or e2.value_size() != 1)
+    throw std::runtime_error("Triple products require scalar elements");
+
+  const std::shared_ptr<const Tensor> T
+      = polyset(celltype, e0.degree(), e1.degree(), e2.degree());
+  const Eigen::MatrixXd& A = e0.coefficients();
+  const Eigen::MatrixXd& B = e1.coefficients();
+  const Eigen::MatrixXd& C = e2.coefficients();
+
+  // I(i, j, k) = sum_abc A(i, a) B(j, b) C(k, c) T(a, b, c), computed one
+  // slice a of T at a time
+  std::vector<Eigen::MatrixXd> slices(A.rows(),
+                                      Eigen::MatrixXd::Zero(B.rows(), C.rows()));
+  Eigen::MatrixXd T1(T->shape[1], C.rows());
+  for (int a = 0; a < T->shape[0]; ++a)
+  {
+    if (T->offsets[a] == T->offsets[a + 1])
+      continue;
+
+    T1.setZero();
+    for (int n = T->offsets[a]; n < T->offsets[a + 1]; ++n)
+      T1.row(T->j[n]) += T->values[n] * C.col(T->k[n]).transpose();
+    const Eigen::MatrixXd T2 = B * T1;
+    for (int i = 0; i < A.rows(); ++i)
+      slices[i] += A(i, a) * T2;
+  }
+
+  double max = 0.0;
+  for (const Eigen::MatrixXd& slice : slices)
+    max = std::max(max, slice.cwiseAbs().maxCoeff());
+
+  auto tensor = std::make_shared<Tensor>();
+  tensor->shape = {static_cast<int>(A.rows()), static_cast<int>(B.rows()),
+                   static_cast<int>(C.rows())};
+  tensor->offsets = {0};
+  for (const Eigen::MatrixXd& slice : slices)
+    append_slice(*tensor, slice, zero_tol * max);
+
+  return element_cache.insert(key, tensor);
+}
+//-----------------------------------------------------------------------------
+void triple_product::contract(const Tensor& tensor,
+                              const Eigen::Ref<const Eigen::MatrixXd>& u,
+                              const Eigen::Ref<const Eigen::MatrixXd>& v,
+                              Eigen::Ref<Eigen::MatrixXd> r)
+{
+  if (u.cols() != tensor.shape[1] or v.cols() != tensor.shape[2]
+      or r.cols() != tensor.shape[0])
+  {
+    throw std::runtime_error("Coefficients do not match tensor");
+  }
+  if (v.rows() != u.rows() or r.rows() != u.rows())
+    throw std::runtime_error("Different numbers of cells");
+
+  // Each entry updates a column of r for all cells at once
+  r.setZero();
+  for (int i = 0; i < tensor.shape[0]; ++i)
+  {
+    for (int n = tensor.offsets[i]; n < tensor.offsets[i + 1]; ++n)
+    {
+      r.col(i).array() += tensor.values[n]
+                          * u.col(tensor.j[n]).array()
+                          * v.col(tensor.k[n]).array();
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void triple_product::clear_cache()
+{
+  polyset_cache.clear();
+  element_cache.clear();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,99 @@
+// Copyright (c) 2020 Chris Richardson
+// FEniCS Project
+// SPDX-License-Identifier:    MIT
+
+#pragma once
+
+#include "cell.h"
+#include <Eigen/Dense>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace libtab
+{
+
+class FiniteElement;
+
+/// ## Triple products
+/// Integrals over the reference cell of the product of three functions,
+/// as needed for quadratic nonlinearities. For the orthonormal expansion
+/// set most of these vanish, so they are stored as sparse tensors. The
+/// tensors are computed once (with a quadrature rule which is exact for
+/// the product) and cached. The caches of expansion set tensors and of
+/// element tensors each keep the cache_capacity most recently used
+/// tensors.
+namespace triple_product
+{
+
+/// Maximum number of tensors in each cache
+constexpr std::size_t cache_capacity = 64;
+
+/// Sparse tensor of rank 3, stored in compressed sparse fiber format
+/// compressed along the first axis: the nonzero entries with first index
+/// i are (i, j[n], k[n]) = values[n] for offsets[i] <= n < offsets[i + 1],
+/// sorted by j then k.
+struct Tensor
+{
+  /// Extent of each axis
+  std::array<int, 3> shape;
+
+  /// Offsets of the entries with each first index
+  std::vector<int> offsets;
+
+  /// Second and third indices of the entries
+  std::vector<int> j, k;
+
+  /// Values of the entries
+  std::vector<double> values;
+
+  /// Number of nonzero entries
+  int nnz() const;
+
+  /// The entries in coordinate (COO) format
+  /// @return First, second and third indices, and values of the entries
+  std::tuple<std::vector<int>, std::vector<int>, std::vector<int>,
+             std::vector<double>>
+  coo() const;
+};
+
+/// Integrals of the product of three members of the expansion sets of
+/// degrees n0, n1 and n2 on a cell (see polyset::tabulate)
+/// @param[in] celltype The cell type
+/// @param[in] n0 Degree of the expansion set of the first index
+/// @param[in] n1 Degree of the expansion set of the second index
+/// @param[in] n2 Degree of the expansion set of the third index
+/// @return The tensor, shared with the cache
+std::shared_ptr<const Tensor> polyset(cell::type celltype, int n0, int n1,
+                                      int n2);
+
+/// Integrals of the product of three basis functions of scalar elements
+/// on the same cell, computed by applying the coefficients of the
+/// elements to the expansion set tensor
+/// @param[in] e0 The element of the first index
+/// @param[in] e1 The element of the second index
+/// @param[in] e2 The element of the third index
+/// @return The tensor, shared with the cache
+std::shared_ptr<const Tensor> element(const FiniteElement& e0,
+                                      const FiniteElement& e1,
+                                      const FiniteElement& e2);
+
+/// Contract a tensor with two functions on each of a batch of cells:
+/// r(c, i) = sum_jk T(i, j, k) u(c, j) v(c, k)
+/// @param[in] tensor The tensor T
+/// @param[in] u Coefficients of the second index, of shape (number of
+/// cells, shape[1])
+/// @param[in] v Coefficients of the third index, of shape (number of
+/// cells, shape[2])
+/// @param[out] r Result, of shape (number of cells, shape[0])
+void contract(const Tensor& tensor, const Eigen::Ref<const Eigen::MatrixXd>& u,
+              const Eigen::Ref<const Eigen::MatrixXd>& v,
+              Eigen::Ref<Eigen::MatrixXd> r);
+
+/// Discard all cached tensors
+void clear_cache();
+
+} // namespace triple_product
+} // namespace libtab
@@ -3,17 +3,29 @@
 // SPDX-License-Identifier:    MIT
 
 #include <pybind11/eigen.h>
+#include <pybind11/functional.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <cstdint>
 #include <string>
 
 #include "cell.h"
+#include "compressed-table.h"
+#include "dg-operators.h"
 #include "indexing.h"
 #include "lattice.h"
 #include "libtab.h"
+#include "linalg.h"
+#include "memory.h"
+#include "moment-fitting.h"
+#include "orientation.h"
+#include "parallel.h"
 #include "polyset.h"
 #include "quadrature.h"
+#include "symmetric-tensor.h"
+#include "tabulation-plan.h"
+#include "triple-product.h"
 
 // TODO: remove, not in public interface
 #include "crouzeix-raviart.h"
@@ -25,6 +37,162 @@
 namespace py = pybind11;
 using namespace libtab;
 
+namespace
+{
+// Read-only numpy view of dof data held by an element, which keeps the
+// element alive
+py::array_t<int> dof_view(py::object element, const std::vector<int>& data)
+{
+  py::array_t<int> a(data.size(), data.data(), element);
+  a.attr("setflags")(py::arg("write") = false);
+  return a;
+}
+
+// Numpy array of the given shape using the memory of a buffer, which it
+// takes ownership of
+py::array_t<double> buffer_array(memory::Buffer buffer,
+                                 const std::vector<py::ssize_t>& shape)
+{
+  auto b = new memory::Buffer(std::move(buffer));
+  py::capsule owner(b, [](void* p) { delete static_cast<memory::Buffer*>(p); });
+  return py::array_t<double>(shape, b->data(), owner);
+}
+
+// Pointer to the values of an output array, after checking that it can
+// be written in place
+double* output_data(py::array& out, std::size_t size)
+{
+  if (!out.dtype().is(py::dtype::of<double>())
+      or !(out.flags() & py::array::c_style) or !out.writeable())
+  {
+    throw std::runtime_error(
+        "Output must be a writeable C-contiguous array of doubles");
+  }
+  if (static_cast<std::size_t>(out.size()) != size)
+    throw std::runtime_error("Output has the wrong size");
+  return static_cast<double*>(out.mutable_data());
+}
+
+// The basis functions and their derivatives up to order nd (1 or 2),
+// computed in one pass with dual numbers, in the order of
+// FiniteElement::tabulate
+template <int N>
+std::vector<Eigen::ArrayXXd> tabulate_dual(const FiniteElement& element,
+                                           int nd, const Eigen::ArrayXXd& x)
+{
+  if (nd == 1)
+  {
+    const polyset::Table<Dual<N>> r
+        = element.tabulate_values(dual::variables<N>(x));
+    std::vector<Eigen::ArrayXXd> tables = {dual::values(r)};
+    for (int k = 0; k < N; ++k)
+      tables.push_back(dual::derivatives(r, k));
+    return tables;
+  }
+  if (nd != 2)
+    throw std::runtime_error("Dual numbers give first or second derivatives");
+
+  using D2 = Dual<N, Dual<N>>;
+  const polyset::Table<D2> r
+      = element.tabulate_values(dual::second_order_variables<N>(x));
+  std::vector<Eigen::ArrayXXd> tables((N + 1) * (N + 2) / 2);
+  tables[0] = r.unaryExpr([](const D2& f) { return f.value().value(); });
+  for (int i = 0; i < N; ++i)
+  {
+    tables[1 + i]
+        = r.unaryExpr([i](const D2& f) { return f.value().derivative(i); });
+    for (int j = i; j < N; ++j)
+    {
+      // Index of the derivative in directions i and j
+      std::array<int, 3> d = {0, 0, 0};
+      ++d[i];
+      ++d[j];
+      const int k = N == 1 ? idx(d[0])
+                           : (N == 2 ? idx(d[0], d[1]) : idx(d[0], d[1], d[2]));
+      tables[k] = dual::second_derivatives(r, i, j);
+    }
+  }
+  return tables;
+}
+
+// Tabulate a batch of point sets, stored one after the other in the rows
+// of a row-major (npoints, tdim) array, with one plan for all of them. The
+// result has shape (nderivs, *batch_shape, value_size * ndofs), where
+// batch_shape is the shape of the points without the last axis, so that
+// the values at each point set are contiguous and have the columns of
+// FiniteElement::tabulate.
+py::array_t<double> tabulate_batch(const FiniteElement& element, int nd,
+                                   const double* x, int npoints,
+                                   const std::vector<py::ssize_t>& batch_shape,
+                                   int nthreads)
+{
+  // Point, component and dof axes in row-major order
+  const TabulationPlan::layout layout
+      = {TabulationPlan::axis::derivative, TabulationPlan::axis::point,
+         TabulationPlan::axis::component, TabulationPlan::axis::dof};
+  const int tdim = cell::topological_dimension(element.cell_type());
+
+  memory::Buffer values;
+  std::array<int, 4> shape;
+  {
+    py::gil_scoped_release release;
+    TabulationPlan plan(element, npoints, nd, nthreads, -1, false, layout);
+    shape = plan.shape();
+    values = memory::Buffer(plan.size());
+    if (npoints > 0)
+      plan.execute(TabulationPlan::Points::row_major(x, tdim), values.data());
+  }
+
+  std::vector<py::ssize_t> result_shape = {shape[0]};
+  result_shape.insert(result_shape.end(), batch_shape.begin(),
+                      batch_shape.end());
+  result_shape.push_back(shape[2] * shape[3]);
+  return buffer_array(std::move(values), result_shape);
+}
+
+// A SymmetricTableView of a numpy array, which holds a reference to the
+// array so that the array lives as long as the Python object
+class SymmetricTables
+{
+public:
+  SymmetricTables(const py::array_t<double>& table, int ndofs, int n)
+      : _table(table), _view(map(table), ndofs, n)
+  {
+  }
+
+  // A view of the array, with the array as its base
+  py::array entry(int i, int j) const
+  {
+    const SymmetricTableView::Block block = _view.entry(i, j);
+    return py::array_t<double>({block.rows(), block.cols()},
+                               {_table.strides(0), _table.strides(1)},
+                               block.data(), _table);
+  }
+
+  double value(int point, int dof, int i, int j) const
+  {
+    return _view(point, dof, i, j);
+  }
+
+  Eigen::ArrayXXd expand() const { return _view.expand(); }
+
+private:
+  static SymmetricTableView::Table map(const py::array_t<double>& table)
+  {
+    if (table.ndim() != 2)
+      throw std::runtime_error("Table must be a 2D array");
+    const py::ssize_t size = sizeof(double);
+    return SymmetricTableView::Table(
+        table.data(), table.shape(0), table.shape(1),
+        Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(
+            table.strides(1) / size, table.strides(0) / size));
+  }
+
+  py::array_t<double> _table;
+  SymmetricTableView _view;
+};
+} // namespace
+
 const std::string tabdoc = R"(
 Tabulate the finite element basis function and derivatives at points.
 If no derivatives are required, use nderiv=0. In 2D and 3D, the derivatives are ordered
@@ -38,6 +206,18 @@ nderiv : int
 points : numpy.ndarray
     Array of points
 
+nthreads : int
+    Number of threads used within the tabulation (default 1)
+
+block_size : int
+    Number of points tabulated at once. Use 0 for all points, or -1 (the default) to
+    choose tiles that fit in the L2 cache.
+
+coordinates : Coordinates
+    Coordinates in which the points are given (default Coordinates.cartesian). On a simplex,
+    use Coordinates.barycentric to pass the barycentric coordinates of the points, with one
+    column per vertex. The derivatives are with respect to the reference Cartesian coordinates.
+
 Returns
 =======
 List[numpy.ndarray]
@@ -95,18 +275,495 @@ Each element has a `tabulate` function which returns the basis functions and a n
       },
       "Create an element from basic data");
 
+  py::enum_<polyset::coordinates>(m, "Coordinates")
+      .value("cartesian", polyset::coordinates::cartesian)
+      .value("barycentric", polyset::coordinates::barycentric);
+
   py::class_<FiniteElement>(m, "FiniteElement", "Finite Element")
-      .def("tabulate", &FiniteElement::tabulate, tabdoc.c_str())
+      .def("tabulate", &FiniteElement::tabulate, tabdoc.c_str(),
+           py::arg("nderiv"), py::arg("points"), py::arg("nthreads") = 1,
+           py::arg("block_size") = -1,
+           py::arg("coordinates") = polyset::coordinates::cartesian)
+      .def("tabulate_compact", &FiniteElement::tabulate_compact,
+           "Tabulate as FiniteElement.tabulate, with a block only for each "
+           "stored value component (the independent components of symmetric "
+           "tensors). Block value_map[i] holds the values of component i.",
+           py::arg("nderiv"), py::arg("points"), py::arg("nthreads") = 1,
+           py::arg("block_size") = -1)
+      .def(
+          "tabulate_dual",
+          [](const FiniteElement& self, const Eigen::ArrayXXd& x, int nd) {
+            switch (cell::topological_dimension(self.cell_type()))
+            {
+            case 1:
+              return tabulate_dual<1>(self, nd, x);
+            case 2:
+              return tabulate_dual<2>(self, nd, x);
+            default:
+              return tabulate_dual<3>(self, nd, x);
+            }
+          },
+          "Tabulate the basis functions and their derivatives up to order "
+          "nderiv (1 or 2), as FiniteElement.tabulate(nderiv, points), by "
+          "forward-mode automatic differentiation with dual numbers. The "
+          "second derivatives use nested dual numbers.",
+          py::arg("points"), py::arg("nderiv") = 1)
+      .def(
+          "tabulate_batch",
+          [](const FiniteElement& self, int nd,
+             const py::array_t<double, py::array::c_style
+                                           | py::array::forcecast>& x,
+             py::object offsets, int nthreads) {
+            const int tdim = cell::topological_dimension(self.cell_type());
+            if (x.ndim() < 2 or x.shape(x.ndim() - 1) != tdim)
+            {
+              throw std::runtime_error(
+                  "Points must have shape (..., npoints, tdim)");
+            }
+            const int npoints = static_cast<int>(x.size() / tdim);
+            std::vector<py::ssize_t> batch_shape(x.shape(),
+                                                 x.shape() + x.ndim() - 1);
+
+            if (offsets.is_none())
+            {
+              // Point sets of the same size, along the leading axes
+              const py::ssize_t n = batch_shape.back();
+              const py::ssize_t nsets = n > 0 ? npoints / n : 0;
+              py::array_t<std::int64_t> o(nsets + 1);
+              for (py::ssize_t i = 0; i < nsets + 1; ++i)
+                o.mutable_at(i) = i * n;
+              return py::make_tuple(tabulate_batch(self, nd, x.data(), npoints,
+                                                   batch_shape, nthreads),
+                                    o);
+            }
+
+            // Ragged point sets, given by ranges of rows
+            if (x.ndim() != 2)
+            {
+              throw std::runtime_error(
+                  "Ragged points must have shape (npoints, tdim)");
+            }
+            using offset_array
+                = py::array_t<std::int64_t,
+                              py::array::c_style | py::array::forcecast>;
+            offset_array o = offsets.cast<offset_array>();
+            if (o.ndim() != 1 or o.size() == 0 or o.at(0) != 0
+                or o.at(o.size() - 1) != npoints)
+            {
+              throw std::runtime_error(
+                  "Offsets must run from 0 to the number of points");
+            }
+            for (py::ssize_t i = 1; i < o.size(); ++i)
+            {
+              if (o.at(i) < o.at(i - 1))
+                throw std::runtime_error("Offsets must not decrease");
+            }
+            return py::make_tuple(tabulate_batch(self, nd, x.data(), npoints,
+                                                 batch_shape, nthreads),
+                                  o);
+          },
+          "Tabulate at a batch of point sets in one call, with the GIL "
+          "released. The points are either an array of shape (..., npoints, "
+          "tdim) or, if offsets are given, an array of shape (npoints, tdim) "
+          "holding point sets one after the other, where set i is rows "
+          "offsets[i] to offsets[i + 1]. Returns the values, of shape "
+          "(nderivs, ..., npoints, value_size * ndofs) with the columns of "
+          "FiniteElement.tabulate, and the offsets of the point sets in the "
+          "flattened points.",
+          py::arg("nderiv"), py::arg("points"),
+          py::arg("offsets") = py::none(), py::arg("nthreads") = 1)
+      .def(
+          "tabulate_cached",
+          [](const FiniteElement& self, int nd, const Eigen::ArrayXXd& x,
+             int nthreads) {
+            // The arrays view the cached tables, which are kept alive (and
+            // must not be modified) while any of the arrays exist
+            auto tables = new tabulation_cache::tables(
+                self.tabulate_cached(nd, x, nthreads));
+            py::capsule base(tables, [](void* p) {
+              delete static_cast<tabulation_cache::tables*>(p);
+            });
+            py::list result;
+            for (const Eigen::ArrayXXd& t : **tables)
+            {
+              py::array_t<double> a(
+                  {t.rows(), t.cols()},
+                  {sizeof(double), sizeof(double) * t.rows()}, t.data(), base);
+              a.attr("setflags")(py::arg("write") = false);
+              result.append(a);
+            }
+            return result;
+          },
+          "Tabulate as FiniteElement.tabulate, reusing (read-only) tables "
+          "from an earlier call with identical points",
+          py::arg("nderiv"), py::arg("points"), py::arg("nthreads") = 1)
+      .def(
+          "tabulate_cached_compressed",
+          [](const FiniteElement& self, int nd, const Eigen::ArrayXXd& x,
+             CompressedTable::format storage, int nthreads) {
+            // Each table shares ownership of the cached tables. They are
+            // only used through const methods.
+            auto tables = std::const_pointer_cast<std::vector<CompressedTable>>(
+                self.tabulate_cached(nd, x, storage, nthreads));
+            std::vector<std::shared_ptr<CompressedTable>> result;
+            for (CompressedTable& t : *tables)
+              result.emplace_back(tables, &t);
+            return result;
+          },
+          "Tabulate as FiniteElement.tabulate_cached, with the tables stored "
+          "in a 16-bit format in the cache. Returns a CompressedTable for "
+          "each derivative.",
+          py::arg("nderiv"), py::arg("points"), py::arg("format"),
+          py::arg("nthreads") = 1)
+      .def("entity_dof_offsets",
+           [](py::object self, int dim) {
+             return dof_view(self,
+                             self.cast<const FiniteElement&>()
+                                 .entity_dof_offsets(dim));
+           },
+           "CSR offsets of the dofs of each entity of dimension dim",
+           py::arg("dim"))
+      .def("entity_dof_indices",
+           [](py::object self, int dim) {
+             return dof_view(self,
+                             self.cast<const FiniteElement&>()
+                                 .entity_dof_indices(dim));
+           },
+           "Dofs of each entity of dimension dim, in CSR format",
+           py::arg("dim"))
+      .def("entity_closure_dof_offsets",
+           [](py::object self, int dim) {
+             return dof_view(self,
+                             self.cast<const FiniteElement&>()
+                                 .entity_closure_dof_offsets(dim));
+           },
+           "CSR offsets of the dofs of the closure of each entity of "
+           "dimension dim",
+           py::arg("dim"))
+      .def("entity_closure_dof_indices",
+           [](py::object self, int dim) {
+             return dof_view(self,
+                             self.cast<const FiniteElement&>()
+                                 .entity_closure_dof_indices(dim));
+           },
+           "Dofs of the closure of each entity of dimension dim, in CSR "
+           "format",
+           py::arg("dim"))
+      .def_property_readonly(
+          "interior_dofs",
+          [](py::object self) {
+            return dof_view(self,
+                            self.cast<const FiniteElement&>().interior_dofs());
+          },
+          "Dofs associated with the interior of the cell")
+      .def_property_readonly(
+          "interface_dofs",
+          [](py::object self) {
+            return dof_view(self,
+                            self.cast<const FiniteElement&>().interface_dofs());
+          },
+          "Dofs associated with the boundary of the cell")
+      .def_property_readonly("points", &FiniteElement::points,
+                             "Points at which the dofs are evaluated")
+      .def_property_readonly("differentiation_matrices",
+                             &FiniteElement::differentiation_matrices,
+                             "Nodal differentiation matrix in each direction")
+      .def(
+          "differentiate",
+          [](const FiniteElement& self, int direction,
+             const Eigen::MatrixXd& u) {
+            Eigen::MatrixXd du(u.rows(), u.cols());
+            self.differentiate(direction, u, du);
+            return du;
+          },
+          "Derivatives at the dof points of functions given by their values "
+          "at the dof points, with one column per function",
+          py::arg("direction"), py::arg("values"))
+      .def_property_readonly("id", &FiniteElement::id)
       .def_property_readonly("base_permutations",
                              &FiniteElement::base_permutations)
+      .def_property_readonly("coefficients", &FiniteElement::coefficients)
       .def_property_readonly("degree", &FiniteElement::degree)
       .def_property_readonly("cell_type", &FiniteElement::cell_type)
       .def_property_readonly("dim", &FiniteElement::dim)
       .def_property_readonly("entity_dofs", &FiniteElement::entity_dofs)
       .def_property_readonly("value_size", &FiniteElement::value_size)
       .def_property_readonly("value_shape", &FiniteElement::value_shape)
+      .def_property_readonly("symmetric", &FiniteElement::symmetric)
+      .def_property_readonly("stored_value_size",
+                             &FiniteElement::stored_value_size)
+      .def_property_readonly("value_map", &FiniteElement::value_map)
       .def_property_readonly("family_name", &FiniteElement::family_name);
 
+  py::class_<TabulationPlan> plan(
+      m, "TabulationPlan",
+      "Plan for tabulating an element at a fixed number of points");
+  py::enum_<TabulationPlan::engine>(plan, "Engine")
+      .value("direct", TabulationPlan::engine::direct)
+      .value("blocked", TabulationPlan::engine::blocked);
+  py::enum_<TabulationPlan::axis>(plan, "Axis")
+      .value("derivative", TabulationPlan::axis::derivative)
+      .value("point", TabulationPlan::axis::point)
+      .value("dof", TabulationPlan::axis::dof)
+      .value("component", TabulationPlan::axis::component);
+  plan.def(py::init<const FiniteElement&, int, int, int, int, bool,
+                    const TabulationPlan::layout&, bool>(),
+           py::arg("element"), py::arg("npoints"), py::arg("nderiv"),
+           py::arg("nthreads") = 1, py::arg("block_size") = -1,
+           py::arg("measure") = false,
+           py::arg("layout") = TabulationPlan::default_layout,
+           py::arg("compact") = false)
+      .def(
+          "execute",
+          [](const TabulationPlan& self, const Eigen::ArrayXXd& x) {
+            std::vector<Eigen::ArrayXXd> tables;
+            {
+              py::gil_scoped_release release;
+              self.execute(x, tables);
+            }
+            return tables;
+          },
+          "Tabulate at the points, as FiniteElement.tabulate",
+          py::arg("points"))
+      .def(
+          "execute_array",
+          [](const TabulationPlan& self, const py::array_t<double>& x,
+             py::object out, memory::numa_policy policy,
+             polyset::coordinates coords) {
+            // Read the points in place, whatever their strides
+            if (x.ndim() != 2)
+              throw std::runtime_error("Points must be a 2D array");
+            if (x.shape(1) != self.num_coordinates(coords))
+              throw std::runtime_error("Point dim does not match element dim.");
+            if (x.shape(0) != self.num_points())
+              throw std::runtime_error("Number of points does not match plan.");
+            TabulationPlan::Points points;
+            if (x.shape(0) > 0)
+            {
+              for (py::ssize_t c = 0; c < x.shape(1); ++c)
+                points.coordinates[c] = x.data(0, c);
+              points.stride = x.strides(0) / sizeof(double);
+            }
+
+            // A new output is left untouched until the threads write their
+            // tiles, so that its pages are placed on their NUMA nodes
+            py::array values;
+            if (out.is_none())
+            {
+              const std::array<int, 4> shape = self.shape();
+              values = buffer_array(
+                  memory::Buffer(self.size(), policy),
+                  std::vector<py::ssize_t>(shape.begin(), shape.end()));
+            }
+            else
+              values = out.cast<py::array>();
+            double* v = output_data(values, self.size());
+            {
+              py::gil_scoped_release release;
+              self.execute(points, v, coords);
+            }
+            return values;
+          },
+          "Tabulate at the points, returning an array with the axes in the "
+          "order of the layout of the plan. The values are written into out "
+          "if it is given, and otherwise into a new array whose pages are "
+          "placed on NUMA nodes by the given policy. The points have one "
+          "column per topological dimension, or per vertex for barycentric "
+          "coordinates.",
+          py::arg("points"), py::arg("out") = py::none(),
+          py::arg("policy") = memory::numa_policy::first_touch,
+          py::arg("coordinates") = polyset::coordinates::cartesian)
+      .def(
+          "first_touch",
+          [](const TabulationPlan& self, py::array& out) {
+            double* v = output_data(out, self.size());
+            py::gil_scoped_release release;
+            self.first_touch(v);
+          },
+          "Set an output array to zero using the threads which will write "
+          "each part of it in execute_array",
+          py::arg("out"))
+      .def_property_readonly("layout", &TabulationPlan::output_layout)
+      .def_property_readonly("engine", &TabulationPlan::engine_type)
+      .def_property_readonly("block_size", &TabulationPlan::block_size)
+      .def_property_readonly("num_points", &TabulationPlan::num_points)
+      .def_property_readonly("num_derivatives",
+                             &TabulationPlan::num_derivatives);
+
+  py::class_<CompressedTable, std::shared_ptr<CompressedTable>> compressed(
+      m, "CompressedTable",
+      "Table of basis function values stored with 16 bits per value");
+  py::enum_<CompressedTable::format>(compressed, "Format")
+      .value("float16", CompressedTable::format::float16)
+      .value("bfloat16", CompressedTable::format::bfloat16)
+      .value("scaled_int16", CompressedTable::format::scaled_int16);
+  compressed
+      .def(py::init<const Eigen::ArrayXXd&, CompressedTable::format>(),
+           py::arg("table"), py::arg("format"))
+      .def_property_readonly("shape",
+                             [](const CompressedTable& self) {
+                               return std::array<int, 2>{self.rows(),
+                                                         self.cols()};
+                             })
+      .def_property_readonly("format", &CompressedTable::storage)
+      .def_property_readonly("memory_usage", &CompressedTable::memory_usage)
+      .def("expand", &CompressedTable::expand,
+           "The values widened to double")
+      .def(
+          "contract",
+          [](const CompressedTable& self, const Eigen::MatrixXd& u) {
+            Eigen::MatrixXd r(self.rows(), u.cols());
+            {
+              py::gil_scoped_release release;
+              self.contract(u, r);
+            }
+            return r;
+          },
+          "Compute T u for coefficients u of shape (ndofs, ncells)",
+          py::arg("u"))
+      .def(
+          "contract_transpose",
+          [](const CompressedTable& self, const Eigen::MatrixXd& w) {
+            Eigen::MatrixXd r(self.cols(), w.cols());
+            {
+              py::gil_scoped_release release;
+              self.contract_transpose(w, r);
+            }
+            return r;
+          },
+          "Compute T^T w for values w of shape (npoints, ncells)",
+          py::arg("w"));
+
+  py::class_<SymmetricTables>(
+      m, "SymmetricTableView",
+      "View of a compact table of an element with symmetric tensor values "
+      "(see FiniteElement.tabulate_compact) as the tables of all n * n "
+      "entries of the tensor")
+      .def(py::init<const py::array_t<double>&, int, int>(),
+           py::arg("table"), py::arg("ndofs"), py::arg("n"))
+      .def("entry", &SymmetricTables::entry,
+           "The values of entry (i, j) of each basis function, of shape "
+           "(npoints, ndofs), as a view of the compact table",
+           py::arg("i"), py::arg("j"))
+      .def("__call__", &SymmetricTables::value,
+           "The value of entry (i, j) of a basis function at a point",
+           py::arg("point"), py::arg("dof"), py::arg("i"), py::arg("j"))
+      .def("expand", &SymmetricTables::expand,
+           "The values in the layout of FiniteElement.tabulate, with a block "
+           "for each of the n * n entries");
+
+  m.def(
+      "dg_mass_matrix",
+      [](const FiniteElement& element) { return dg::operators(element)->mass; },
+      "Mass matrix of an element on the reference cell", py::arg("element"));
+  m.def(
+      "dg_facet_mass_matrices",
+      [](const FiniteElement& element) {
+        return dg::operators(element)->facet_mass;
+      },
+      "Mass matrix of each facet of the reference cell", py::arg("element"));
+  m.def(
+      "dg_lift_matrices",
+      [](const FiniteElement& element) { return dg::operators(element)->lift; },
+      "Lifting operator (inverse mass times facet mass) of each facet",
+      py::arg("element"));
+
+  py::class_<triple_product::Tensor,
+             std::shared_ptr<triple_product::Tensor>>(
+      m, "TripleProductTensor",
+      "Sparse rank 3 tensor in compressed sparse fiber format")
+      .def_readonly("shape", &triple_product::Tensor::shape)
+      .def_readonly("offsets", &triple_product::Tensor::offsets)
+      .def_readonly("j", &triple_product::Tensor::j)
+      .def_readonly("k", &triple_product::Tensor::k)
+      .def_readonly("values", &triple_product::Tensor::values)
+      .def_property_readonly("nnz", &triple_product::Tensor::nnz)
+      .def("coo", &triple_product::Tensor::coo,
+           "Indices and values of the entries in coordinate format");
+  m.def(
+      "triple_product_polyset",
+      [](cell::type celltype, int n0, int n1, int n2) {
+        return std::const_pointer_cast<triple_product::Tensor>(
+            triple_product::polyset(celltype, n0, n1, n2));
+      },
+      "Integrals of products of three members of expansion sets",
+      py::arg("celltype"), py::arg("n0"), py::arg("n1"), py::arg("n2"));
+  m.def(
+      "triple_product_element",
+      [](const FiniteElement& e0, const FiniteElement& e1,
+         const FiniteElement& e2) {
+        return std::const_pointer_cast<triple_product::Tensor>(
+            triple_product::element(e0, e1, e2));
+      },
+      "Integrals of products of three basis functions", py::arg("e0"),
+      py::arg("e1"), py::arg("e2"));
+  m.def(
+      "contract_triple_product",
+      [](const triple_product::Tensor& tensor, const Eigen::MatrixXd& u,
+         const Eigen::MatrixXd& v) {
+        Eigen::MatrixXd r(u.rows(), tensor.shape[0]);
+        triple_product::contract(tensor, u, v, r);
+        return r;
+      },
+      "Contract a triple product tensor with two functions on each cell",
+      py::arg("tensor"), py::arg("u"), py::arg("v"));
+
+  m.def("pack_orientation", &orientation::pack,
+        "Pack edge reflections, face rotations and face reflections into "
+        "orientation bits",
+        py::arg("edge_reflections"),
+        py::arg("face_rotations") = std::vector<int>(),
+        py::arg("face_reflections") = std::vector<bool>());
+  m.def("compute_orientation", &orientation::compute,
+        "Orientation bits of a cell from the global numbers of its vertices",
+        py::arg("celltype"), py::arg("vertices"));
+  m.def("realisable_orientations", &orientation::realisable,
+        "All orientation bits arising from numberings of the vertices",
+        py::arg("celltype"));
+  m.def("orientation_transformation", &orientation::transformation,
+        "Matrix giving the effect of an orientation on the dofs",
+        py::arg("element"), py::arg("bits"));
+
+  py::class_<OrientationTables>(
+      m, "OrientationTables",
+      "Coefficients and tables of an element for each orientation")
+      .def(py::init<const FiniteElement&, int, const Eigen::ArrayXXd&,
+                    const std::vector<std::uint32_t>&, int>(),
+           py::arg("element"), py::arg("nderiv"), py::arg("points"),
+           py::arg("orientations") = std::vector<std::uint32_t>(),
+           py::arg("nthreads") = 1)
+      .def_property_readonly("orientations", &OrientationTables::orientations)
+      .def("coefficients", &OrientationTables::coefficients,
+           "Expansion coefficients for an orientation", py::arg("bits"))
+      .def("tabulate", &OrientationTables::tables,
+           "Tabulated basis functions for an orientation", py::arg("bits"));
+
+  py::class_<MomentFitting>(
+      m, "MomentFitting",
+      "Fit nonnegative quadrature rules to the polynomial moments of a "
+      "region, reusing the points of the previous fit where possible")
+      .def(py::init<cell::type, int>(), py::arg("celltype"), py::arg("degree"))
+      .def("moments", &MomentFitting::moments,
+           "Moments of the polynomial set over a subdivision into simplices",
+           py::arg("simplices"))
+      .def("fit",
+           py::overload_cast<const Eigen::VectorXd&, const Eigen::ArrayXXd&>(
+               &MomentFitting::fit),
+           "Fit a rule to moments using the candidate points",
+           py::arg("moments"), py::arg("candidates"))
+      .def("fit",
+           py::overload_cast<const std::vector<Eigen::ArrayXXd>&>(
+               &MomentFitting::fit),
+           "Fit a rule to a region given by a subdivision into simplices",
+           py::arg("simplices"))
+      .def_property_readonly("num_moments", &MomentFitting::num_moments)
+      .def_property_readonly("support", &MomentFitting::support);
+
+  m.def("make_moment_fitted_quadrature", &make_moment_fitted_quadrature,
+        "Compute a compact quadrature rule for a region given by a "
+        "subdivision into simplices",
+        py::arg("celltype"), py::arg("degree"), py::arg("simplices"));
+
   // TODO: remove - not part of public interface
   // Create FiniteElement of different types
   m.def("Nedelec", [](const std::string& cell, int degree) {
@@ -132,27 +789,198 @@ Each element has a `tabulate` function which returns the basis functions and a n
   });
 
   // Create FiniteElement
+  py::enum_<precision>(m, "Precision")
+      .value("standard", precision::standard)
+      .value("double_double", precision::double_double);
+
   m.def("create_element", &libtab::create_element,
-        "Create a FiniteElement of a given family, celltype and degree");
+        "Create a FiniteElement of a given family, celltype and degree, "
+        "optionally with its coefficients computed in double-double "
+        "arithmetic",
+        py::arg("family"), py::arg("cell"), py::arg("degree"),
+        py::arg("precision") = precision::standard);
+
+  m.def("tabulation_cache_capacity", &tabulation_cache::capacity,
+        "Maximum memory held by the tabulation cache, in bytes");
+  m.def("set_tabulation_cache_capacity", &tabulation_cache::set_capacity,
+        "Set the maximum memory held by the tabulation cache, in bytes");
+  m.def("tabulation_cache_memory_usage", &tabulation_cache::memory_usage,
+        "Memory currently held by the tabulation cache, in bytes");
+  m.def("tabulation_cache_hits", &tabulation_cache::hits,
+        "Number of tabulations served from the cache");
+  m.def("tabulation_cache_misses", &tabulation_cache::misses,
+        "Number of tabulations computed and added to the cache");
+  m.def("clear_tabulation_cache", &tabulation_cache::clear,
+        "Discard all tables in the tabulation cache");
 
   m.def("tabulate_polynomial_set", &polyset::tabulate,
-        "Tabulate orthonormal polynomial expansion set");
+        "Tabulate orthonormal polynomial expansion set", py::arg("celltype"),
+        py::arg("degree"), py::arg("nderiv"), py::arg("points"),
+        py::arg("nthreads") = 1,
+        py::arg("coordinates") = polyset::coordinates::cartesian);
+
+  m.def("tabulate_polynomial_set_by_order", &polyset::tabulate_by_order,
+        "Tabulate orthonormal polynomial expansion set in blocks of points, "
+        "passing each derivative order to a callback",
+        py::arg("celltype"), py::arg("degree"), py::arg("nderiv"),
+        py::arg("points"), py::arg("block_size"), py::arg("consumer"),
+        py::arg("nthreads") = 1,
+        py::arg("coordinates") = polyset::coordinates::cartesian);
 
   m.def("compute_jacobi_deriv", &quadrature::compute_jacobi_deriv,
         "Compute jacobi polynomial and derivatives at points");
 
+  py::enum_<quadrature::type>(m, "QuadratureType")
+      .value("gauss_jacobi", quadrature::type::gauss_jacobi)
+      .value("gauss_radau_left", quadrature::type::gauss_radau_left)
+      .value("gauss_radau_right", quadrature::type::gauss_radau_right);
+
+  // make_quadrature on a reference cell is a template, so the overloads
+  // are chosen by their function types
+  using rule = std::pair<Eigen::ArrayXXd, Eigen::ArrayXd>;
   m.def("make_quadrature",
-        py::overload_cast<const Eigen::ArrayXXd&, int>(
+        static_cast<rule (*)(const Eigen::ArrayXXd&, int)>(
             &quadrature::make_quadrature),
         "Compute quadrature points and weights on a simplex defined by points")
+      .def("make_quadrature", &quadrature::make_quadrature<double>,
+           "Compute quadrature points and weights on a reference cell")
       .def("make_quadrature",
-           py::overload_cast<cell::type, int>(&quadrature::make_quadrature),
-           "Compute quadrature points and weights on a reference cell");
+           static_cast<rule (*)(cell::type, quadrature::type, int,
+                                const std::vector<std::array<double, 2>>&)>(
+               &quadrature::make_quadrature),
+           "Compute (cached) Gauss-Jacobi or Gauss-Radau quadrature points "
+           "and weights on a reference cell, with optional weight exponents "
+           "(a, b) for (1 - x)^a x^b in each direction",
+           py::arg("celltype"), py::arg("type"), py::arg("m"),
+           py::arg("weights") = std::vector<std::array<double, 2>>());
+
+  m.def("make_reduced_quadrature", &quadrature::make_reduced_quadrature,
+        "Compute the quadrature rule with fewest points on a reference cell "
+        "that is exact for the given polynomial degree",
+        py::arg("celltype"), py::arg("degree"));
+
+  m.def("compute_gauss_jacobi_rule",
+        py::overload_cast<double, double, int>(
+            &quadrature::compute_gauss_jacobi_rule),
+        "Compute Gauss-Jacobi points and weights on the interval [-1, 1] for "
+        "the weight (1 - x)^a (1 + x)^b",
+        py::arg("a"), py::arg("b"), py::arg("m"));
+
+  m.def("compute_gauss_radau_rule", &quadrature::compute_gauss_radau_rule,
+        "Compute Gauss-Radau points and weights on the interval [-1, 1] for "
+        "the weight (1 - x)^a (1 + x)^b, including the left or right "
+        "endpoint",
+        py::arg("a"), py::arg("b"), py::arg("m"), py::arg("left") = true);
+
+  m.def("clear_quadrature_cache", &quadrature::clear_cache,
+        "Discard all cached quadrature rules");
 
   m.def("gauss_lobatto_legendre_line_rule",
         &quadrature::gauss_lobatto_legendre_line_rule,
         "Compute GLL quadrature points and weights on the interval [-1, 1]");
 
+  py::enum_<linalg::backend>(m, "LinalgBackend")
+      .value("eigen", linalg::backend::eigen)
+      .value("blas", linalg::backend::blas);
+
+  m.def("has_blas", &linalg::has_blas,
+        "Whether libtab was built with an external BLAS/LAPACK");
+  m.def("linalg_backends", &linalg::backends,
+        "Backend used for the matrix products of each shape class");
+  m.def("linalg_autotune", &linalg::autotune,
+        "Choose the faster of Eigen and BLAS for each shape class by timing "
+        "a representative product");
+
+  py::enum_<memory::numa_policy>(m, "NumaPolicy")
+      .value("first_touch", memory::numa_policy::first_touch)
+      .value("local", memory::numa_policy::local)
+      .value("interleave", memory::numa_policy::interleave);
+  m.def("has_numa", &memory::has_numa,
+        "Whether libtab was built with libnuma and the system supports it");
+  m.def("num_numa_nodes", &memory::num_numa_nodes, "Number of NUMA nodes");
+  m.def(
+      "numa_empty",
+      [](const std::vector<py::ssize_t>& shape, memory::numa_policy policy) {
+        std::size_t size = 1;
+        for (py::ssize_t n : shape)
+          size *= n;
+        return buffer_array(memory::Buffer(size, policy), shape);
+      },
+      "Uninitialised array of doubles whose pages have not been touched, "
+      "so that they are placed by the given policy",
+      py::arg("shape"), py::arg("policy") = memory::numa_policy::first_touch);
+  m.def(
+      "numa_page_nodes",
+      [](const py::array& a) {
+        // One entry for each page of the array
+        const char* data = static_cast<const char*>(a.data());
+        std::vector<int> nodes;
+        const py::ssize_t page = memory::page_size();
+        for (py::ssize_t b = 0; b < a.nbytes(); b += page)
+          nodes.push_back(memory::numa_node(data + b));
+        return nodes;
+      },
+      "NUMA node of each page of a contiguous array (-1 if not known)",
+      py::arg("array"));
+  m.def("page_size", &memory::page_size, "Size of a page in bytes");
+  py::enum_<memory::huge_page_policy>(m, "HugePagePolicy")
+      .value("none", memory::huge_page_policy::none)
+      .value("transparent", memory::huge_page_policy::transparent)
+      .value("hugetlb", memory::huge_page_policy::hugetlb);
+  m.def("set_huge_page_policy", &memory::set_huge_page_policy,
+        "Set the use of huge pages for large buffers allocated from now on",
+        py::arg("policy"));
+  m.def("get_huge_page_policy", &memory::get_huge_page_policy,
+        "The use of huge pages for large buffers");
+
+  // An invalid LIBTAB_HUGE_PAGES is ignored by libtab, and reported here
+  // through Python's warnings
+  const std::string huge_pages_env = memory::invalid_huge_page_environment();
+  if (!huge_pages_env.empty())
+  {
+    const std::string msg = "Ignoring invalid value of LIBTAB_HUGE_PAGES: "
+                            + huge_pages_env
+                            + " (expected none, transparent or hugetlb)";
+    if (PyErr_WarnEx(PyExc_RuntimeWarning, msg.c_str(), 1) < 0)
+      throw py::error_already_set();
+  }
+
+  m.def(
+      "set_executor",
+      [](py::object run) {
+        if (run.is_none())
+        {
+          parallel::set_executor(nullptr);
+          return;
+        }
+
+        // The Python function must be released with the GIL held
+        std::shared_ptr<py::object> fn(new py::object(run), [](py::object* f) {
+          py::gil_scoped_acquire acquire;
+          delete f;
+        });
+        parallel::set_executor(std::make_shared<parallel::FunctionExecutor>(
+            [fn](int n, int nthreads, const std::function<void(int)>& f) {
+              py::gil_scoped_acquire acquire;
+              py::cpp_function task([&f](int i) {
+                py::gil_scoped_release release;
+                f(i);
+              });
+              (*fn)(n, nthreads, task);
+            }));
+      },
+      "Run parallel regions on an external thread pool. The function "
+      "run(n, nthreads, task) must call task(i) for each i in range(n) and "
+      "return when all have completed, e.g. "
+      "lambda n, nthreads, task: list(pool.map(task, range(n))) for a "
+      "concurrent.futures.ThreadPoolExecutor. Pass None to use the built-in "
+      "work-stealing pool.",
+      py::arg("run"));
+
+  // Drop a Python executor while the interpreter is still alive
+  py::module::import("atexit").attr("register")(
+      py::cpp_function([]() { parallel::set_executor(nullptr); }));
+
   m.def("index", py::overload_cast<int>(&libtab::idx), "Indexing for 1D arrays")
       .def("index", py::overload_cast<int, int>(&libtab::idx),
            "Indexing for triangular arrays")
@@ -0,0 +1,46 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+def random_points(tdim, npoints):
+    x = numpy.random.rand(npoints, tdim) / tdim
+    return x, numpy.hstack([1.0 - numpy.sum(x, axis=1, keepdims=True), x])
+
+
+@pytest.mark.parametrize("cell", [libtab.CellType.interval, libtab.CellType.triangle,
+                                  libtab.CellType.tetrahedron])
+@pytest.mark.parametrize("degree", [0, 1, 4])
+def test_polyset(cell, degree):
+    tdim = len(libtab.geometry(cell)[0])
+    x, lam = random_points(tdim, 20)
+    tables = libtab.tabulate_polynomial_set(cell, degree, 3, x)
+    bary = libtab.tabulate_polynomial_set(cell, degree, 3, lam, coordinates=libtab.Coordinates.barycentric)
+    assert len(bary) == len(tables)
+    for t, b in zip(tables, bary):
+        assert numpy.allclose(t, b)
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "interval", 3), ("Lagrange", "triangle", 3),
+                                                  ("Lagrange", "tetrahedron", 3),
+                                                  ("Raviart-Thomas", "triangle", 2),
+                                                  ("Nedelec 1st kind H(curl)", "tetrahedron", 2)])
+@pytest.mark.parametrize("block_size", [0, 8])
+def test_element(family, cell, degree, block_size):
+    element = libtab.create_element(family, cell, degree)
+    tdim = len(libtab.geometry(element.cell_type)[0])
+    x, lam = random_points(tdim, 30)
+    tables = element.tabulate(2, x, block_size=block_size)
+    bary = element.tabulate(2, lam, block_size=block_size, coordinates=libtab.Coordinates.barycentric)
+    for t, b in zip(tables, bary):
+        assert numpy.allclose(t, b)
+
+
+def test_not_simplex():
+    element = libtab.create_element("Lagrange", "quadrilateral", 1)
+    with pytest.raises(RuntimeError):
+        element.tabulate(0, numpy.full((1, 3), 1.0 / 3.0), coordinates=libtab.Coordinates.barycentric)
@@ -0,0 +1,56 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+def random_points(cell, shape):
+    tdim = len(libtab.geometry(libtab.CellType.__members__[cell])[0])
+    return numpy.random.rand(*shape, tdim) / tdim
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "interval", 3), ("Lagrange", "triangle", 3),
+                                                  ("Lagrange", "hexahedron", 2),
+                                                  ("Nedelec 1st kind H(curl)", "tetrahedron", 2),
+                                                  ("Regge", "triangle", 1)])
+def test_broadcast(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    pts = random_points(cell, (4, 3, 5))
+    values, offsets = element.tabulate_batch(1, pts)
+
+    assert values.shape[1:4] == (4, 3, 5)
+    assert numpy.allclose(offsets, numpy.arange(13) * 5)
+    for i in range(4):
+        for j in range(3):
+            for t, v in zip(element.tabulate(1, pts[i, j]), values[:, i, j]):
+                assert numpy.allclose(t, v)
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "triangle", 3),
+                                                  ("Raviart-Thomas", "tetrahedron", 2)])
+def test_ragged(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    sizes = [3, 0, 7, 1, 12]
+    offsets = numpy.concatenate([[0], numpy.cumsum(sizes)])
+    pts = random_points(cell, (offsets[-1], ))
+    values, out_offsets = element.tabulate_batch(2, pts, offsets, nthreads=2)
+
+    assert numpy.allclose(out_offsets, offsets)
+    for i in range(len(sizes)):
+        if sizes[i] == 0:
+            continue
+        tables = element.tabulate(2, pts[offsets[i]:offsets[i + 1]])
+        for t, v in zip(tables, values[:, offsets[i]:offsets[i + 1]]):
+            assert numpy.allclose(t, v)
+
+
+def test_bad_offsets():
+    element = libtab.create_element("Lagrange", "triangle", 1)
+    pts = random_points("triangle", (10, ))
+    with pytest.raises(RuntimeError):
+        element.tabulate_batch(0, pts, [0, 5, 4, 10])
+    with pytest.raises(RuntimeError):
+        element.tabulate_batch(0, pts, [0, 5, 9])
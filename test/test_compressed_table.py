@@ -0,0 +1,48 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+Format = libtab.CompressedTable.Format
+
+
+def error_bound(table, format):
+    # Largest error of each stored value
+    if format == Format.float16:
+        return numpy.maximum(numpy.abs(table) * 2.0 ** -11, 2.0 ** -25)
+    elif format == Format.bfloat16:
+        return numpy.abs(table) * 2.0 ** -8 * (1 + 1e-6)
+    return numpy.broadcast_to(numpy.max(numpy.abs(table), axis=0) / 65534 * (1 + 1e-12), table.shape)
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "triangle", 4), ("Lagrange", "tetrahedron", 3),
+                                                  ("Nedelec 1st kind H(curl)", "tetrahedron", 2),
+                                                  ("Lagrange", "quadrilateral", 3)])
+@pytest.mark.parametrize("format", [Format.float16, Format.bfloat16, Format.scaled_int16])
+def test_compressed_table(family, cell, degree, format):
+    element = libtab.create_element(family, cell, degree)
+    pts, wts = libtab.make_quadrature(element.cell_type, degree + 2)
+    for table in element.tabulate(1, pts):
+        compressed = libtab.CompressedTable(table, format)
+        assert compressed.shape == list(table.shape)
+        assert compressed.memory_usage < table.nbytes / 3
+
+        values = compressed.expand()
+        assert numpy.all(numpy.abs(values - table) <= error_bound(table, format))
+
+        u = numpy.random.rand(table.shape[1], 7)
+        assert numpy.allclose(compressed.contract(u), values @ u)
+        w = numpy.random.rand(table.shape[0], 5)
+        assert numpy.allclose(compressed.contract_transpose(w), values.T @ w)
+
+
+def test_compressed_table_float16_values():
+    table = numpy.array([[65504.0, -3.0, 0.1, 2.0 ** -20, 0.0]])
+    values = libtab.CompressedTable(table, Format.float16).expand()
+    assert numpy.array_equal(values, numpy.array(table, dtype=numpy.float16).astype(float))
+
+    with pytest.raises(RuntimeError):
+        libtab.CompressedTable(numpy.array([[1e5]]), Format.float16)
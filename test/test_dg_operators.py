@@ -0,0 +1,47 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Discontinuous Lagrange", "triangle", 3),
+                                                  ("Lagrange", "tetrahedron", 2),
+                                                  ("Lagrange", "quadrilateral", 2),
+                                                  ("Lagrange", "hexahedron", 1),
+                                                  ("Raviart-Thomas", "triangle", 2)])
+def test_mass_matrix(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    pts, wts = libtab.make_quadrature(element.cell_type, degree + 2)
+    phi = element.tabulate(0, pts)[0]
+    n = element.dim
+    mass = sum(phi[:, j * n:(j + 1) * n].T @ numpy.diag(wts) @ phi[:, j * n:(j + 1) * n]
+               for j in range(element.value_size))
+    assert numpy.allclose(libtab.dg_mass_matrix(element), mass)
+
+
+def test_facet_mass_triangle():
+    element = libtab.create_element("Lagrange", "triangle", 1)
+    facet_mass = libtab.dg_facet_mass_matrices(element)
+    # Facet 0 joins vertices 1 and 2, and has length sqrt(2)
+    assert numpy.allclose(facet_mass[0], numpy.sqrt(2) / 6 * numpy.array([[0, 0, 0], [0, 2, 1], [0, 1, 2]]))
+    assert numpy.allclose(facet_mass[2], numpy.array([[2, 1, 0], [1, 2, 0], [0, 0, 0]]) / 6)
+
+
+@pytest.mark.parametrize("family, cell, area", [("Discontinuous Lagrange", "triangle", 2 + numpy.sqrt(2)),
+                                                ("Discontinuous Lagrange", "tetrahedron", 1.5 + numpy.sqrt(3) / 2),
+                                                ("Lagrange", "prism", 3 + numpy.sqrt(2)),
+                                                ("Lagrange", "hexahedron", 6)])
+def test_lift(family, cell, area):
+    element = libtab.create_element(family, cell, 2)
+    mass = libtab.dg_mass_matrix(element)
+    facet_mass = libtab.dg_facet_mass_matrices(element)
+    lift = libtab.dg_lift_matrices(element)
+    for m, L in zip(facet_mass, lift):
+        assert numpy.allclose(mass @ L, m)
+
+    # The basis is a partition of unity, so the entries of the facet mass
+    # matrices sum to the area of the boundary
+    assert numpy.isclose(sum(m.sum() for m in facet_mass), area)
@@ -0,0 +1,37 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "interval", 4), ("Lagrange", "triangle", 4),
+                                                  ("Lagrange", "tetrahedron", 3), ("Lagrange", "prism", 2),
+                                                  ("Lagrange", "pyramid", 2), ("Lagrange", "hexahedron", 2),
+                                                  ("Nedelec 1st kind H(curl)", "tetrahedron", 2),
+                                                  ("Regge", "triangle", 1)])
+def test_tabulate_dual(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    pts = libtab.create_lattice(element.cell_type, degree + 2, libtab.LatticeType.equispaced, True)
+    tables = element.tabulate_dual(pts)
+    expected = element.tabulate(1, pts)
+    assert len(tables) == len(expected)
+    for t, e in zip(tables, expected):
+        assert numpy.allclose(t, e)
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "interval", 4), ("Lagrange", "triangle", 4),
+                                                  ("Lagrange", "tetrahedron", 3), ("Lagrange", "prism", 2),
+                                                  ("Lagrange", "pyramid", 2), ("Lagrange", "hexahedron", 2),
+                                                  ("Nedelec 1st kind H(curl)", "tetrahedron", 2),
+                                                  ("Regge", "triangle", 1)])
+def test_tabulate_dual_second_derivatives(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    pts = libtab.create_lattice(element.cell_type, degree + 2, libtab.LatticeType.equispaced, True)
+    tables = element.tabulate_dual(pts, 2)
+    expected = element.tabulate(2, pts)
+    assert len(tables) == len(expected)
+    for t, e in zip(tables, expected):
+        assert numpy.allclose(t, e)
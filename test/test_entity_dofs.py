@@ -0,0 +1,60 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+elements = [("Lagrange", "triangle", 3), ("Lagrange", "tetrahedron", 4), ("Lagrange", "quadrilateral", 2),
+            ("Lagrange", "hexahedron", 2), ("Nedelec 1st kind H(curl)", "tetrahedron", 3),
+            ("Raviart-Thomas", "triangle", 2), ("Discontinuous Lagrange", "triangle", 2)]
+
+
+@pytest.mark.parametrize("family, cell, degree", elements)
+def test_entity_dofs(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    dof = 0
+    for dim, counts in enumerate(element.entity_dofs):
+        offsets = element.entity_dof_offsets(dim)
+        indices = element.entity_dof_indices(dim)
+        assert numpy.array_equal(numpy.diff(offsets), counts)
+        assert numpy.array_equal(indices, range(dof, dof + sum(counts)))
+        dof += sum(counts)
+    assert dof == element.dim
+
+
+@pytest.mark.parametrize("family, cell, degree", elements)
+def test_closure_dofs(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    topology = libtab.topology(element.cell_type)
+    for dim, entities in enumerate(topology):
+        offsets = element.entity_closure_dof_offsets(dim)
+        indices = element.entity_closure_dof_indices(dim)
+        for i, vertices in enumerate(entities):
+            expected = []
+            for d, sub_entities in enumerate(topology[:dim + 1]):
+                eoffsets = element.entity_dof_offsets(d)
+                for j, sub in enumerate(sub_entities):
+                    if set(sub).issubset(vertices):
+                        expected += list(element.entity_dof_indices(d)[eoffsets[j]:eoffsets[j + 1]])
+            assert numpy.array_equal(indices[offsets[i]:offsets[i + 1]], sorted(expected))
+
+    # The closure of the cell contains all the dofs
+    assert numpy.array_equal(element.entity_closure_dof_indices(len(topology) - 1), range(element.dim))
+
+
+@pytest.mark.parametrize("family, cell, degree", elements)
+def test_interior_dofs(family, cell, degree):
+    element = libtab.create_element(family, cell, degree)
+    interior = element.interior_dofs
+    interface = element.interface_dofs
+    assert len(interior) == element.entity_dofs[-1][0]
+    assert numpy.array_equal(numpy.sort(numpy.concatenate([interface, interior])), range(element.dim))
+    assert not interior.flags.writeable
+
+
+def test_view_lifetime():
+    indices = libtab.create_element("Lagrange", "triangle", 3).entity_closure_dof_indices(1)
+    assert numpy.array_equal(indices, [1, 2, 3, 4, 0, 2, 5, 6, 0, 1, 7, 8])
@@ -0,0 +1,40 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+from concurrent.futures import ThreadPoolExecutor
+
+import libtab
+import numpy as np
+
+
+def test_external_executor():
+    element = libtab.create_element("Lagrange", "tetrahedron", 3)
+    pts = np.random.rand(20, 3) / 3.0
+    reference = element.tabulate(2, pts)
+
+    calls = []
+    with ThreadPoolExecutor(4) as pool:
+        def run(n, nthreads, task):
+            calls.append(n)
+            list(pool.map(task, range(n)))
+
+        libtab.set_executor(run)
+        try:
+            tables = element.tabulate(2, pts, nthreads=4)
+            n1 = libtab.create_element("Nedelec 1st kind H(curl)", "triangle", 2)
+            o = libtab.OrientationTables(n1, 0, pts[:, :2], nthreads=4)
+            assert len(o.orientations) == 6
+        finally:
+            libtab.set_executor(None)
+
+    assert len(calls) > 0
+    for t, r in zip(tables, reference):
+        assert np.allclose(t, r)
+
+
+def test_default_executor():
+    element = libtab.create_element("Lagrange", "triangle", 4)
+    pts = np.random.rand(50, 2) / 2.0
+    for t, r in zip(element.tabulate(3, pts, nthreads=4), element.tabulate(3, pts)):
+        assert np.allclose(t, r)
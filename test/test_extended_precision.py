@@ -0,0 +1,66 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "interval", 4), ("Lagrange", "triangle", 4),
+                                                  ("Lagrange", "tetrahedron", 3),
+                                                  ("Discontinuous Lagrange", "triangle", 2),
+                                                  ("Raviart-Thomas", "triangle", 3),
+                                                  ("Raviart-Thomas", "tetrahedron", 2),
+                                                  ("Nedelec 1st kind H(curl)", "triangle", 3),
+                                                  ("Nedelec 1st kind H(curl)", "tetrahedron", 2)])
+def test_double_double(family, cell, degree):
+    standard = libtab.create_element(family, cell, degree)
+    element = libtab.create_element(family, cell, degree, libtab.Precision.double_double)
+    assert element.dim == standard.dim
+    assert element.entity_dofs == standard.entity_dofs
+    assert numpy.allclose(element.points, standard.points)
+    for p, q in zip(element.base_permutations, standard.base_permutations):
+        assert numpy.allclose(p, q)
+    assert numpy.allclose(element.coefficients, standard.coefficients)
+
+    pts, wts = libtab.make_quadrature(element.cell_type, degree + 2)
+    for t, s in zip(element.tabulate(1, pts), standard.tabulate(1, pts)):
+        assert numpy.allclose(t, s)
+
+
+def test_high_degree_lagrange():
+    # Nodal basis at the lattice points
+    degree = 12
+    element = libtab.create_element("Lagrange", "triangle", degree, libtab.Precision.double_double)
+    values = element.tabulate(0, element.points)[0]
+    assert numpy.allclose(values, numpy.eye(element.dim), atol=1e-10)
+
+
+def test_lagrange_accuracy():
+    # Compare with the equispaced Lagrange basis given by products of the
+    # barycentric coordinates, at a degree where double precision loses
+    # several digits
+    degree = 20
+    pts = numpy.random.RandomState(1).rand(100, 2) / 2
+    lam = numpy.array([1 - pts[:, 0] - pts[:, 1], pts[:, 0], pts[:, 1]])
+
+    errors = []
+    for precision in [libtab.Precision.standard, libtab.Precision.double_double]:
+        element = libtab.create_element("Lagrange", "triangle", degree, precision)
+        values = element.tabulate(0, pts)[0]
+        exact = numpy.ones_like(values)
+        for i, p in enumerate(element.points):
+            alpha = numpy.rint(degree * numpy.array([1 - p[0] - p[1], p[0], p[1]])).astype(int)
+            for j in range(3):
+                for k in range(alpha[j]):
+                    exact[:, i] *= (degree * lam[j] - k) / (alpha[j] - k)
+        errors.append(numpy.max(numpy.abs(values - exact)))
+
+    assert errors[1] < 1e-10
+    assert errors[1] < errors[0] / 100
+
+
+def test_unsupported_family():
+    with pytest.raises(RuntimeError):
+        libtab.create_element("Regge", "triangle", 1, libtab.Precision.double_double)
@@ -312,3 +312,35 @@ def test_celltypes(order, celltype):
                                 libtab.LatticeType.equispaced, True)
     w = tp.tabulate(0, pts)[0]
     assert(numpy.allclose(numpy.sum(w, axis=1), 1.0))
+
+
+@pytest.mark.parametrize("celltype", ["triangle", "tetrahedron", "hexahedron"])
+@pytest.mark.parametrize("block_size", [1, 7, 100])
+def test_tabulate_blocked(celltype, block_size):
+    lagrange = libtab.Lagrange(celltype, 3)
+    pts = libtab.create_lattice(lagrange.cell_type, 8,
+                                libtab.LatticeType.equispaced, True)
+    full = lagrange.tabulate(2, pts, block_size=0)
+    blocked = lagrange.tabulate(2, pts, block_size=block_size)
+    for a, b in zip(full, blocked):
+        assert numpy.allclose(a, b)
+
+
+@pytest.mark.parametrize("celltype", [libtab.CellType.interval, libtab.CellType.triangle,
+                                      libtab.CellType.tetrahedron, libtab.CellType.quadrilateral])
+@pytest.mark.parametrize("degree", [1, 2, 3])
+def test_differentiation_matrices(celltype, degree):
+    lagrange = libtab.create_element("Lagrange", celltype.name, degree)
+    pts = lagrange.points
+    assert pts.shape == (lagrange.dim, len(libtab.topology(celltype)) - 1)
+
+    # The values at the dof points are the identity
+    assert numpy.allclose(lagrange.tabulate(0, pts)[0], numpy.eye(lagrange.dim))
+
+    # Differentiate x^degree and (x + y + z)^degree in each cell at once
+    values = numpy.array([pts[:, 0] ** degree, pts.sum(axis=1) ** degree]).T
+    for i, D in enumerate(lagrange.differentiation_matrices):
+        du = lagrange.differentiate(i, values)
+        assert numpy.allclose(du, D @ values)
+        assert numpy.allclose(du[:, 0], degree * pts[:, 0] ** (degree - 1) if i == 0 else 0)
+        assert numpy.allclose(du[:, 1], degree * pts.sum(axis=1) ** (degree - 1))
@@ -0,0 +1,76 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import pytest
+import numpy as np
+
+
+def cut_square(a, b):
+    # Part of the unit square below the line y = a + b x
+    return [np.array([[0.0, 0.0], [1.0, 0.0], [1.0, a + b]]),
+            np.array([[0.0, 0.0], [1.0, a + b], [0.0, a]])]
+
+
+def integrate(simplices, f):
+    result = 0.0
+    for s in simplices:
+        pts, wts = libtab.make_quadrature(s, 8)
+        result += sum(abs(wts) * f(pts))
+    return result
+
+
+@pytest.mark.parametrize("degree", [1, 2, 4, 6])
+def test_cut_square(degree):
+    simplices = cut_square(0.3, 0.4)
+    pts, wts = libtab.make_moment_fitted_quadrature(libtab.CellType.triangle, degree, simplices)
+
+    nmoments = (degree + 1) * (degree + 2) // 2
+    assert len(wts) <= nmoments
+    assert min(wts) > 0
+    for i in range(degree + 1):
+        for j in range(degree + 1 - i):
+            def f(x):
+                return x[:, 0]**i * x[:, 1]**j
+            assert np.isclose(sum(wts * f(pts)), integrate(simplices, f))
+
+
+@pytest.mark.parametrize("degree", [1, 2, 3])
+def test_tensor_product_moments(degree):
+    simplices = cut_square(0.2, 0.5)
+    pts, wts = libtab.make_moment_fitted_quadrature(libtab.CellType.quadrilateral, degree, simplices)
+    assert len(wts) <= (degree + 1)**2
+    for i in range(degree + 1):
+        for j in range(degree + 1):
+            def f(x):
+                return x[:, 0]**i * x[:, 1]**j
+            assert np.isclose(sum(wts * f(pts)), integrate(simplices, f))
+
+
+def test_reuse():
+    fitting = libtab.MomentFitting(libtab.CellType.triangle, 3)
+    assert fitting.num_moments == 10
+    fitting.fit(cut_square(0.3, 0.4))
+    support = fitting.support
+    pts, wts = fitting.fit(cut_square(0.301, 0.399))
+    assert fitting.support == support
+    assert np.isclose(sum(wts), 0.3 + 0.5 * 0.399 + 0.001)
+
+
+def test_given_moments():
+    # Moments over the whole reference triangle, with lattice candidates
+    fitting = libtab.MomentFitting(libtab.CellType.triangle, 2)
+    triangle = libtab.geometry(libtab.CellType.triangle)
+    moments = fitting.moments([triangle])
+    candidates = libtab.create_lattice(libtab.CellType.triangle, 6, libtab.LatticeType.equispaced, True)
+    pts, wts = fitting.fit(moments, candidates)
+    assert len(wts) <= 6
+    assert np.isclose(sum(wts), 0.5)
+    assert np.isclose(sum(wts * pts[:, 0] * pts[:, 1]), 1 / 24)
+
+
+def test_infeasible():
+    fitting = libtab.MomentFitting(libtab.CellType.triangle, 2)
+    with pytest.raises(RuntimeError):
+        fitting.fit(np.ones(6), np.array([[0.2, 0.2], [0.3, 0.1]]))
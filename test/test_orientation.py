@@ -0,0 +1,90 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import itertools
+
+import libtab
+import numpy
+import pytest
+
+
+@pytest.mark.parametrize("cell, count", [("triangle", 6), ("tetrahedron", 24), ("prism", 720)])
+def test_realisable(cell, count):
+    celltype = getattr(libtab.CellType, cell)
+    orientations = libtab.realisable_orientations(celltype)
+    assert len(orientations) == count
+    nvertices = len(libtab.topology(celltype)[0])
+    for vertices in itertools.permutations(range(nvertices)):
+        assert libtab.compute_orientation(celltype, list(vertices)) in orientations
+
+
+def test_pack():
+    assert libtab.pack_orientation([True, False, True]) == 0b101
+    assert libtab.pack_orientation([False] * 6, [2, 0, 1, 0], [True, False, False, True]) == \
+        (0b110 << 6) | (0b001 << 12) | (0b100 << 15)
+    assert libtab.compute_orientation(libtab.CellType.tetrahedron, [0, 1, 2, 3]) == 0
+
+
+def oriented_points(element, bits):
+    """The points at which the oriented Lagrange basis functions are nodal,
+    found by moving the points of each reflected edge and of each rotated
+    or reflected face with the vertices of the sub-entity"""
+    topology = libtab.topology(element.cell_type)
+    geometry = numpy.array(libtab.geometry(element.cell_type))
+    points = numpy.array(element.points)
+    nedges = len(topology[1])
+    dof = len(topology[0])
+    for e, edge in enumerate(topology[1]):
+        n = element.entity_dofs[1][e]
+        if bits >> e & 1:
+            v = geometry[edge]
+            points[dof:dof + n] = v[0] + v[1] - points[dof:dof + n]
+        dof += n
+    for f, face in enumerate(topology[2] if len(topology) > 3 else []):
+        n = element.entity_dofs[2][f]
+        face_bits = bits >> (nedges + 3 * f)
+        rotations, reflection = face_bits & 3, face_bits >> 2 & 1
+        # A point with barycentric coordinates lam on the face moves to
+        # sum(lam[i] * v[perm[i]]): each rotation takes vertex i to vertex
+        # i - 1, and the reflection then swaps the images of vertices 1 and 2
+        perm = [(i - rotations) % 3 for i in range(3)]
+        if reflection:
+            perm[1], perm[2] = perm[2], perm[1]
+        v = geometry[face]
+        for k in range(dof, dof + n):
+            uv = numpy.linalg.lstsq(numpy.array([v[1] - v[0], v[2] - v[0]]).T, points[k] - v[0], rcond=None)[0]
+            lam = [1 - uv[0] - uv[1], uv[0], uv[1]]
+            points[k] = sum(lam[i] * v[perm[i]] for i in range(3))
+        dof += n
+    return points
+
+
+@pytest.mark.parametrize("cell", ["triangle", "tetrahedron"])
+def test_orientation_tables_lagrange(cell):
+    element = libtab.create_element("Lagrange", cell, 4)
+    for bits in libtab.realisable_orientations(element.cell_type):
+        tables = libtab.OrientationTables(element, 0, oriented_points(element, bits), [bits])
+        assert numpy.allclose(tables.tabulate(bits)[0], numpy.eye(element.dim))
+
+
+def test_orientation_tables_nedelec():
+    # The dof of each edge of the lowest degree Nedelec element changes
+    # sign when the edge is reflected
+    element = libtab.create_element("Nedelec 1st kind H(curl)", "tetrahedron", 1)
+    pts = libtab.create_lattice(element.cell_type, 3, libtab.LatticeType.equispaced, True)
+    tables = libtab.OrientationTables(element, 1, pts)
+    reference = element.tabulate(1, pts)
+    for bits in tables.orientations:
+        signs = numpy.array([-1.0 if bits >> e & 1 else 1.0 for e in range(6)])
+        assert numpy.allclose(tables.coefficients(bits), signs[:, None] * element.coefficients)
+        for ref, table in zip(reference, tables.tabulate(bits)):
+            assert numpy.allclose(table, ref * numpy.tile(signs, element.value_size))
+
+
+def test_orientation_tables_given():
+    element = libtab.create_element("Lagrange", "triangle", 3)
+    tables = libtab.OrientationTables(element, 0, numpy.zeros((0, 2)), [0, 7])
+    assert tables.orientations == [0, 7]
+    with pytest.raises(RuntimeError):
+        tables.coefficients(1)
@@ -127,3 +127,41 @@ def test_cell(cell_type, order):
     print(mat)
     fac = 2 ** pts.shape[0] / 2
     assert(np.isclose(mat * fac, np.eye(mat.shape[0])).all())
+
+
+@pytest.mark.parametrize("cell_type", [libtab.CellType.triangle,
+                                       libtab.CellType.tetrahedron,
+                                       libtab.CellType.pyramid,
+                                       libtab.CellType.hexahedron])
+@pytest.mark.parametrize("nderiv", [0, 1, 2, 3])
+def test_tabulate_by_order(cell_type, nderiv):
+    tdim = len(libtab.topology(cell_type)) - 1
+    pts = libtab.create_lattice(cell_type, 5, libtab.LatticeType.equispaced, True)
+    full = libtab.tabulate_polynomial_set(cell_type, 3, nderiv, pts)
+
+    result = [np.zeros_like(t) for t in full]
+    orders = []
+
+    def consumer(k, offset, tables):
+        first = {1: k, 2: k * (k + 1) // 2, 3: k * (k + 1) * (k + 2) // 6}[tdim]
+        for i, t in enumerate(tables):
+            result[first + i][offset:offset + t.shape[0], :] = t
+        orders.append(k)
+
+    libtab.tabulate_polynomial_set_by_order(cell_type, 3, nderiv, pts, 4, consumer)
+
+    nblocks = (pts.shape[0] + 3) // 4
+    assert orders == list(range(nderiv + 1)) * nblocks
+    for a, b in zip(result, full):
+        assert np.allclose(a, b)
+
+
+@pytest.mark.parametrize("cell_type", [libtab.CellType.triangle,
+                                       libtab.CellType.tetrahedron,
+                                       libtab.CellType.pyramid])
+def test_tabulate_threads(cell_type):
+    pts = libtab.create_lattice(cell_type, 2, libtab.LatticeType.equispaced, True)
+    serial = libtab.tabulate_polynomial_set(cell_type, 4, 4, pts)
+    threaded = libtab.tabulate_polynomial_set(cell_type, 4, 4, pts, nthreads=4)
+    for a, b in zip(serial, threaded):
+        assert np.allclose(a, b)
@@ -2,9 +2,11 @@
 # FEniCS Project
 # SPDX-License-Identifier: MIT
 
+import itertools
 import libtab
 import pytest
 import numpy as np
+from math import gamma
 
 
 @pytest.mark.parametrize("celltype", [(libtab.CellType.quadrilateral, 1.0),
@@ -81,3 +83,80 @@ def test_gll():
     print(pts, wts)
     assert np.isclose(sum(pts*wts), 0)
     assert np.isclose(sum(wts), 2)
+
+
+@pytest.mark.parametrize("a", [-0.5, 0.0, 1.0, 2.5])
+@pytest.mark.parametrize("b", [-0.5, 0.0, 0.7])
+@pytest.mark.parametrize("m", [1, 3, 6])
+def test_gauss_jacobi(a, b, m):
+    pts, wts = libtab.compute_gauss_jacobi_rule(a, b, m)
+    ref_pts, ref_wts = libtab.compute_gauss_jacobi_rule(a, b, 20)
+    for k in range(2 * m):
+        assert np.isclose(sum(wts * pts**k), sum(ref_wts * ref_pts**k))
+    # Integral of the weight is 2^(a+b+1) B(a+1, b+1)
+    assert np.isclose(sum(wts), 2**(a + b + 1) * gamma(a + 1) * gamma(b + 1) / gamma(a + b + 2))
+
+
+@pytest.mark.parametrize("left", [True, False])
+@pytest.mark.parametrize("m", [1, 2, 5])
+def test_gauss_radau(left, m):
+    pts, wts = libtab.compute_gauss_radau_rule(0.0, 1.0, m, left)
+    assert np.isclose(pts[0] if left else pts[-1], -1.0 if left else 1.0)
+    ref_pts, ref_wts = libtab.compute_gauss_jacobi_rule(0.0, 1.0, 20)
+    for k in range(2 * m - 1):
+        assert np.isclose(sum(wts * pts**k), sum(ref_wts * ref_pts**k))
+
+
+@pytest.mark.parametrize("celltype", [libtab.CellType.interval, libtab.CellType.quadrilateral,
+                                      libtab.CellType.hexahedron, libtab.CellType.triangle,
+                                      libtab.CellType.tetrahedron, libtab.CellType.prism])
+@pytest.mark.parametrize("qtype", [libtab.QuadratureType.gauss_jacobi, libtab.QuadratureType.gauss_radau_left,
+                                   libtab.QuadratureType.gauss_radau_right])
+def test_cell_rule_types(celltype, qtype):
+    pts, wts = libtab.make_quadrature(celltype, qtype, 4)
+    ref_pts, ref_wts = libtab.make_quadrature(celltype, 6)
+    for k in range(4):
+        f = pts[:, 0]**k * pts[:, -1]**2
+        ref_f = ref_pts[:, 0]**k * ref_pts[:, -1]**2
+        assert np.isclose(sum(wts * f), sum(ref_wts * ref_f))
+
+
+def test_weighted_quadrilateral():
+    # Integral of sqrt(x) (1 - y) y over the unit square
+    pts, wts = libtab.make_quadrature(libtab.CellType.quadrilateral, libtab.QuadratureType.gauss_jacobi, 2,
+                                      [[0.0, 0.5], [1.0, 0.0]])
+    assert np.isclose(sum(wts * pts[:, 1]), 2.0 / 3.0 / 6.0)
+    pts2, wts2 = libtab.make_quadrature(libtab.CellType.quadrilateral, libtab.QuadratureType.gauss_jacobi, 2,
+                                        [[0.0, 0.5], [1.0, 0.0]])
+    assert np.allclose(pts, pts2) and np.allclose(wts, wts2)
+    libtab.clear_quadrature_cache()
+
+
+@pytest.mark.parametrize("celltype", [libtab.CellType.quadrilateral, libtab.CellType.hexahedron,
+                                      libtab.CellType.triangle, libtab.CellType.prism])
+@pytest.mark.parametrize("degree", range(10))
+def test_reduced_quadrature(celltype, degree):
+    pts, wts = libtab.make_reduced_quadrature(celltype, degree)
+    ref_pts, ref_wts = libtab.make_quadrature(celltype, degree // 2 + 1)
+    assert len(wts) <= len(ref_wts)
+    assert min(wts) > 0
+    assert pts.min() >= -1e-14 and pts.max() <= 1 + 1e-14
+
+    # Compare all monomials of total degree up to degree
+    tdim = pts.shape[1]
+    for powers in itertools.product(range(degree + 1), repeat=tdim):
+        if sum(powers) <= degree:
+            f = np.prod(pts**powers, axis=1)
+            ref_f = np.prod(ref_pts**powers, axis=1)
+            assert np.isclose(sum(wts * f), sum(ref_wts * ref_f), atol=1e-14)
+
+
+@pytest.mark.parametrize("celltype, degree, npoints", [(libtab.CellType.quadrilateral, 5, 7),
+                                                       (libtab.CellType.quadrilateral, 7, 12),
+                                                       (libtab.CellType.hexahedron, 3, 6),
+                                                       (libtab.CellType.hexahedron, 5, 14),
+                                                       (libtab.CellType.hexahedron, 7, 34),
+                                                       (libtab.CellType.prism, 5, 21)])
+def test_reduced_quadrature_size(celltype, degree, npoints):
+    pts, wts = libtab.make_reduced_quadrature(celltype, degree)
+    assert len(wts) == npoints
@@ -4,6 +4,7 @@
 
 import libtab
 import numpy as np
+import pytest
 
 
 def test_regge_tri():
@@ -213,3 +214,55 @@ def test_regge_tet():
                      [-1.5,  0., -0.],
                      [-0., -0., -0.]]])
     assert(np.isclose(ref, w).all())
+
+
+@pytest.mark.parametrize("cell, tdim", [("triangle", 2), ("tetrahedron", 3)])
+@pytest.mark.parametrize("degree", [1, 2])
+def test_regge_compact(cell, tdim, degree):
+    regge = libtab.create_element("Regge", cell, degree)
+    assert regge.symmetric
+    assert regge.value_size == tdim * tdim
+    assert regge.stored_value_size == tdim * (tdim + 1) // 2
+    psize = libtab.tabulate_polynomial_set(regge.cell_type, degree, 0, [[0.0] * tdim])[0].shape[1]
+    assert regge.coefficients.shape == (regge.dim, regge.stored_value_size * psize)
+
+    pts = libtab.create_lattice(regge.cell_type, 3, libtab.LatticeType.equispaced, True)
+    full = regge.tabulate(1, pts)
+    compact = regge.tabulate_compact(1, pts)
+    n = regge.dim
+    for f, c in zip(full, compact):
+        assert c.shape == (pts.shape[0], regge.stored_value_size * n)
+        for i, j in enumerate(regge.value_map):
+            assert np.allclose(f[:, i * n:(i + 1) * n], c[:, j * n:(j + 1) * n])
+
+
+@pytest.mark.parametrize("cell, tdim", [("triangle", 2), ("tetrahedron", 3)])
+def test_symmetric_table_view(cell, tdim):
+    regge = libtab.create_element("Regge", cell, 1)
+    pts = libtab.create_lattice(regge.cell_type, 3, libtab.LatticeType.equispaced, True)
+    n = regge.dim
+    for full, compact in zip(regge.tabulate(1, pts), regge.tabulate_compact(1, pts)):
+        # Block i of the full table is block value_map[i] of the compact table
+        ref = np.hstack([compact[:, j * n:(j + 1) * n] for j in regge.value_map])
+        assert np.allclose(ref, full)
+
+        view = libtab.SymmetricTableView(compact, n, tdim)
+        assert np.allclose(view.expand(), ref)
+        for i in range(tdim):
+            for j in range(tdim):
+                block = ref[:, (i * tdim + j) * n:(i * tdim + j + 1) * n]
+                assert np.allclose(view.entry(i, j), block)
+                assert np.shares_memory(view.entry(i, j), compact)
+                assert np.isclose(view(2, 1, i, j), block[2, 1])
+
+    # The view holds the array it refers to, whatever its layout
+    view = libtab.SymmetricTableView(np.ascontiguousarray(compact), n, tdim)
+    assert np.allclose(view.expand(), ref)
+    assert np.allclose(view.entry(tdim - 1, 0), ref[:, (tdim - 1) * tdim * n:((tdim - 1) * tdim + 1) * n])
+
+    with pytest.raises(RuntimeError):
+        view.entry(tdim, 0)
+    with pytest.raises(RuntimeError):
+        view(pts.shape[0], 0, 0, 0)
+    with pytest.raises(RuntimeError):
+        libtab.SymmetricTableView(compact, n + 1, tdim)
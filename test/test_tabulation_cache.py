@@ -0,0 +1,82 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+@pytest.mark.parametrize("family", ["Lagrange", "Raviart-Thomas"])
+def test_cached_tables(family):
+    libtab.clear_tabulation_cache()
+    element = libtab.create_element(family, "triangle", 2)
+    pts = libtab.create_lattice(element.cell_type, 5, libtab.LatticeType.equispaced, True)
+
+    first = element.tabulate_cached(1, pts)
+    second = element.tabulate_cached(1, pts.copy())
+    assert libtab.tabulation_cache_misses() == 1
+    assert libtab.tabulation_cache_hits() == 1
+
+    for a, b, c in zip(element.tabulate(1, pts), first, second):
+        assert numpy.allclose(a, b)
+        assert numpy.shares_memory(b, c)
+        assert not b.flags.writeable
+
+
+def test_cache_keys():
+    libtab.clear_tabulation_cache()
+    p1 = libtab.create_element("Lagrange", "triangle", 1)
+    p2 = libtab.create_element("Lagrange", "triangle", 2)
+    pts = libtab.create_lattice(p1.cell_type, 3, libtab.LatticeType.equispaced, True)
+
+    p1.tabulate_cached(0, pts)
+    p2.tabulate_cached(0, pts)
+    p1.tabulate_cached(1, pts)
+    p1.tabulate_cached(0, pts[1:])
+    assert libtab.tabulation_cache_misses() == 4
+    assert libtab.tabulation_cache_hits() == 0
+
+
+def test_cache_capacity():
+    libtab.clear_tabulation_cache()
+    capacity = libtab.tabulation_cache_capacity()
+    element = libtab.create_element("Lagrange", "tetrahedron", 2)
+    pts = numpy.random.rand(100, 3) / 3
+    table_bytes = 100 * 10 * 8 + pts.nbytes
+
+    libtab.set_tabulation_cache_capacity(2 * table_bytes)
+    for i in range(3):
+        element.tabulate_cached(0, pts + i)
+    assert libtab.tabulation_cache_memory_usage() == 2 * table_bytes
+
+    # The oldest points have been discarded
+    element.tabulate_cached(0, pts)
+    assert libtab.tabulation_cache_misses() == 4
+
+    libtab.set_tabulation_cache_capacity(0)
+    assert libtab.tabulation_cache_memory_usage() == 0
+    libtab.set_tabulation_cache_capacity(capacity)
+
+
+@pytest.mark.parametrize("format", [libtab.CompressedTable.Format.float16, libtab.CompressedTable.Format.scaled_int16])
+def test_cached_compressed_tables(format):
+    libtab.clear_tabulation_cache()
+    element = libtab.create_element("Lagrange", "tetrahedron", 2)
+    pts = libtab.create_lattice(element.cell_type, 5, libtab.LatticeType.equispaced, True)
+
+    first = element.tabulate_cached_compressed(1, pts, format)
+    second = element.tabulate_cached_compressed(1, pts.copy(), format)
+    assert libtab.tabulation_cache_misses() == 1
+    assert libtab.tabulation_cache_hits() == 1
+    assert libtab.tabulation_cache_memory_usage() == pts.nbytes + sum(t.memory_usage for t in first)
+
+    # The tables in double precision are a separate entry
+    element.tabulate_cached(1, pts)
+    assert libtab.tabulation_cache_misses() == 2
+
+    u = numpy.random.rand(element.dim, 4)
+    for a, b, c in zip(element.tabulate(1, pts), first, second):
+        assert b.format == format
+        assert numpy.array_equal(b.expand(), c.expand())
+        assert numpy.abs(b.contract(u) - a @ u).max() <= 1e-3 * (numpy.abs(a) @ u).max()
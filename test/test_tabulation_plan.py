@@ -0,0 +1,132 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import os
+import pytest
+import subprocess
+import sys
+
+
+@pytest.mark.parametrize("family, cell, degree", [("Lagrange", "triangle", 3), ("Lagrange", "tetrahedron", 3),
+                                                  ("Nedelec 1st kind H(curl)", "tetrahedron", 2),
+                                                  ("Regge", "triangle", 1)])
+@pytest.mark.parametrize("block_size", [-1, 0, 7])
+@pytest.mark.parametrize("measure", [False, True])
+def test_plan(family, cell, degree, block_size, measure):
+    element = libtab.create_element(family, cell, degree)
+    pts = libtab.create_lattice(element.cell_type, 6, libtab.LatticeType.equispaced, True)
+    plan = libtab.TabulationPlan(element, pts.shape[0], 2, block_size=block_size, measure=measure)
+    assert plan.num_points == pts.shape[0]
+    if block_size == 0:
+        assert plan.engine == libtab.TabulationPlan.Engine.direct
+    elif block_size == 7:
+        assert plan.engine == libtab.TabulationPlan.Engine.blocked
+
+    for a, b in zip(element.tabulate(2, pts), plan.execute(pts)):
+        assert numpy.allclose(a, b)
+
+
+def test_plan_points():
+    element = libtab.create_element("Lagrange", "triangle", 2)
+    plan = libtab.TabulationPlan(element, 10, 0)
+    with pytest.raises(RuntimeError):
+        plan.execute(numpy.zeros((11, 2)))
+    with pytest.raises(RuntimeError):
+        plan.execute(numpy.zeros((10, 3)))
+    with pytest.raises(RuntimeError):
+        plan.execute_array(numpy.zeros((10, 3)))
+    with pytest.raises(RuntimeError):
+        plan.execute_array(numpy.zeros((10, 2)), coordinates=libtab.Coordinates.barycentric)
+    assert plan.execute_array(numpy.zeros((10, 2))).shape[0] == 1
+    with pytest.raises(RuntimeError):
+        plan.execute_array(numpy.zeros((0, 2)))
+
+    empty = libtab.TabulationPlan(element, 0, 1)
+    assert empty.execute_array(numpy.zeros((0, 2))).size == 0
+
+
+@pytest.mark.parametrize("layout", [["derivative", "component", "dof", "point"],
+                                    ["derivative", "point", "dof", "component"],
+                                    ["point", "derivative", "component", "dof"],
+                                    ["component", "dof", "point", "derivative"]])
+@pytest.mark.parametrize("order", ["C", "F"])
+def test_plan_layout(layout, order):
+    element = libtab.create_element("Nedelec 1st kind H(curl)", "tetrahedron", 2)
+    pts = numpy.asarray(libtab.create_lattice(element.cell_type, 4, libtab.LatticeType.equispaced, True), order=order)
+    axes = [getattr(libtab.TabulationPlan.Axis, a) for a in layout]
+    plan = libtab.TabulationPlan(element, pts.shape[0], 1, block_size=8, layout=axes)
+    values = plan.execute_array(pts)
+
+    # Reference values, with axes (derivative, point, dof, component)
+    tables = numpy.array(element.tabulate(1, pts))
+    ref = tables.reshape(tables.shape[0], pts.shape[0], element.value_size, element.dim).transpose(0, 1, 3, 2)
+    names = ["derivative", "point", "dof", "component"]
+    assert numpy.allclose(values, ref.transpose([names.index(a) for a in layout]))
+
+
+def test_plan_layout_invalid():
+    element = libtab.create_element("Lagrange", "triangle", 1)
+    Axis = libtab.TabulationPlan.Axis
+    with pytest.raises(RuntimeError):
+        libtab.TabulationPlan(element, 3, 0, layout=[Axis.point, Axis.point, Axis.dof, Axis.component])
+
+
+@pytest.mark.parametrize("policy", [libtab.NumaPolicy.first_touch, libtab.NumaPolicy.local,
+                                    libtab.NumaPolicy.interleave])
+@pytest.mark.parametrize("block_size", [0, 16])
+def test_plan_output(policy, block_size):
+    element = libtab.create_element("Lagrange", "tetrahedron", 2)
+    pts = libtab.create_lattice(element.cell_type, 8, libtab.LatticeType.equispaced, True)
+    plan = libtab.TabulationPlan(element, pts.shape[0], 1, nthreads=4, block_size=block_size)
+    ref = plan.execute_array(pts)
+
+    values = plan.execute_array(pts, policy=policy)
+    assert numpy.allclose(values, ref)
+
+    # Write into an array whose pages were touched by the threads
+    out = libtab.numa_empty(ref.shape, policy)
+    plan.first_touch(out)
+    assert numpy.all(out == 0.0)
+    assert plan.execute_array(pts, out=out) is out
+    assert numpy.allclose(out, ref)
+    page = libtab.page_size()
+    assert len(libtab.numa_page_nodes(out)) == (out.nbytes + page - 1) // page
+
+
+def test_plan_output_invalid():
+    element = libtab.create_element("Lagrange", "triangle", 1)
+    pts = libtab.create_lattice(element.cell_type, 2, libtab.LatticeType.equispaced, True)
+    plan = libtab.TabulationPlan(element, pts.shape[0], 0)
+    with pytest.raises(RuntimeError):
+        plan.execute_array(pts, out=numpy.zeros(plan.num_points + 1))
+    with pytest.raises(RuntimeError):
+        plan.execute_array(pts, out=numpy.zeros((3, 6), order="F")[:, :3])
+
+
+@pytest.mark.parametrize("policy", [libtab.HugePagePolicy.none, libtab.HugePagePolicy.transparent,
+                                    libtab.HugePagePolicy.hugetlb])
+def test_plan_huge_pages(policy):
+    element = libtab.create_element("Lagrange", "tetrahedron", 3)
+    pts = numpy.random.rand(20000, 3) / 3
+    plan = libtab.TabulationPlan(element, pts.shape[0], 1)
+    ref = plan.execute_array(pts)
+
+    # Large enough for huge pages
+    previous = libtab.get_huge_page_policy()
+    libtab.set_huge_page_policy(policy)
+    try:
+        assert libtab.get_huge_page_policy() == policy
+        assert numpy.allclose(plan.execute_array(pts), ref)
+        assert numpy.allclose(plan.execute(pts), element.tabulate(1, pts))
+    finally:
+        libtab.set_huge_page_policy(previous)
+
+
+@pytest.mark.parametrize("value, valid", [("transparent", True), ("invalid", False)])
+def test_huge_pages_environment(value, valid):
+    env = dict(os.environ, LIBTAB_HUGE_PAGES=value)
+    result = subprocess.run([sys.executable, "-W", "error::RuntimeWarning", "-c", "import libtab"], env=env)
+    assert (result.returncode == 0) == valid
@@ -0,0 +1,46 @@
+# Copyright (c) 2020 Chris Richardson
+# FEniCS Project
+# SPDX-License-Identifier: MIT
+
+import libtab
+import numpy
+import pytest
+
+
+def dense(tensor):
+    i, j, k, values = tensor.coo()
+    result = numpy.zeros(tensor.shape)
+    result[i, j, k] = values
+    return result
+
+
+@pytest.mark.parametrize("celltype", [libtab.CellType.interval, libtab.CellType.triangle,
+                                      libtab.CellType.tetrahedron, libtab.CellType.quadrilateral])
+@pytest.mark.parametrize("degrees", [(1, 1, 1), (2, 1, 3), (3, 3, 2)])
+def test_element_triple_product(celltype, degrees):
+    elements = [libtab.create_element("Lagrange", celltype.name, d) for d in degrees]
+    tensor = libtab.triple_product_element(*elements)
+    assert tensor.shape == [e.dim for e in elements]
+    assert len(tensor.offsets) == tensor.shape[0] + 1
+
+    pts, wts = libtab.make_quadrature(celltype, sum(degrees) // 2 + 2)
+    a, b, c = [e.tabulate(0, pts)[0] for e in elements]
+    assert numpy.allclose(dense(tensor), numpy.einsum("q,qi,qj,qk->ijk", wts, a, b, c))
+
+
+def test_polyset_triple_product_sparse():
+    tensor = libtab.triple_product_polyset(libtab.CellType.tetrahedron, 3, 3, 3)
+    assert tensor.nnz < 0.2 * numpy.prod(tensor.shape)
+
+    # The constant member of the expansion set is orthogonal to the others
+    p0 = libtab.tabulate_polynomial_set(libtab.CellType.tetrahedron, 0, 0, [[0, 0, 0]])[0][0, 0]
+    assert numpy.allclose(dense(tensor)[0], p0 / 8 * numpy.eye(tensor.shape[1]))
+
+
+def test_contract():
+    element = libtab.create_element("Lagrange", "triangle", 2)
+    tensor = libtab.triple_product_element(element, element, element)
+    u = numpy.random.rand(7, element.dim)
+    v = numpy.random.rand(7, element.dim)
+    r = libtab.contract_triple_product(tensor, u, v)
+    assert numpy.allclose(r, numpy.einsum("ijk,cj,ck->ci", dense(tensor), u, v))